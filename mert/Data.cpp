@@ -7,6 +7,8 @@
  */
 
 #include <fstream>
+#include <cstring>
+#include <stdint.h>
 #include "Scorer.h"
 #include "Data.h"
 #include "Util.h"
@@ -23,8 +25,96 @@ theScorer(&ptr)
   scoredata=new ScoreData(*theScorer);
 };
 
+// first bytes of a binary n-best list, as written by moses with -binary-n-best-list
+static const char NBEST_BINARY_MAGIC[8] = { 'M', 'O', 'S', 'E', 'S', 'N', 'B', '\0' };
+static const unsigned int NBEST_BINARY_VERSION = 1;
+
+bool Data::isbinarynbest(const std::string &file)
+{
+	inputfilestream inp(file);
+	if (!inp.good())
+		return false;
+	char magic[sizeof(NBEST_BINARY_MAGIC)];
+	inp.read(magic, sizeof(magic));
+	return inp.gcount() == sizeof(magic) && memcmp(magic, NBEST_BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+template<typename T>
+static bool readbinary(std::istream &inp, T &value)
+{
+	inp.read(reinterpret_cast<char*>(&value), sizeof(T));
+	return inp.gcount() == sizeof(T);
+}
+
+/* binary n-best list: magic, version, number of features, feature names,
+ * then per entry: sentence id, length and text of the hypothesis,
+ * the feature scores and the total score
+ */
+void Data::loadbinarynbest(const std::string &file)
+{
+	TRACE_ERR("loading binary nbest from " << file << std::endl);  
+
+	FeatureStats featentry;
+	ScoreStats scoreentry;
+
+	inputfilestream inp(file);
+	if (!inp.good())
+		throw runtime_error("Unable to open: " + file);
+
+	char magic[sizeof(NBEST_BINARY_MAGIC)];
+	inp.read(magic, sizeof(magic));
+	uint32_t version, numFeatures, length;
+	if (!readbinary(inp, version) || version != NBEST_BINARY_VERSION)
+		throw runtime_error("Unknown binary n-best list version in: " + file);
+	if (!readbinary(inp, numFeatures) || !readbinary(inp, length))
+		throw runtime_error("Truncated binary n-best list: " + file);
+
+	std::string features(length, ' ');
+	if (length > 0)
+		inp.read(&features[0], length);
+	if (!existsFeatureNames())
+		featdata->setFeatureMap(features + " ");
+	else if (featdata->NumberOfFeatures() != numFeatures)
+		throw runtime_error("Number of features in " + file + " does not match");
+
+	// same sentence index and hypothesis text as the text format gives
+	std::string sentence_index, theSentence;
+	std::vector<float> scores(numFeatures + 1);
+	uint32_t id;
+	while (readbinary(inp, id)){
+		if (!readbinary(inp, length))
+			throw runtime_error("Truncated binary n-best list: " + file);
+		sentence_index = stringify(id) + " ";
+		theSentence.assign(1, ' ');
+		theSentence.resize(length + 1);
+		if (length > 0)
+			inp.read(&theSentence[1], length);
+		inp.read(reinterpret_cast<char*>(&scores[0]), scores.size() * sizeof(float));
+		if (inp.gcount() != (std::streamsize) (scores.size() * sizeof(float)))
+			throw runtime_error("Truncated binary n-best list: " + file);
+
+		featentry.reset();
+		scoreentry.clear();
+
+		theScorer->prepareStats(sentence_index, theSentence, scoreentry);
+		scoredata->add(scoreentry, sentence_index);
+
+		// the last score is the total, which is not a feature
+		for (size_t i = 0; i < numFeatures; i++)
+			featentry.add(scores[i]);
+		featdata->add(featentry,sentence_index);
+	}
+	
+	inp.close();
+}
+
 void Data::loadnbest(const std::string &file)
 {
+	if (isbinarynbest(file)){
+		loadbinarynbest(file);
+		return;
+	}
+
 	TRACE_ERR("loading nbest from " << file << std::endl);  
 
 	FeatureStats featentry;
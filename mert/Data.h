@@ -48,6 +48,8 @@ public:
 	inline void Features(const std::string f){ featdata->Features(f); }
 
 	void loadnbest(const std::string &file);
+	void loadbinarynbest(const std::string &file);
+	static bool isbinarynbest(const std::string &file);
 
   void load(const std::string &featfile,const std::string &scorefile){
 		featdata->load(featfile);
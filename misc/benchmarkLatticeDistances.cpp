@@ -0,0 +1,111 @@
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FloydWarshall.h"
+#include "LatticeDistances.h"
+
+using namespace Moses;
+
+void printHelp(){
+  std::cerr << "Usage:\n"
+	"options: \n"
+	"\t-nodes  int -- number of lattice nodes, default 5000\n"
+	"\t-arcs   int -- longest arc, in nodes, default 5\n"
+	"\t-window int -- distortion window of the queries, default 6\n"
+	"\t-seed   int -- random seed, default 1\n"
+	"\t-nocheck    -- don't run floyd_warshall, only time the shortest paths on demand\n"
+	"Builds a random lattice, asks for the distances a search with the given window would,\n"
+	"and compares time and results with floyd_warshall on the whole edge matrix\n"
+	"\n";
+}
+
+double seconds(clock_t start){
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv){
+  std::cerr << "benchmarkLatticeDistances\n";
+  size_t numNodes = 5000, maxArc = 5, window = 6;
+  unsigned int seed = 1;
+  bool check = true;
+  for(int i = 1; i < argc; ++i){
+    std::string arg(argv[i]);
+    if("-nodes" == arg && i+1 < argc){
+      numNodes = atoi(argv[++i]);
+    } else if("-arcs" == arg && i+1 < argc){
+      maxArc = atoi(argv[++i]);
+    } else if("-window" == arg && i+1 < argc){
+      window = atoi(argv[++i]);
+    } else if("-seed" == arg && i+1 < argc){
+      seed = atoi(argv[++i]);
+    } else if("-nocheck" == arg){
+      check = false;
+    } else {
+      //somethings wrong... print help
+	  printHelp();
+      return 1;
+    }
+  }
+  if(numNodes < 2 || maxArc < 1){
+	printHelp();
+	return 1;
+  }
+
+  // every node has an arc to the next one, and some longer arcs, as in a lattice from a word graph
+  srand(seed);
+  std::vector<std::vector<size_t> > arcs(numNodes);
+  size_t numArcs = 0;
+  for(size_t i = 0; i + 1 < numNodes; ++i){
+    arcs[i].push_back(i + 1);
+    for(size_t len = 2; len <= maxArc && i + len < numNodes; ++len){
+      if(rand() % 3 == 0)
+        arcs[i].push_back(i + len);
+    }
+    numArcs += arcs[i].size();
+  }
+  std::cerr << numNodes << " nodes, " << numArcs << " arcs\n";
+
+  // the distances asked for by a search: from each node to the nodes within the window
+  clock_t start = clock();
+  LatticeDistances distances;
+  distances.Init(numNodes);
+  for(size_t i = 0; i < numNodes; ++i)
+    for(size_t j = 0; j < arcs[i].size(); ++j)
+      distances.AddEdge(i, arcs[i][j]);
+  long sum = 0;
+  for(size_t i = 0; i < numNodes; ++i)
+    for(size_t j = i + 1; j < numNodes && j <= i + window; ++j)
+      sum += distances.GetDistance(i, j);
+  std::cerr << "on demand, window queries: " << seconds(start) << " s\n";
+
+  if(!check)
+    return 0;
+
+  start = clock();
+  std::vector<std::vector<bool> > edges(numNodes, std::vector<bool>(numNodes, false));
+  for(size_t i = 0; i < numNodes; ++i)
+    for(size_t j = 0; j < arcs[i].size(); ++j)
+      edges[i][arcs[i][j]] = true;
+  std::vector<std::vector<int> > matrix;
+  floyd_warshall(edges, matrix);
+  std::cerr << "floyd_warshall: " << seconds(start) << " s\n";
+
+  // all pairs, as the verbose output of WordLattice prints them
+  start = clock();
+  size_t numDiff = 0;
+  for(size_t i = 0; i < numNodes; ++i){
+    for(size_t j = 0; j < numNodes; ++j){
+      if(distances.GetDistance(i, j) != matrix[i][j]){
+        if(numDiff++ < 10)
+          std::cerr << "distance from " << i << " to " << j << ": " << distances.GetDistance(i, j)
+                    << ", floyd_warshall " << matrix[i][j] << "\n";
+      }
+    }
+  }
+  std::cerr << "on demand, all pairs: " << seconds(start) << " s\n";
+  std::cerr << numDiff << " differences\n";
+  return numDiff == 0 ? 0 : 1;
+}
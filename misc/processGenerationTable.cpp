@@ -0,0 +1,59 @@
+#include <iostream>
+#include <string>
+
+#include "InputFileStream.h"
+#include "GenerationDictionaryBinary.h"
+
+using namespace Moses;
+
+void printHelp(){
+  std::cerr << "Usage:\n"
+	"options: \n"
+	"\t-in  string -- input generation table file name\n"
+	"\t-out string -- prefix of binary table file, normally the input file name\n"
+	"If -in is not specified reads from stdin\n"
+	"Moses uses the binary table <prefix>.bingen in place of the generation table <prefix>\n"
+	"\n"; 
+}
+
+int main(int argc, char** argv){
+  std::cerr << "processGenerationTable\n";
+  std::string inFilePath;
+  std::string outFilePath;
+  if(1 >= argc){
+	printHelp();
+	return 1;
+  }
+  for(int i = 1; i < argc; ++i){
+    std::string arg(argv[i]);
+    if("-in" == arg && i+1 < argc){
+      ++i;
+      inFilePath = argv[i];
+    } else if("-out" == arg && i+1 < argc){
+      ++i;
+      outFilePath = argv[i];
+    } else {
+      //somethings wrong... print help
+	  printHelp();
+      return 1;
+    }
+  }
+  if(outFilePath.empty()){
+    if(inFilePath.empty()){
+	  printHelp();
+      return 1;
+    }
+    outFilePath = inFilePath;
+  }
+  
+  bool ok;
+  if(inFilePath.empty()){
+	std::cerr << "processing stdin to " << outFilePath << ".bingen\n";
+	ok = GenerationDictionaryBinary::Create(std::cin, outFilePath);
+  } else {
+	std::cerr << "processing " << inFilePath << " to " << outFilePath << ".bingen\n";
+    InputFileStream file(inFilePath);
+    ok = GenerationDictionaryBinary::Create(file, outFilePath);
+  }
+  return ok ? 0 : 1;
+}
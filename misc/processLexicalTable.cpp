@@ -1,9 +1,11 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 #include "Timer.h"
 #include "InputFileStream.h"
 #include "LexicalReorderingTable.h"
+#include "LexicalReorderingTableBinary.h"
 
 using namespace Moses;
 
@@ -14,6 +16,8 @@ void printHelp(){
 	"options: \n"
 	"\t-in  string -- input table file name\n"
 	"\t-out string -- prefix of binary table files\n"
+	"\t-quantize int -- write a memory mapped table <prefix>.binlexq instead,\n"
+	"\t                with scores quantized to 8 or 16 bits. Not for tables conditioned on context\n"
 	"If -in is not specified reads from stdin\n"
 	"\n"; 
 }
@@ -22,6 +26,7 @@ int main(int argc, char** argv){
   std::cerr << "processLexicalTable v0.1 by Konrad Rawlik\n";
   std::string inFilePath;
   std::string outFilePath("out");
+  size_t bits = 0;
   if(1 >= argc){
 	printHelp();
 	return 1;
@@ -34,6 +39,9 @@ int main(int argc, char** argv){
     } else if("-out" == arg && i+1 < argc){
       ++i;
       outFilePath = argv[i];
+    } else if("-quantize" == arg && i+1 < argc){
+      ++i;
+      bits = atoi(argv[i]);
     } else {
       //somethings wrong... print help
 	  printHelp();
@@ -41,6 +49,18 @@ int main(int argc, char** argv){
     }
   }
   
+  if(bits > 0){
+    bool ok;
+    if(inFilePath.empty()){
+      std::cerr << "processing stdin to " << outFilePath << ".binlexq\n";
+      ok = LexicalReorderingTableBinary::Create(std::cin, outFilePath, bits);
+    } else {
+      std::cerr << "processing " << inFilePath << " to " << outFilePath << ".binlexq\n";
+      InputFileStream file(inFilePath);
+      ok = LexicalReorderingTableBinary::Create(file, outFilePath, bits);
+    }
+    return ok ? 0 : 1;
+  }
   if(inFilePath.empty()){
 	std::cerr << "processing stdin to " << outFilePath << ".*\n";
 	return LexicalReorderingTableTree::Create(std::cin, outFilePath);
@@ -40,6 +40,8 @@ inline bool existsFile(const std::string& filename) {
 int main(int argc,char **argv) {
 	std::string fto;size_t noScoreComponent=5;int cn=0;
 	bool aligninfo=false;
+	size_t bloomBits=0;
+	std::string reorderingTable;
 	std::vector<std::pair<std::string,std::pair<char*,char*> > > ftts;
 	int verb=0;
 	for(int i=1;i<argc;++i) {
@@ -55,6 +57,8 @@ int main(int argc,char **argv) {
 		else if(s=="-cn") cn=1;
 		else if(s=="-irst") cn=2;
 		else if(s=="-alignment-info") aligninfo=true;
+		else if(s=="-bloom-bits") bloomBits=atoi(argv[++i]);
+		else if(s=="-reordering") reorderingTable=argv[++i];
 		else if(s=="-v") verb=atoi(argv[++i]);
 		else if(s=="-h") 
 			{
@@ -64,6 +68,10 @@ int main(int argc,char **argv) {
 					"\t-out string      -- output file name prefix for binary ttable\n"
 					"\t-nscores int     -- number of scores in ttable\n"
 					"\t-alignment-info  -- include alignment info in the binary ttable (suffix \".wa\")\n"
+					"\t-bloom-bits int  -- bits per source phrase of a bloom filter for the binary ttable (suffix \".bloom\"), 0 for none\n"
+					"\t-reordering string -- lexical reordering table (f ||| e ||| scores) whose scores are stored\n"
+					"\t                    with the phrase pairs. Both tables have to be sorted with LC_ALL=C sort.\n"
+					"\t                    Use the binary ttable as file of the reordering model (distortion-file)\n"
 			"\nfunctions:\n"
 					"\t - convert ascii ttable in binary format\n"
 					"\t - if ttable is not read from stdin:\n"
@@ -86,6 +94,12 @@ int main(int argc,char **argv) {
 			PhraseDictionaryTree pdt(noScoreComponent);
 			
 			pdt.PrintWordAlignment(aligninfo);
+			pdt.SetBloomFilterBits(bloomBits);
+			InputFileStream *reordering=0;
+			if(!reorderingTable.empty()) {
+				reordering=new InputFileStream(reorderingTable);
+				pdt.SetReorderingTable(reordering);
+			}
 
 			if (ftts[0].first=="-") {
 				std::cerr<< "stdin\n";
@@ -96,6 +110,7 @@ int main(int argc,char **argv) {
 				InputFileStream in(ftts[0].first);
 				pdt.Create(in,fto);
 			}
+			delete reordering;
 		}
 		else 
 				{
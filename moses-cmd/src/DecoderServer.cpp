@@ -0,0 +1,289 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#include <sstream>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "DecoderServer.h"
+#include "Socket.h"
+#include "IOWrapper.h"
+#include "NBestFormatter.h"
+#include "Manager.h"
+#include "Sentence.h"
+#include "TrellisPathList.h"
+#include "Timer.h"
+#include "Util.h"
+#include "mbr.h"
+
+using namespace std;
+using namespace Moses;
+
+#ifdef WITH_THREADS
+
+//! serves 1 client connection on its own thread
+class ConnectionHandler : public Moses::Thread
+{
+protected:
+	DecoderServer &m_server;
+	int m_socket;
+	volatile bool m_finished;
+
+public:
+	ConnectionHandler(DecoderServer &server, int socket)
+	:m_server(server)
+	,m_socket(socket)
+	,m_finished(false)
+	{}
+
+	void Run()
+	{
+		m_server.Serve(m_socket);
+		MemoryFence();
+		m_finished = true;
+	}
+	bool IsFinished() const
+	{
+		return m_finished;
+	}
+};
+
+#else
+
+class ConnectionHandler
+{
+public:
+	bool IsFinished() const
+	{
+		return true;
+	}
+};
+
+#endif
+
+DecoderServer::DecoderServer(const StaticData &staticData, const string &address)
+:m_staticData(staticData)
+,m_address(address)
+,m_listenSocket(-1)
+,m_translationId(0)
+,m_defaultWeights(staticData.GetAllWeights())
+,m_nBestFormatter(new NBestFormatter(staticData, staticData.GetOutputFactorOrder(), false))
+{}
+
+DecoderServer::~DecoderServer()
+{
+	ReapConnections(true);
+	if (m_listenSocket >= 0)
+		close(m_listenSocket);
+	delete m_nBestFormatter;
+}
+
+bool DecoderServer::Run()
+{
+	if (m_staticData.GetInputType() != SentenceInput)
+	{
+		UserMessage::Add("ERROR: server mode only translates sentences, not confusion networks or lattices");
+		return false;
+	}
+
+	m_listenSocket = ListenSocket(m_address);
+	if (m_listenSocket < 0)
+	{
+		UserMessage::Add("ERROR: could not listen on " + m_address);
+		return false;
+	}
+
+	// a client closing its connection early must not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	VERBOSE(1, "Listening on " << m_address << endl);
+	while (true)
+	{
+		int socket = accept(m_listenSocket, NULL, NULL);
+		if (socket < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			TRACE_ERR("ERROR: accept on " << m_address << ": " << strerror(errno) << endl);
+			return false;
+		}
+		VERBOSE(2, "Connection accepted" << endl);
+
+		ReapConnections(false);
+#ifdef WITH_THREADS
+		ConnectionHandler *connection = new ConnectionHandler(*this, socket);
+		if (connection->Start())
+		{
+			m_connections.push_back(connection);
+			continue;
+		}
+		TRACE_ERR("WARNING: could not start connection thread, serving connection on the listening thread" << endl);
+		delete connection;
+#endif
+		Serve(socket);
+	}
+}
+
+#ifdef WITH_THREADS
+void DecoderServer::ReapConnections(bool wait)
+#else
+void DecoderServer::ReapConnections(bool /*wait*/)
+#endif
+{
+#ifdef WITH_THREADS
+	list<ConnectionHandler*>::iterator iter = m_connections.begin();
+	while (iter != m_connections.end())
+	{
+		if (wait || (*iter)->IsFinished())
+		{
+			(*iter)->Join();
+			delete *iter;
+			iter = m_connections.erase(iter);
+		}
+		else
+			++iter;
+	}
+#endif
+}
+
+void DecoderServer::Serve(int socket)
+{
+	LineSocket connection(socket);
+	string request;
+	while (connection.ReadLine(request))
+	{
+		if (!connection.Write(Translate(request)))
+			break;
+	}
+	VERBOSE(2, "Connection closed" << endl);
+}
+
+string DecoderServer::Translate(const string &request)
+{
+	// options before the sentence. The first part which isn't an option starts the sentence, which may contain " ||| " itself
+	string text = request;
+	size_t nBestSize = 0;
+	bool hasWeights = false;
+	vector<float> weights;
+	size_t separator;
+	while ((separator = text.find(" ||| ")) != string::npos)
+	{
+		const string option = Trim(text.substr(0, separator));
+		if (option.compare(0, 7, "n-best=") != 0 && option.compare(0, 8, "weights=") != 0)
+			break;
+		text.erase(0, separator + 5);
+		if (option.compare(0, 7, "n-best=") == 0)
+		{
+			nBestSize = Scan<size_t>(option.substr(7));
+			if (nBestSize > m_staticData.GetNBestSize())
+			{
+				VERBOSE(1, "n-best list size " << nBestSize << " reduced to " << m_staticData.GetNBestSize()
+								<< ", the size given with -n-best-list" << endl);
+				nBestSize = m_staticData.GetNBestSize();
+			}
+		}
+		else
+		{
+			hasWeights = true;
+			weights = Tokenize<float>(option.substr(8));
+		}
+	}
+	if (hasWeights && weights.size() != m_defaultWeights.size())
+	{
+		ostringstream error;
+		error << "ERROR: got " << weights.size() << " weights, but there are " << m_defaultWeights.size() << " score components\n";
+		VERBOSE(1, error.str());
+		return error.str();
+	}
+
+	// the decoder isn't reentrant
+	ScopedLock lock(m_decoderLock);
+
+	// weights only change, with what depends on them, if this request asks for other weights than the last
+	StaticData::SetAllWeightsStatic(hasWeights ? weights : m_defaultWeights);
+
+	IFVERBOSE(1)
+		ResetUserTime();
+
+	Sentence source(Input);
+	istringstream in(text + "\n");
+	source.Read(in, m_staticData.GetInputFactorOrder());
+	if (source.GetTranslationId() == 0)
+		source.SetTranslationId(m_translationId++);
+	VERBOSE(2,"\nTRANSLATING(" << source.GetTranslationId() << "): " << static_cast<const InputType&>(source));
+
+	Manager manager(source, m_staticData.GetSearchAlgorithm());
+	manager.ProcessSentence();
+
+	ostringstream out;
+	const vector<FactorType> &outputFactorOrder = m_staticData.GetOutputFactorOrder();
+	if (!m_staticData.UseMBR())
+	{
+		const Hypothesis *hypo = manager.GetBestHypothesis();
+		if (hypo != NULL) {
+			VERBOSE(1, "BEST TRANSLATION: " << *hypo << endl);
+		} else {
+			VERBOSE(1, "NO BEST TRANSLATION" << endl);
+		}
+		OutputSurface(out, hypo, outputFactorOrder
+									, m_staticData.GetReportSegmentation(), m_staticData.GetReportAllFactors());
+	}
+	else
+	{
+		TrellisPathList nBestList;
+		manager.CalcNBest(m_staticData.GetMBRSize(), nBestList, true);
+		vector<const Factor*> mbrBestHypo = doMBR(nBestList);
+		for (size_t i = 0 ; i < mbrBestHypo.size() ; i++)
+		{
+			if (i > 0)
+				out << " ";
+			out << mbrBestHypo[i]->GetString();
+		}
+	}
+	out << "\n";
+
+	if (nBestSize > 0)
+	{
+		TrellisPathList nBestList;
+		manager.CalcNBest(nBestSize, nBestList, m_staticData.GetDistinctNBest());
+		m_nBestFormatter->Write(out, nBestList, source.GetTranslationId());
+		out << "\n";
+	}
+
+	IFVERBOSE(2) { PrintUserTime("Sentence Decoding Time:"); }
+	manager.CalcDecoderStatistics();
+
+	return out.str();
+}
@@ -0,0 +1,93 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <list>
+#include "StaticData.h"
+#include "Thread.h"
+
+class NBestFormatter;
+class ConnectionHandler;
+
+/** keeps the models loaded and translates sentences sent to a socket.
+ *
+ * The protocol is line based. A request is one input sentence, in the
+ * same format as on stdin, including XML markup if -xml-input is set.
+ * Request options go before the sentence, separated by " ||| ",
+ * eg. "n-best=10 ||| das ist ein haus". Options are read up to the first
+ * part which is neither "n-best=" nor "weights=". "weights=W1 W2 ..."
+ * decodes the request with a complete weight vector of its own, in the
+ * order of the configuration; requests without it use the configured
+ * weights.
+ *
+ * The answer is the translation on one line. If an n-best list was asked
+ * for, the translation is followed by the n-best list in the usual n-best
+ * file format and an empty line. The n-best list size of the configuration
+ * is the largest a request can get. A request that can't be decoded, eg.
+ * because it has the wrong number of weights, is answered with one line
+ * starting with "ERROR: ".
+ *
+ * Each connection is served by its own thread, but only reading requests
+ * and writing answers happen in parallel: m_decoderLock serializes all
+ * decoding, across connections, because the decoder keeps per-sentence
+ * state and the weights in StaticData. More connections don't translate
+ * faster; run several servers for that.
+ */
+class DecoderServer
+{
+	friend class ConnectionHandler;
+
+protected:
+	const Moses::StaticData &m_staticData;
+	std::string m_address;
+	int m_listenSocket;
+	long m_translationId;
+	std::vector<float> m_defaultWeights; //! from the configuration
+	NBestFormatter *m_nBestFormatter;
+	Moses::Mutex m_decoderLock; //! held while a sentence is decoded and its output formatted
+	std::list<ConnectionHandler*> m_connections;
+
+	//! answer requests on a connected socket until the client closes it
+	void Serve(int socket);
+	std::string Translate(const std::string &request);
+	//! join and delete connection threads that have finished
+	void ReapConnections(bool wait);
+
+public:
+	DecoderServer(const Moses::StaticData &staticData, const std::string &address);
+	~DecoderServer();
+
+	//! listen and serve connections. Only returns if the socket can't be opened or accept fails
+	bool Run();
+};
@@ -36,16 +36,178 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "TypeDef.h"
 #include "Util.h"
 #include "IOWrapper.h"
+#include "NBestFormatter.h"
 #include "Hypothesis.h"
 #include "WordsRange.h"
 #include "TrellisPathList.h"
 #include "StaticData.h"
 #include "DummyScoreProducers.h"
 #include "InputFileStream.h"
+#include "Sentence.h"
+#include "ConfusionNet.h"
+#include "WordLattice.h"
+#include "Thread.h"
 
 using namespace std;
 using namespace Moses;
 
+//! number of sentences the input reader and output writer may run ahead of / behind decoding
+const size_t ASYNC_IO_QUEUE_SIZE = 100;
+
+InputType *CreateInput(InputTypeEnum inputType)
+{
+	switch(inputType)
+	{
+		case SentenceInput:         return new Sentence(Input);
+		case ConfusionNetworkInput: return new ConfusionNet;
+		case WordLatticeInput:      return new WordLattice;
+		default: TRACE_ERR("Unknown input type: " << inputType << "\n");
+	}
+	return NULL;
+}
+
+#ifdef WITH_THREADS
+
+/** reads and parses the input on its own thread, ahead of the decoder.
+ * The end of the input is signalled by a NULL entry in the queue
+ */
+class InputReader : public Moses::Thread
+{
+protected:
+	IOWrapper &m_ioWrapper;
+	InputTypeEnum m_inputType;
+	BoundedQueue<InputType*> m_queue;
+	bool m_eof; //! only accessed by the consumer
+
+public:
+	InputReader(IOWrapper &ioWrapper, InputTypeEnum inputType)
+	:m_ioWrapper(ioWrapper)
+	,m_inputType(inputType)
+	,m_queue(ASYNC_IO_QUEUE_SIZE)
+	,m_eof(false)
+	{}
+	~InputReader()
+	{
+		// consume anything still queued so that the reader can finish
+		InputType *source;
+		while ((source = Pop()) != NULL)
+			delete source;
+		Join();
+	}
+
+	void Run()
+	{
+		InputType *source;
+		do
+		{
+			source = CreateInput(m_inputType);
+			if (source != NULL)
+				source = m_ioWrapper.GetInput(source);
+			m_queue.Push(source);
+		} while (source != NULL);
+	}
+
+	InputType *Pop()
+	{
+		if (m_eof || !IsRunning())
+			return NULL;
+		InputType *source = m_queue.Pop();
+		m_eof = (source == NULL);
+		return source;
+	}
+};
+
+/** writes formatted output on its own thread, in the order it was handed over.
+ * A NULL stream tells the writer to finish
+ */
+class OutputWriter : public Moses::Thread
+{
+protected:
+	typedef std::pair<std::ostream*, std::string*> Item;
+	BoundedQueue<Item> m_queue;
+
+public:
+	OutputWriter()
+	:m_queue(ASYNC_IO_QUEUE_SIZE)
+	{}
+	~OutputWriter()
+	{
+		if (IsRunning())
+			m_queue.Push(Item((std::ostream*) NULL, (std::string*) NULL));
+		Join();
+	}
+
+	void Run()
+	{
+		while (true)
+		{
+			Item item = m_queue.Pop();
+			if (item.first == NULL)
+				break;
+			*item.first << *item.second << flush;
+			delete item.second;
+		}
+	}
+
+	//! takes ownership of text
+	void Write(std::ostream &out, std::string *text)
+	{
+		m_queue.Push(Item(&out, text));
+	}
+};
+
+#else
+
+// stubs, async-io needs --enable-threads
+class InputReader
+{
+public:
+	InputType *Pop() { return NULL; }
+};
+
+class OutputWriter
+{
+public:
+	void Write(std::ostream &out, std::string *text)
+	{
+		out << *text << flush;
+		delete text;
+	}
+};
+
+#endif
+
+/** stream to format the output of one sentence into.
+ * With an output writer the text is buffered and handed to the writer when done,
+ * otherwise it goes straight to the destination stream
+ */
+class OutputBuffer
+{
+protected:
+	std::ostream &m_out;
+	OutputWriter *m_outputWriter;
+	std::ostringstream m_buffer;
+
+public:
+	OutputBuffer(std::ostream &out, OutputWriter *outputWriter)
+	:m_out(out)
+	,m_outputWriter(outputWriter)
+	{
+		if (m_outputWriter != NULL)
+			m_buffer.copyfmt(m_out); // same float format as the real stream
+	}
+	~OutputBuffer()
+	{
+		if (m_outputWriter != NULL)
+			m_outputWriter->Write(m_out, new std::string(m_buffer.str()));
+	}
+
+	std::ostream &GetStream()
+	{
+		return (m_outputWriter != NULL) ? m_buffer : m_out;
+	}
+};
+
 IOWrapper::IOWrapper(
 				const vector<FactorType>				&inputFactorOrder
 				, const vector<FactorType>			&outputFactorOrder
@@ -60,6 +222,9 @@ IOWrapper::IOWrapper(
 ,m_nBestStream(NULL)
 ,m_outputWordGraphStream(NULL)
 ,m_outputSearchGraphStream(NULL)
+,m_inputReader(NULL)
+,m_outputWriter(NULL)
+,m_nBestFormatter(NULL)
 {
 	Initialization(inputFactorOrder, outputFactorOrder
 								, inputFactorUsed
@@ -80,6 +245,9 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
 ,m_nBestStream(NULL)
 ,m_outputWordGraphStream(NULL)
 ,m_outputSearchGraphStream(NULL)
+,m_inputReader(NULL)
+,m_outputWriter(NULL)
+,m_nBestFormatter(NULL)
 {
 	Initialization(inputFactorOrder, outputFactorOrder
 								, inputFactorUsed
@@ -90,6 +258,11 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
 
 IOWrapper::~IOWrapper()
 {
+	// finish writing before closing any of the streams
+	delete m_outputWriter;
+	delete m_inputReader;
+	delete m_nBestFormatter;
+
 	if (m_inputFile != NULL)
 		delete m_inputFile;
 	if (m_nBestStream != NULL && !m_surpressSingleBestOutput)
@@ -127,8 +300,10 @@ void IOWrapper::Initialization(const std::vector<FactorType>	&inputFactorOrder
 		{
 			std::ofstream *file = new std::ofstream;
 			m_nBestStream = file;
-			file->open(nBestFilePath.c_str());
+			file->open(nBestFilePath.c_str(), staticData.IsBinaryNBestList() ? ios::out | ios::binary : ios::out);
 		}
+		m_nBestFormatter = new NBestFormatter(staticData, outputFactorOrder, staticData.IsBinaryNBestList());
+		m_nBestFormatter->WriteHeader(*m_nBestStream);
 	}
 
 	// wordgraph output
@@ -148,6 +323,34 @@ void IOWrapper::Initialization(const std::vector<FactorType>	&inputFactorOrder
 	  m_outputSearchGraphStream = file;
 	  file->open(fileName.c_str());
 	}
+
+	// separate threads for reading input and writing output
+	if (staticData.UseAsyncIO())
+	{
+#ifdef WITH_THREADS
+		m_inputReader = new InputReader(*this, staticData.GetInputType());
+		m_outputWriter = new OutputWriter;
+		if (!m_outputWriter->Start())
+		{
+			TRACE_ERR("WARNING: could not start output thread, writing output synchronously" << endl);
+			delete m_outputWriter;
+			m_outputWriter = NULL;
+		}
+#else
+		TRACE_ERR("WARNING: async-io requires moses to be configured with --enable-threads. Ignored" << endl);
+#endif
+	}
+}
+
+InputType* IOWrapper::GetInput(InputTypeEnum inputType)
+{
+#ifdef WITH_THREADS
+	// reading ahead starts with the first request for input
+	if (m_inputReader != NULL && (m_inputReader->IsRunning() || m_inputReader->Start()))
+		return m_inputReader->Pop();
+#endif
+	InputType *source = CreateInput(inputType);
+	return (source == NULL) ? NULL : GetInput(source);
 }
 
 InputType*IOWrapper::GetInput(InputType* inputType)
@@ -262,13 +465,15 @@ void IOWrapper::Backtrack(const Hypothesis *hypo){
 				
 void IOWrapper::OutputBestHypo(const std::vector<const Factor*>&  mbrBestHypo, long /*translationId*/, bool reportSegmentation, bool reportAllFactors)
 {
+	OutputBuffer buffer(cout, m_outputWriter);
+	std::ostream &out = buffer.GetStream();
 	for (size_t i = 0 ; i < mbrBestHypo.size() ; i++)
 			{
 				const Factor *factor = mbrBestHypo[i];
-				if (i>0) cout << " ";
-				cout << factor->GetString();
+				if (i>0) out << " ";
+				out << factor->GetString();
 			}
-	cout << endl;
+	out << endl;
 }													 
 
 void OutputInput(std::vector<const Phrase*>& map, const Hypothesis* hypo)
@@ -300,12 +505,14 @@ void IOWrapper::OutputBestHypo(const Hypothesis *hypo, long /*translationId*/, b
 
 		if (!m_surpressSingleBestOutput)
 		{
+			OutputBuffer buffer(cout, m_outputWriter);
+			std::ostream &out = buffer.GetStream();
 			if (StaticData::Instance().IsPathRecoveryEnabled()) {
-				OutputInput(cout, hypo);
-				cout << "||| ";
+				OutputInput(out, hypo);
+				out << "||| ";
 			}
-			OutputSurface(cout, hypo, m_outputFactorOrder, reportSegmentation, reportAllFactors);
-			cout << endl;
+			OutputSurface(out, hypo, m_outputFactorOrder, reportSegmentation, reportAllFactors);
+			out << endl;
 		}
 	}
 	else
@@ -313,185 +520,14 @@ void IOWrapper::OutputBestHypo(const Hypothesis *hypo, long /*translationId*/, b
 		VERBOSE(1, "NO BEST TRANSLATION" << endl);
 		if (!m_surpressSingleBestOutput)
 		{
-			cout << endl;
+			OutputBuffer buffer(cout, m_outputWriter);
+			buffer.GetStream() << endl;
 		}
 	}
 }
 
 void IOWrapper::OutputNBestList(const TrellisPathList &nBestList, long translationId)
 {
-	bool labeledOutput = StaticData::Instance().IsLabeledNBestList();
-	bool includeAlignment = StaticData::Instance().NBestIncludesAlignment();
-	bool includeWordAlignment = StaticData::Instance().PrintAlignmentInfoInNbest();
-	
-	TrellisPathList::const_iterator iter;
-	for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter)
-	{
-		const TrellisPath &path = **iter;
-		const std::vector<const Hypothesis *> &edges = path.GetEdges();
-
-		// print the surface factor of the translation
-		*m_nBestStream << translationId << " ||| ";
-		for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--)
-		{
-			const Hypothesis &edge = *edges[currEdge];
-			OutputSurface(*m_nBestStream, edge.GetCurrTargetPhrase(), m_outputFactorOrder, false); // false for not reporting all factors
-		}
-		*m_nBestStream << " ||| ";
-
-		// print the scores in a hardwired order
-    // before each model type, the corresponding command-line-like name must be emitted
-    // MERT script relies on this
-
-		// basic distortion
-		if (labeledOutput)
-	    *m_nBestStream << "d: ";
-		*m_nBestStream << path.GetScoreBreakdown().GetScoreForProducer(StaticData::Instance().GetDistortionScoreProducer()) << " ";
-
-//		reordering
-		vector<LexicalReordering*> rms = StaticData::Instance().GetReorderModels();
-		if(rms.size() > 0)
-		{
-				vector<LexicalReordering*>::iterator iter;
-				for(iter = rms.begin(); iter != rms.end(); ++iter)
-				{
-					vector<float> scores = path.GetScoreBreakdown().GetScoresForProducer(*iter);
-					for (size_t j = 0; j<scores.size(); ++j) 
-					{
-				  		*m_nBestStream << scores[j] << " ";
-					}
-				}
-		}
-			
-		// lm
-		const LMList& lml = StaticData::Instance().GetAllLM();
-    if (lml.size() > 0) {
-			if (labeledOutput)
-	      *m_nBestStream << "lm: ";
-		  LMList::const_iterator lmi = lml.begin();
-		  for (; lmi != lml.end(); ++lmi) {
-			  *m_nBestStream << path.GetScoreBreakdown().GetScoreForProducer(*lmi) << " ";
-		  }
-    }
-
-		// translation components
-		if (StaticData::Instance().GetInputType()==SentenceInput){  
-			// translation components	for text input
-			vector<PhraseDictionary*> pds = StaticData::Instance().GetPhraseDictionaries();
-			if (pds.size() > 0) {
-				if (labeledOutput)
-					*m_nBestStream << "tm: ";
-				vector<PhraseDictionary*>::iterator iter;
-				for (iter = pds.begin(); iter != pds.end(); ++iter) {
-					vector<float> scores = path.GetScoreBreakdown().GetScoresForProducer(*iter);
-					for (size_t j = 0; j<scores.size(); ++j) 
-						*m_nBestStream << scores[j] << " ";
-				}
-			}
-		}
-		else{		
-			// translation components for Confusion Network input
-			// first translation component has GetNumInputScores() scores from the input Confusion Network
-			// at the beginning of the vector
-			vector<PhraseDictionary*> pds = StaticData::Instance().GetPhraseDictionaries();
-			if (pds.size() > 0) {
-				vector<PhraseDictionary*>::iterator iter;
-				
-				iter = pds.begin();
-				vector<float> scores = path.GetScoreBreakdown().GetScoresForProducer(*iter);
-					
-				size_t pd_numinputscore = (*iter)->GetNumInputScores();
-
-				if (pd_numinputscore){
-					
-					if (labeledOutput)
-						*m_nBestStream << "I: ";
-
-					for (size_t j = 0; j < pd_numinputscore; ++j)
-						*m_nBestStream << scores[j] << " ";
-				}
-					
-					
-				for (iter = pds.begin() ; iter != pds.end(); ++iter) {
-					vector<float> scores = path.GetScoreBreakdown().GetScoresForProducer(*iter);
-					
-					size_t pd_numinputscore = (*iter)->GetNumInputScores();
-
-					if (iter == pds.begin() && labeledOutput)
-						*m_nBestStream << "tm: ";
-					for (size_t j = pd_numinputscore; j < scores.size() ; ++j)
-						*m_nBestStream << scores[j] << " ";
-				}
-			}
-		}
-		
-		
-		
-		// word penalty
-		if (labeledOutput)
-	    *m_nBestStream << "w: ";
-		*m_nBestStream << path.GetScoreBreakdown().GetScoreForProducer(StaticData::Instance().GetWordPenaltyProducer()) << " ";
-		
-		// generation
-		vector<GenerationDictionary*> gds = StaticData::Instance().GetGenerationDictionaries();
-    if (gds.size() > 0) {
-			if (labeledOutput)
-	      *m_nBestStream << "g: ";
-		  vector<GenerationDictionary*>::iterator iter;
-		  for (iter = gds.begin(); iter != gds.end(); ++iter) {
-			  vector<float> scores = path.GetScoreBreakdown().GetScoresForProducer(*iter);
-			  for (size_t j = 0; j<scores.size(); j++) {
-				  *m_nBestStream << scores[j] << " ";
-			  }
-		  }
-    }
-		
-		// total						
-    *m_nBestStream << "||| " << path.GetTotalScore();
-		
-		//phrase-to-phrase alignment
-    if (includeAlignment) {
-			*m_nBestStream << " |||";
-			for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--)
-			{
-				const Hypothesis &edge = *edges[currEdge];
-				const WordsRange &sourceRange = edge.GetCurrSourceWordsRange();
-				WordsRange targetRange = path.GetTargetWordsRange(edge);
-				*m_nBestStream << " " << sourceRange.GetStartPos();
-				if (sourceRange.GetStartPos() < sourceRange.GetEndPos()) {
-					*m_nBestStream << "-" << sourceRange.GetEndPos();
-				}
-				*m_nBestStream << "=" << targetRange.GetStartPos();
-				if (targetRange.GetStartPos() < targetRange.GetEndPos()) {
-					*m_nBestStream << "-" << targetRange.GetEndPos();
-				}
-			}
-    }
-		
-				
-		if (includeWordAlignment){			
-			//word-to-word alignment (source-to-target)
-			*m_nBestStream << " |||";
-			for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--)
-			{
-				const Hypothesis &edge = *edges[currEdge];
-				WordsRange targetRange = path.GetTargetWordsRange(edge);
-				OutputWordAlignment(*m_nBestStream, edge.GetCurrTargetPhrase(),edge.GetCurrSourceWordsRange().GetStartPos(),targetRange.GetStartPos(), Input);
-			}
-
-			//word-to-word alignment (target-to-source)
-			*m_nBestStream << " |||";		
-			for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--)
-			{
-				const Hypothesis &edge = *edges[currEdge];
-				WordsRange targetRange = path.GetTargetWordsRange(edge);
-				OutputWordAlignment(*m_nBestStream, edge.GetCurrTargetPhrase(),edge.GetCurrSourceWordsRange().GetStartPos(),targetRange.GetStartPos(), Output);
-			}
-		}
-				
-		*m_nBestStream << endl;
-	}
-
-
-	*m_nBestStream<<std::flush;
+	OutputBuffer buffer(*m_nBestStream, m_outputWriter);
+	m_nBestFormatter->Write(buffer.GetStream(), nBestList, translationId);
 }
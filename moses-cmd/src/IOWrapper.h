@@ -45,8 +45,14 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "InputFileStream.h"
 #include "InputType.h"
 
+class InputReader;
+class OutputWriter;
+class NBestFormatter;
+
 class IOWrapper
 {
+	friend class InputReader;
+
 protected:
 	long m_translationId;
 
@@ -59,6 +65,9 @@ protected:
 	std::istream									*m_inputStream;
 	Moses::InputFileStream				*m_inputFile;
 	bool													m_surpressSingleBestOutput;
+	InputReader										*m_inputReader; //! parses input ahead of decoding, if async-io
+	OutputWriter									*m_outputWriter; //! writes output behind decoding, if async-io
+	NBestFormatter								*m_nBestFormatter;
 	
 	void Initialization(const std::vector<Moses::FactorType>	&inputFactorOrder
 										, const std::vector<Moses::FactorType>			&outputFactorOrder
@@ -81,6 +90,8 @@ public:
 		 , const std::string                                                     &infilePath);
 	~IOWrapper();
 
+	//! read the next input, NULL at the end of the input
+	Moses::InputType* GetInput(Moses::InputTypeEnum inputType);
 	Moses::InputType* GetInput(Moses::InputType *inputType);
 	void OutputBestHypo(const Moses::Hypothesis *hypo, long translationId, bool reportSegmentation, bool reportAllFactors);
 	void OutputBestHypo(const std::vector<const Moses::Factor*>&  mbrBestHypo, long translationId, bool reportSegmentation, bool reportAllFactors);
@@ -98,3 +109,7 @@ public:
 	  return *m_outputSearchGraphStream;
 	}
 };
+
+void OutputSurface(std::ostream &out, const Moses::Hypothesis *hypo, const std::vector<Moses::FactorType> &outputFactorOrder
+									 ,bool reportSegmentation, bool reportAllFactors);
+void OutputWordAlignment(std::ostream &out, const Moses::TargetPhrase &phrase, size_t srcoffset, size_t trgoffset, Moses::FactorDirection direction);
@@ -0,0 +1,258 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/** load-test client for the decoder server (moses -server ADDRESS).
+ * Sends the sentences read from stdin over a number of concurrent connections
+ * and reports throughput and the distribution of request latencies
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/time.h>
+#include "Socket.h"
+#include "Thread.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+double GetWallTime()
+{
+	timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec + now.tv_usec / 1e6;
+}
+
+void Usage()
+{
+	cerr << "usage: moses-load-test -s ADDRESS [options] < sentences" << endl
+			 << "  -s ADDRESS  server socket: unix:PATH, tcp:PORT or tcp:HOST:PORT" << endl
+			 << "  -c N        number of concurrent connections (default 1)" << endl
+			 << "  -n N        ask for N-best lists (default 0)" << endl
+			 << "  -r N        send the input N times (default 1)" << endl
+			 << "  -p          print the translations to stdout, in input order" << endl;
+}
+
+//! requests shared by all connections, and their results
+class LoadTest
+{
+protected:
+	const string m_address;
+	const vector<string> &m_sentences;
+	const size_t m_nBestSize, m_numRequests;
+	size_t m_nextRequest;
+	Mutex m_lock;
+
+public:
+	vector<double> m_latencies;
+	vector<string> m_translations;
+	size_t m_failures;
+
+	LoadTest(const string &address, const vector<string> &sentences, size_t nBestSize, size_t repeat)
+	:m_address(address)
+	,m_sentences(sentences)
+	,m_nBestSize(nBestSize)
+	,m_numRequests(sentences.size() * repeat)
+	,m_nextRequest(0)
+	,m_latencies(m_numRequests, -1.0)
+	,m_translations(m_numRequests)
+	,m_failures(0)
+	{}
+
+	//! send requests on 1 connection until there are none left
+	void RunConnection()
+	{
+		int socket = ConnectSocket(m_address);
+		if (socket < 0)
+		{
+			ScopedLock lock(m_lock);
+			++m_failures;
+			return;
+		}
+		LineSocket connection(socket);
+		string request, line;
+		while (true)
+		{
+			size_t index;
+			{
+				ScopedLock lock(m_lock);
+				if (m_nextRequest >= m_numRequests)
+					return;
+				index = m_nextRequest++;
+			}
+			request = m_sentences[index % m_sentences.size()];
+			if (m_nBestSize > 0)
+				request = "n-best=" + SPrintSize(m_nBestSize) + " ||| " + request;
+
+			double start = GetWallTime();
+			bool ok = connection.Write(request + "\n") && connection.ReadLine(m_translations[index]);
+			// n-best list is terminated by an empty line
+			while (ok && m_nBestSize > 0 && connection.ReadLine(line) && !line.empty())
+				;
+			if (!ok)
+			{
+				ScopedLock lock(m_lock);
+				++m_failures;
+				return;
+			}
+			m_latencies[index] = GetWallTime() - start;
+		}
+	}
+
+	static string SPrintSize(size_t value)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%lu", (unsigned long) value);
+		return text;
+	}
+};
+
+#ifdef WITH_THREADS
+class ConnectionThread : public Thread
+{
+protected:
+	LoadTest &m_test;
+public:
+	explicit ConnectionThread(LoadTest &test)
+	:m_test(test)
+	{}
+	void Run()
+	{
+		m_test.RunConnection();
+	}
+};
+#endif
+
+}
+
+int main(int argc, char* argv[])
+{
+	string address;
+	size_t connections = 1, nBestSize = 0, repeat = 1;
+	bool print = false;
+	int option;
+	while ((option = getopt(argc, argv, "s:c:n:r:ph")) != -1)
+	{
+		switch (option)
+		{
+			case 's': address = optarg; break;
+			case 'c': connections = atoi(optarg); break;
+			case 'n': nBestSize = atoi(optarg); break;
+			case 'r': repeat = atoi(optarg); break;
+			case 'p': print = true; break;
+			default: Usage(); return EXIT_FAILURE;
+		}
+	}
+	if (address.empty() || connections == 0 || repeat == 0)
+	{
+		Usage();
+		return EXIT_FAILURE;
+	}
+
+	vector<string> sentences;
+	string line;
+	while (getline(cin, line))
+		sentences.push_back(line);
+	if (sentences.empty())
+	{
+		cerr << "no input sentences" << endl;
+		return EXIT_FAILURE;
+	}
+
+#ifndef WITH_THREADS
+	if (connections > 1)
+	{
+		cerr << "WARNING: built without thread support, using 1 connection" << endl;
+		connections = 1;
+	}
+#endif
+
+	LoadTest test(address, sentences, nBestSize, repeat);
+	double start = GetWallTime();
+#ifdef WITH_THREADS
+	vector<ConnectionThread*> threads;
+	for (size_t i = 0 ; i < connections ; ++i)
+	{
+		threads.push_back(new ConnectionThread(test));
+		if (!threads.back()->Start())
+			test.RunConnection();
+	}
+	for (size_t i = 0 ; i < threads.size() ; ++i)
+	{
+		threads[i]->Join();
+		delete threads[i];
+	}
+#else
+	test.RunConnection();
+#endif
+	double wallTime = GetWallTime() - start;
+
+	vector<double> latencies;
+	for (size_t i = 0 ; i < test.m_latencies.size() ; ++i)
+	{
+		if (test.m_latencies[i] >= 0)
+			latencies.push_back(test.m_latencies[i]);
+		if (print)
+			cout << test.m_translations[i] << endl;
+	}
+	sort(latencies.begin(), latencies.end());
+
+	fprintf(stderr, "requests: %lu answered, %lu connection failures, %lu connections\n"
+				, (unsigned long) latencies.size(), (unsigned long) test.m_failures, (unsigned long) connections);
+	fprintf(stderr, "wall time: %.3f s, throughput: %.2f sentences/s\n"
+				, wallTime, wallTime > 0 ? latencies.size() / wallTime : 0.0);
+	if (!latencies.empty())
+	{
+		double total = 0;
+		for (size_t i = 0 ; i < latencies.size() ; ++i)
+			total += latencies[i];
+		const size_t last = latencies.size() - 1;
+		fprintf(stderr, "latency (ms): mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n"
+					, 1000 * total / latencies.size()
+					, 1000 * latencies[last / 2]
+					, 1000 * latencies[last * 90 / 100]
+					, 1000 * latencies[last * 99 / 100]
+					, 1000 * latencies[last]);
+	}
+	return (test.m_failures == 0 && latencies.size() == test.m_latencies.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -52,6 +52,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "WordLattice.h"
 #include "TranslationAnalysis.h"
 #include "mbr.h"
+#ifndef WIN32
+#include "DecoderServer.h"
+#endif
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -67,13 +70,7 @@ using namespace Moses;
 bool ReadInput(IOWrapper &ioWrapper, InputTypeEnum inputType, InputType*& source)
 {
 	delete source;
-	switch(inputType)
-	{
-		case SentenceInput:         source = ioWrapper.GetInput(new Sentence(Input)); break;
-		case ConfusionNetworkInput: source = ioWrapper.GetInput(new ConfusionNet);    break;
-		case WordLatticeInput:      source = ioWrapper.GetInput(new WordLattice);     break;
-		default: TRACE_ERR("Unknown input type: " << inputType << "\n");
-	}
+	source = ioWrapper.GetInput(inputType);
 	return (source ? true : false);
 }
 
@@ -108,9 +105,6 @@ int main(int argc, char* argv[])
 	if (!StaticData::LoadDataStatic(parameter))
 		return EXIT_FAILURE;
 
-	// set up read/writing class
-	IOWrapper *ioWrapper = GetIODevice(staticData);
-
 	// check on weights
 	vector<float> weights = staticData.GetAllWeights();
 	IFVERBOSE(2) {
@@ -125,6 +119,17 @@ int main(int argc, char* argv[])
 	  return EXIT_FAILURE;
 	}
 
+#ifndef WIN32
+	// keep the models loaded and translate requests from a socket
+	if (staticData.GetParam("server").size() > 0)
+	{
+		DecoderServer server(staticData, staticData.GetParam("server")[0]);
+		return server.Run() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+#endif
+
+	// set up read/writing class
+	IOWrapper *ioWrapper = GetIODevice(staticData);
 	if (ioWrapper == NULL)
 		return EXIT_FAILURE;
 
@@ -0,0 +1,462 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#include <cstdio>
+#include <cmath>
+#include <sstream>
+#include "NBestFormatter.h"
+#include "IOWrapper.h"
+#include "StaticData.h"
+#include "TrellisPath.h"
+#include "Hypothesis.h"
+#include "LexicalReordering.h"
+#include "PhraseDictionary.h"
+#include "GenerationDictionary.h"
+#include "DummyScoreProducers.h"
+
+using namespace std;
+using namespace Moses;
+
+const char NBestFormatter::BINARY_MAGIC[8] = { 'M', 'O', 'S', 'E', 'S', 'N', 'B', '\0' };
+const unsigned int NBestFormatter::BINARY_VERSION;
+
+// powers of 10 which are exact in a double
+static const double s_pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12 };
+static const int MAX_EXACT_POW10 = 12;
+
+NBestFormatter::NBestFormatter(const StaticData &staticData, const vector<FactorType> &outputFactorOrder, bool binary)
+:m_outputFactorOrder(outputFactorOrder)
+,m_labeledOutput(staticData.IsLabeledNBestList() || binary)
+,m_includeAlignment(staticData.NBestIncludesAlignment())
+,m_includeWordAlignment(staticData.PrintAlignmentInfoInNbest())
+,m_binary(binary)
+{
+	// the scores in the hardwired order mert expects
+	// before each model type, the corresponding command-line-like name must be emitted
+
+	// basic distortion
+	AddFeatures("d: ", staticData.GetDistortionScoreProducer());
+
+	// reordering
+	const vector<LexicalReordering*> &rms = staticData.GetReorderModels();
+	for (size_t i = 0 ; i < rms.size() ; ++i)
+		AddFeatures(NULL, rms[i]);
+
+	// lm
+	const LMList &lml = staticData.GetAllLM();
+	for (LMList::const_iterator lmi = lml.begin() ; lmi != lml.end() ; ++lmi)
+		AddFeatures(lmi == lml.begin() ? "lm: " : NULL, *lmi);
+
+	// translation components
+	const vector<PhraseDictionary*> &pds = staticData.GetPhraseDictionaries();
+	if (staticData.GetInputType() == SentenceInput)
+	{
+		for (size_t i = 0 ; i < pds.size() ; ++i)
+			AddFeatures(i == 0 ? "tm: " : NULL, pds[i]);
+	}
+	else if (pds.size() > 0)
+	{
+		// first translation component has GetNumInputScores() scores from the input Confusion Network
+		// at the beginning of the vector
+		size_t numInputScores = pds[0]->GetNumInputScores();
+		if (numInputScores > 0)
+			AddFeatures("I: ", pds[0], 0, numInputScores);
+		for (size_t i = 0 ; i < pds.size() ; ++i)
+			AddFeatures(i == 0 ? "tm: " : NULL, pds[i], pds[i]->GetNumInputScores());
+	}
+
+	// word penalty
+	AddFeatures("w: ", staticData.GetWordPenaltyProducer());
+
+	// generation
+	const vector<GenerationDictionary*> &gds = staticData.GetGenerationDictionaries();
+	for (size_t i = 0 ; i < gds.size() ; ++i)
+		AddFeatures(i == 0 ? "g: " : NULL, gds[i]);
+
+	if (m_binary && (m_includeAlignment || m_includeWordAlignment))
+	{
+		TRACE_ERR("WARNING: alignments are not included in binary n-best lists" << endl);
+	}
+
+	m_buffer.reserve(4096);
+}
+
+void NBestFormatter::AddFeatures(const char *label, const ScoreProducer *producer, size_t begin, size_t end)
+{
+	const ScoreIndexManager &scoreIndexManager = StaticData::Instance().GetScoreIndexManager();
+	const size_t id = producer->GetScoreBookkeepingID();
+	const size_t producerBegin = scoreIndexManager.GetBeginIndex(id)
+							,producerEnd = scoreIndexManager.GetEndIndex(id);
+	end = (end == NOT_FOUND) ? producerEnd : std::min(producerBegin + end, producerEnd);
+	begin = producerBegin + begin;
+
+	Feature feature;
+	feature.label = (m_labeledOutput && label != NULL) ? label : "";
+	if (begin >= end)
+	{ // label without scores
+		if (!feature.label.empty())
+		{
+			feature.scoreIndex = NOT_FOUND;
+			m_features.push_back(feature);
+		}
+		return;
+	}
+	for (size_t i = begin ; i < end ; ++i)
+	{
+		feature.scoreIndex = i;
+		m_features.push_back(feature);
+		feature.label.clear();
+	}
+}
+
+string NBestFormatter::GetFeatureNames() const
+{
+	// same naming as mert's Data::loadnbest
+	string names, name;
+	size_t index = 0;
+	for (size_t i = 0 ; i < m_features.size() ; ++i)
+	{
+		const Feature &feature = m_features[i];
+		if (!feature.label.empty())
+		{
+			name = feature.label.substr(0, feature.label.find(':'));
+			index = 0;
+		}
+		if (feature.scoreIndex == NOT_FOUND)
+			continue;
+		if (!names.empty())
+			names += " ";
+		names += name + "_" + SPrint(index++);
+	}
+	return names;
+}
+
+void NBestFormatter::WriteHeader(ostream &out)
+{
+	if (!m_binary)
+		return;
+
+	const string names = GetFeatureNames();
+	m_buffer.clear();
+	m_buffer.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	AppendRaw<UINT32>(BINARY_VERSION);
+	UINT32 numFeatures = 0;
+	for (size_t i = 0 ; i < m_features.size() ; ++i)
+		if (m_features[i].scoreIndex != NOT_FOUND)
+			++numFeatures;
+	AppendRaw<UINT32>(numFeatures);
+	AppendRaw<UINT32>(names.size());
+	m_buffer += names;
+	out.write(m_buffer.data(), m_buffer.size());
+}
+
+void NBestFormatter::Write(ostream &out, const TrellisPathList &nBestList, long translationId)
+{
+	if (m_binary)
+		WriteBinary(out, nBestList, translationId);
+	else
+		WriteText(out, nBestList, translationId);
+	out << flush;
+}
+
+void NBestFormatter::AppendSurface(const TrellisPath &path)
+{
+	const vector<const Hypothesis *> &edges = path.GetEdges();
+	for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--)
+	{
+		const Phrase &phrase = edges[currEdge]->GetCurrTargetPhrase();
+		for (size_t pos = 0 ; pos < phrase.GetSize() ; pos++)
+		{
+			m_buffer += phrase.GetFactor(pos, m_outputFactorOrder[0])->GetString();
+			for (size_t i = 1 ; i < m_outputFactorOrder.size() ; i++)
+			{
+				m_buffer += '|';
+				m_buffer += phrase.GetFactor(pos, m_outputFactorOrder[i])->GetString();
+			}
+			m_buffer += ' ';
+		}
+	}
+}
+
+void NBestFormatter::AppendAlignment(const TrellisPath &path)
+{
+	//phrase-to-phrase alignment
+	const vector<const Hypothesis *> &edges = path.GetEdges();
+	m_buffer += " |||";
+	size_t targetStart = edges.back()->GetCurrTargetLength();
+	for (int currEdge = (int)edges.size() - 2 ; currEdge >= 0 ; currEdge--)
+	{
+		const Hypothesis &edge = *edges[currEdge];
+		const WordsRange &sourceRange = edge.GetCurrSourceWordsRange();
+		const size_t targetEnd = targetStart + edge.GetCurrTargetLength() - 1;
+		m_buffer += ' ';
+		AppendInteger(m_buffer, sourceRange.GetStartPos());
+		if (sourceRange.GetStartPos() < sourceRange.GetEndPos()) {
+			m_buffer += '-';
+			AppendInteger(m_buffer, sourceRange.GetEndPos());
+		}
+		m_buffer += '=';
+		AppendInteger(m_buffer, targetStart);
+		if (targetStart < targetEnd) {
+			m_buffer += '-';
+			AppendInteger(m_buffer, targetEnd);
+		}
+		targetStart += edge.GetCurrTargetLength();
+	}
+}
+
+void NBestFormatter::AppendWordAlignment(const TrellisPath &path)
+{
+	// rarely used, so left to the alignment classes' own stream output
+	const vector<const Hypothesis *> &edges = path.GetEdges();
+	ostringstream out;
+	FactorDirection directions[2] = { Input, Output }; // source-to-target, then target-to-source
+	for (size_t dir = 0 ; dir < 2 ; ++dir)
+	{
+		out << " |||";
+		size_t targetStart = 0;
+		for (int currEdge = (int)edges.size() - 1 ; currEdge >= 0 ; currEdge--)
+		{
+			const Hypothesis &edge = *edges[currEdge];
+			OutputWordAlignment(out, edge.GetCurrTargetPhrase(), edge.GetCurrSourceWordsRange().GetStartPos(), targetStart, directions[dir]);
+			targetStart += edge.GetCurrTargetLength();
+		}
+	}
+	m_buffer += out.str();
+}
+
+void NBestFormatter::WriteText(ostream &out, const TrellisPathList &nBestList, long translationId)
+{
+	const int precision = out.precision();
+	const bool fixed = (out.flags() & ios::fixed) != 0;
+
+	TrellisPathList::const_iterator iter;
+	for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter)
+	{
+		const TrellisPath &path = **iter;
+		const ScoreComponentCollection &scores = path.GetScoreBreakdown();
+		m_buffer.clear();
+
+		// print the surface factor of the translation
+		AppendInteger(m_buffer, translationId);
+		m_buffer += " ||| ";
+		AppendSurface(path);
+		m_buffer += " ||| ";
+
+		for (size_t i = 0 ; i < m_features.size() ; ++i)
+		{
+			const Feature &feature = m_features[i];
+			m_buffer += feature.label;
+			if (feature.scoreIndex != NOT_FOUND)
+			{
+				AppendFloat(m_buffer, scores[feature.scoreIndex], precision, fixed);
+				m_buffer += ' ';
+			}
+		}
+
+		// total
+		m_buffer += "||| ";
+		AppendFloat(m_buffer, path.GetTotalScore(), precision, fixed);
+
+		if (m_includeAlignment)
+			AppendAlignment(path);
+		if (m_includeWordAlignment)
+			AppendWordAlignment(path);
+
+		m_buffer += '\n';
+		out.write(m_buffer.data(), m_buffer.size());
+	}
+}
+
+void NBestFormatter::WriteBinary(ostream &out, const TrellisPathList &nBestList, long translationId)
+{
+	TrellisPathList::const_iterator iter;
+	for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter)
+	{
+		const TrellisPath &path = **iter;
+		const ScoreComponentCollection &scores = path.GetScoreBreakdown();
+		m_buffer.clear();
+
+		AppendRaw<UINT32>(translationId);
+		// surface goes after its length, which is only known once it is written
+		const size_t lengthPos = m_buffer.size();
+		AppendRaw<UINT32>(0);
+		AppendSurface(path);
+		const UINT32 length = m_buffer.size() - lengthPos - sizeof(UINT32);
+		m_buffer.replace(lengthPos, sizeof(UINT32), reinterpret_cast<const char*>(&length), sizeof(UINT32));
+
+		for (size_t i = 0 ; i < m_features.size() ; ++i)
+		{
+			if (m_features[i].scoreIndex != NOT_FOUND)
+				AppendRaw<float>(scores[m_features[i].scoreIndex]);
+		}
+		AppendRaw<float>(path.GetTotalScore());
+		out.write(m_buffer.data(), m_buffer.size());
+	}
+}
+
+void NBestFormatter::AppendInteger(string &buffer, long value)
+{
+	char digits[24];
+	char *end = digits + sizeof(digits), *begin = end;
+	unsigned long absValue = (value < 0) ? -(unsigned long) value : value;
+	do
+	{
+		*--begin = '0' + (absValue % 10);
+		absValue /= 10;
+	} while (absValue != 0);
+	if (value < 0)
+		*--begin = '-';
+	buffer.append(begin, end);
+}
+
+//! round to the nearest integer, ties to even, as printf does
+static inline double RoundHalfEven(double value)
+{
+	double integer = floor(value);
+	double fraction = value - integer;
+	if (fraction > 0.5 || (fraction == 0.5 && fmod(integer, 2.0) != 0.0))
+		integer += 1.0;
+	return integer;
+}
+
+//! append the decimal digits of integer, at least minDigits of them
+static inline void AppendDigits(string &buffer, double integer, int minDigits)
+{
+	char digits[32];
+	char *end = digits + sizeof(digits), *begin = end;
+	do
+	{
+		double next = floor(integer / 10.0);
+		*--begin = '0' + (int) (integer - next * 10.0);
+		integer = next;
+	} while (integer != 0.0 || end - begin < minDigits);
+	buffer.append(begin, end);
+}
+
+void NBestFormatter::AppendFloat(string &buffer, float value, int precision, bool fixed)
+{
+	/* a float has a 24 bit mantissa, so multiplying it by 10^k for k <= 12 is exact in a double
+	 * and the rounding below makes the same decisions as printf's exact decimal conversion.
+	 * Anything else goes to snprintf */
+	const double absValue = fabs((double) value);
+	if (precision < 0)
+		precision = 6;
+	if (!fixed && precision == 0)
+		precision = 1;
+
+	if (absValue == 0.0 || (absValue == absValue && absValue < 1e15))
+	{
+		if (fixed && precision <= MAX_EXACT_POW10 && absValue * s_pow10[precision] < 1e15)
+		{
+			double scaled = RoundHalfEven(absValue * s_pow10[precision]);
+			if (signbit(value))
+				buffer += '-';
+			double integerPart = floor(scaled / s_pow10[precision]);
+			AppendDigits(buffer, integerPart, 1);
+			if (precision > 0)
+			{
+				buffer += '.';
+				AppendDigits(buffer, scaled - integerPart * s_pow10[precision], precision);
+			}
+			return;
+		}
+		if (!fixed && absValue == 0.0)
+		{
+			if (signbit(value))
+				buffer += '-';
+			buffer += '0';
+			return;
+		}
+		if (!fixed && precision <= MAX_EXACT_POW10 && absValue >= 1e-4)
+		{
+			// %g: decimal exponent of the value rounded to precision significant digits
+			int exponent = (int) floor(log10(absValue));
+			int shift = precision - 1 - exponent;
+			if (shift >= 0 && shift + 1 <= MAX_EXACT_POW10)
+			{
+				if (absValue * s_pow10[shift] >= s_pow10[precision])
+				{ // log10 was rounded up
+					--exponent;
+					++shift;
+				}
+				else if (absValue * s_pow10[shift] < s_pow10[precision - 1] && shift > 0)
+				{ // log10 was rounded down
+					++exponent;
+					--shift;
+				}
+				double digits = RoundHalfEven(absValue * s_pow10[shift]);
+				if (digits >= s_pow10[precision])
+				{ // rounding carried into a new digit, eg. 9.999999
+					digits /= 10.0;
+					++exponent;
+					--shift;
+				}
+				// %g uses fixed notation for exponents in [-4, precision)
+				if (exponent >= -4 && exponent < precision && shift >= 0)
+				{
+					// drop trailing zeros of the fraction
+					int fractionDigits = shift;
+					while (fractionDigits > 0 && fmod(digits, 10.0) == 0.0)
+					{
+						digits /= 10.0;
+						--fractionDigits;
+					}
+					if (value < 0)
+						buffer += '-';
+					double divisor = s_pow10[fractionDigits];
+					double integerPart = floor(digits / divisor);
+					AppendDigits(buffer, integerPart, 1);
+					if (fractionDigits > 0)
+					{
+						buffer += '.';
+						AppendDigits(buffer, digits - integerPart * divisor, fractionDigits);
+					}
+					return;
+				}
+			}
+		}
+	}
+
+	// scientific notation, nan and inf, huge precisions
+	char text[64];
+	int length = snprintf(text, sizeof(text), fixed ? "%.*f" : "%.*g", precision, (double) value);
+	if (length < (int) sizeof(text))
+	{
+		buffer += text;
+		return;
+	}
+	std::vector<char> longText(length + 1);
+	snprintf(&longText[0], longText.size(), fixed ? "%.*f" : "%.*g", precision, (double) value);
+	buffer.append(&longText[0], length);
+}
+
@@ -0,0 +1,110 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "TypeDef.h"
+#include "TrellisPathList.h"
+
+namespace Moses
+{
+class ScoreProducer;
+class StaticData;
+}
+
+/** writes n-best lists for mert, without going through iostream formatting.
+ *
+ * The score labels and the score indices of every score producer are worked
+ * out once per run. Each n-best entry is built in a character buffer that is
+ * reused across entries and sentences, then written to the stream in one go.
+ * Numbers are converted by hand, giving the same text as ostream << would.
+ *
+ * The binary format has a header with the feature names, followed by one
+ * record per entry: translation id, hypothesis text and the feature scores
+ * as raw floats. mert/extractor recognises it by its magic number.
+ */
+class NBestFormatter
+{
+public:
+	//! first bytes of a binary n-best list
+	static const char BINARY_MAGIC[8];
+	static const unsigned int BINARY_VERSION = 1;
+
+protected:
+	//! 1 score component in the n-best feature list, with the label to print before it, if any
+	struct Feature
+	{
+		std::string label;
+		size_t scoreIndex;
+	};
+
+	std::vector<Feature> m_features;
+	const std::vector<Moses::FactorType> &m_outputFactorOrder;
+	bool m_labeledOutput, m_includeAlignment, m_includeWordAlignment, m_binary;
+	std::string m_buffer; //! holds the entry being formatted. Keeps its capacity between entries
+
+	void AddFeatures(const char *label, const Moses::ScoreProducer *producer, size_t begin = 0, size_t end = NOT_FOUND);
+
+	void AppendSurface(const Moses::TrellisPath &path);
+	void AppendAlignment(const Moses::TrellisPath &path);
+	void AppendWordAlignment(const Moses::TrellisPath &path);
+	void WriteText(std::ostream &out, const Moses::TrellisPathList &nBestList, long translationId);
+	void WriteBinary(std::ostream &out, const Moses::TrellisPathList &nBestList, long translationId);
+
+	template<typename T>
+	void AppendRaw(const T &value)
+	{
+		m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+public:
+	NBestFormatter(const Moses::StaticData &staticData, const std::vector<Moses::FactorType> &outputFactorOrder, bool binary);
+
+	//! header of a binary n-best list. Nothing for text
+	void WriteHeader(std::ostream &out);
+	void Write(std::ostream &out, const Moses::TrellisPathList &nBestList, long translationId);
+
+	/** feature names as mert derives them from the labels of a text n-best list,
+	 * eg. "d_0 d_1 lm_0 tm_0 ..."
+	 */
+	std::string GetFeatureNames() const;
+
+	/** append a float as ostream << does with the given precision (%g, or %f if fixed).
+	 * Does the conversion by hand for the usual range of scores, otherwise uses snprintf
+	 */
+	static void AppendFloat(std::string &buffer, float value, int precision, bool fixed);
+	static void AppendInteger(std::string &buffer, long value);
+};
+
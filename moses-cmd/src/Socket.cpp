@@ -0,0 +1,221 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "Socket.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace
+{
+const int LISTEN_BACKLOG = 64;
+const size_t READ_SIZE = 4096;
+
+/** split address into a unix domain socket path, or a tcp host and port.
+ * Returns false if address is malformed
+ */
+bool ParseAddress(const string &address, bool &isUnix, string &path, string &host, string &port)
+{
+	if (address.compare(0, 5, "unix:") == 0 && address.size() > 5)
+	{
+		isUnix = true;
+		path = address.substr(5);
+		return path.size() < sizeof(((sockaddr_un*) NULL)->sun_path);
+	}
+	if (address.compare(0, 4, "tcp:") == 0 && address.size() > 4)
+	{
+		isUnix = false;
+		string hostPort = address.substr(4);
+		size_t colon = hostPort.rfind(':');
+		if (colon == string::npos)
+		{
+			host = "127.0.0.1";
+			port = hostPort;
+		}
+		else
+		{
+			host = hostPort.substr(0, colon);
+			port = hostPort.substr(colon + 1);
+		}
+		return !port.empty();
+	}
+	TRACE_ERR("ERROR: socket address must be unix:PATH, tcp:PORT or tcp:HOST:PORT, not " << address << endl);
+	return false;
+}
+
+//! socket of the given kind, bound or connected to address
+int OpenSocket(const string &address, bool listen)
+{
+	bool isUnix;
+	string path, host, port;
+	if (!ParseAddress(address, isUnix, path, host, port))
+		return -1;
+
+	if (isUnix)
+	{
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+		int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock < 0)
+			return -1;
+		if (listen)
+		{
+			unlink(path.c_str()); // left over from a previous server
+			if (bind(sock, (sockaddr*) &addr, sizeof(addr)) == 0 && ::listen(sock, LISTEN_BACKLOG) == 0)
+				return sock;
+		}
+		else if (connect(sock, (sockaddr*) &addr, sizeof(addr)) == 0)
+			return sock;
+		TRACE_ERR("ERROR: " << address << ": " << strerror(errno) << endl);
+		close(sock);
+		return -1;
+	}
+
+	addrinfo hints, *addrs;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = listen ? AI_PASSIVE : 0;
+	int error = getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &addrs);
+	if (error != 0)
+	{
+		TRACE_ERR("ERROR: " << address << ": " << gai_strerror(error) << endl);
+		return -1;
+	}
+
+	int sock = -1;
+	for (addrinfo *addr = addrs ; addr != NULL && sock < 0 ; addr = addr->ai_next)
+	{
+		sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+		if (sock < 0)
+			continue;
+		// requests and responses are small, don't wait to fill a segment
+		int on = 1;
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		bool ok;
+		if (listen)
+		{
+			setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+			ok = bind(sock, addr->ai_addr, addr->ai_addrlen) == 0 && ::listen(sock, LISTEN_BACKLOG) == 0;
+		}
+		else
+			ok = connect(sock, addr->ai_addr, addr->ai_addrlen) == 0;
+		if (!ok)
+		{
+			close(sock);
+			sock = -1;
+		}
+	}
+	if (sock < 0)
+		TRACE_ERR("ERROR: " << address << ": " << strerror(errno) << endl);
+	freeaddrinfo(addrs);
+	return sock;
+}
+}
+
+int ListenSocket(const string &address)
+{
+	return OpenSocket(address, true);
+}
+
+int ConnectSocket(const string &address)
+{
+	return OpenSocket(address, false);
+}
+
+LineSocket::LineSocket(int socket)
+:m_socket(socket)
+,m_bufferPos(0)
+{}
+
+LineSocket::~LineSocket()
+{
+	close(m_socket);
+}
+
+bool LineSocket::ReadLine(string &line)
+{
+	size_t newline;
+	while ((newline = m_buffer.find('\n', m_bufferPos)) == string::npos)
+	{
+		// keep only the unread part before reading more
+		m_buffer.erase(0, m_bufferPos);
+		m_bufferPos = 0;
+
+		char data[READ_SIZE];
+		ssize_t size = recv(m_socket, data, sizeof(data), 0);
+		if (size < 0 && errno == EINTR)
+			continue;
+		if (size <= 0)
+		{ // an unterminated last line still counts
+			if (m_buffer.empty())
+				return false;
+			line = m_buffer;
+			m_buffer.clear();
+			return true;
+		}
+		m_buffer.append(data, size);
+	}
+	line.assign(m_buffer, m_bufferPos, newline - m_bufferPos);
+	m_bufferPos = newline + 1;
+	if (!line.empty() && line[line.size() - 1] == '\r')
+		line.erase(line.size() - 1);
+	return true;
+}
+
+bool LineSocket::Write(const string &text)
+{
+	size_t written = 0;
+	while (written < text.size())
+	{
+		ssize_t size = send(m_socket, text.data() + written, text.size() - written, 0);
+		if (size < 0 && errno == EINTR)
+			continue;
+		if (size <= 0)
+			return false;
+		written += size;
+	}
+	return true;
+}
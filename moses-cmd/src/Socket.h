@@ -0,0 +1,68 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (c) 2006 University of Edinburgh
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+			this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, 
+			this list of conditions and the following disclaimer in the documentation 
+			and/or other materials provided with the distribution.
+    * Neither the name of the University of Edinburgh nor the names of its contributors 
+			may be used to endorse or promote products derived from this software 
+			without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS 
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER 
+IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+
+/** line-based communication over a Unix domain or TCP socket,
+ * shared by the decoder server and its load-test client.
+ *
+ * Addresses are written unix:PATH, tcp:PORT (the loopback interface)
+ * or tcp:HOST:PORT
+ */
+
+//! create a socket listening on address. Returns -1 on failure
+int ListenSocket(const std::string &address);
+//! connect to a listening socket. Returns -1 on failure
+int ConnectSocket(const std::string &address);
+
+//! reads lines from and writes to a connected socket. Closes it on destruction
+class LineSocket
+{
+protected:
+	int m_socket;
+	std::string m_buffer; //! received, but not yet returned by ReadLine()
+	size_t m_bufferPos;
+
+	LineSocket(const LineSocket&);
+	LineSocket& operator=(const LineSocket&);
+
+public:
+	explicit LineSocket(int socket);
+	~LineSocket();
+
+	//! next line without the newline. False once the peer has closed the connection
+	bool ReadLine(std::string &line);
+	//! send all of text. False if the connection is broken
+	bool Write(const std::string &text);
+};
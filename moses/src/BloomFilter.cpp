@@ -0,0 +1,148 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include "BloomFilter.h"
+#include "Factor.h"
+#include "FactorTypeSet.h"
+#include "Phrase.h"
+#include "File.h"
+#include "StaticData.h"
+#include "hash.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+void BloomFilter::Init(size_t numKeys, size_t bitsPerKey)
+{
+	m_bits.clear();
+	m_mask = 0;
+	m_numHashes = 0;
+	if (bitsPerKey == 0)
+		return;
+
+	// round up to a power of 2 so that bit positions can be masked
+	UINT64 numBits = 64;
+	while (numBits < (UINT64) numKeys * bitsPerKey)
+		numBits *= 2;
+	m_bits.resize(numBits / 64, 0);
+	m_mask = numBits - 1;
+
+	// optimal number of hashes is ln 2 * bits per key
+	m_numHashes = std::max(1, std::min(16, (int) (bitsPerKey * 0.69 + 0.5)));
+}
+
+void BloomFilter::Init(vector<UINT64> &keys, size_t bitsPerKey)
+{
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	Init(keys.size(), bitsPerKey);
+	if (!IsEnabled())
+		return;
+	for (size_t i = 0 ; i < keys.size() ; ++i)
+		Add(keys[i]);
+}
+
+void BloomFilter::Add(UINT64 key)
+{
+	const UINT64 step = (key >> 32) | 1;
+	for (unsigned int i = 0 ; i < m_numHashes ; ++i)
+	{
+		const UINT64 bit = (key + i * step) & m_mask;
+		m_bits[bit >> 6] |= (UINT64) 1 << (bit & 63);
+	}
+}
+
+bool BloomFilter::Save(const string &filePath) const
+{
+	FILE *f = fOpen(filePath.c_str(), "wb");
+	if (f == NULL)
+		return false;
+	fWrite(f, (UINT32) m_numHashes);
+	fWrite(f, m_mask);
+	fWriteVector(f, m_bits);
+	fClose(f);
+	return true;
+}
+
+bool BloomFilter::Load(const string &filePath)
+{
+	FILE *f = fopen(filePath.c_str(), "rb");
+	if (f == NULL)
+		return false;
+	UINT32 numHashes;
+	fRead(f, numHashes);
+	fRead(f, m_mask);
+	fReadVector(f, m_bits);
+	fClose(f);
+	m_numHashes = numHashes;
+	return true;
+}
+
+void BloomFilter::Report(const string &name) const
+{
+	if (m_numQueries == 0)
+		return;
+	VERBOSE(2, name << " bloom filter: " << m_numSkipped << " of " << m_numQueries << " lookups skipped, "
+							<< m_numFalsePositives << " false positives" << endl);
+	m_numQueries = m_numSkipped = m_numFalsePositives = 0;
+}
+
+UINT64 BloomFilter::GetKey(const Factor * const *factors, size_t numFactors)
+{
+	UINT64 hash = numFactors;
+	for (size_t i = 0 ; i < numFactors ; ++i)
+		hash = Combine(hash, (factors[i] == NULL) ? 0 : factors[i]->GetId() + 1);
+	return Finalize(hash);
+}
+
+UINT64 BloomFilter::GetKey(const Phrase &phrase, const FactorMask &mask)
+{
+	UINT64 hash = phrase.GetSize();
+	for (size_t pos = 0 ; pos < phrase.GetSize() ; ++pos)
+	{
+		for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; ++factorType)
+		{
+			if (mask[factorType])
+			{
+				const Factor *factor = phrase.GetFactor(pos, factorType);
+				hash = Combine(hash, (factor == NULL) ? 0 : factor->GetId() + 1);
+			}
+		}
+	}
+	return Finalize(hash);
+}
+
+UINT64 BloomFilter::GetKey(const vector<string> &words)
+{
+	UINT64 hash = words.size();
+	for (size_t i = 0 ; i < words.size() ; ++i)
+	{
+		const string &word = words[i];
+		hash = Combine(hash, quick_hash(word.data(), word.size(), 0));
+	}
+	return Finalize(hash);
+}
+
+}
+
@@ -0,0 +1,138 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TypeDef.h"
+#include "Thread.h"
+
+namespace Moses
+{
+
+class Factor;
+class Phrase;
+class FactorMask;
+
+/** set of keys with false positives, but no false negatives.
+ * Placed in front of a model lookup, a key the filter doesn't contain is
+ * certain not to be in the model, so the lookup can be skipped.
+ * Keys are 64 bit hashes of what is looked up; the bit positions for a key are
+ * derived from its hash by double hashing.
+ * Also counts queries, skipped lookups and false positives since the last report, ie. of a sentence.
+ * The counters are incremented atomically, so that lookups can run on several threads
+ */
+class BloomFilter
+{
+protected:
+	std::vector<UINT64> m_bits;
+	UINT64 m_mask; //! number of bits - 1, always a power of 2
+	unsigned int m_numHashes;
+	mutable size_t m_numQueries, m_numSkipped, m_numFalsePositives;
+
+	static UINT64 Combine(UINT64 hash, UINT64 value)
+	{
+		hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+	//! spread the bits of a combined hash, so that both halves can be used for double hashing
+	static UINT64 Finalize(UINT64 hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+public:
+	BloomFilter()
+	:m_mask(0)
+	,m_numHashes(0)
+	,m_numQueries(0)
+	,m_numSkipped(0)
+	,m_numFalsePositives(0)
+	{}
+
+	//! size for the given number of keys, with bitsPerKey bits each. 0 bits leaves the filter disabled
+	void Init(size_t numKeys, size_t bitsPerKey);
+	//! create from a list of keys, duplicates allowed
+	void Init(std::vector<UINT64> &keys, size_t bitsPerKey);
+	bool IsEnabled() const
+	{
+		return m_numHashes > 0;
+	}
+
+	void Add(UINT64 key);
+	//! false if key certainly wasn't added. Always true if not enabled
+	bool MayContain(UINT64 key) const
+	{
+		if (m_numHashes == 0)
+			return true;
+		AtomicIncrement(m_numQueries);
+		const UINT64 step = (key >> 32) | 1;
+		for (unsigned int i = 0 ; i < m_numHashes ; ++i)
+		{
+			const UINT64 bit = (key + i * step) & m_mask;
+			if ((m_bits[bit >> 6] & ((UINT64) 1 << (bit & 63))) == 0)
+			{
+				AtomicIncrement(m_numSkipped);
+				return false;
+			}
+		}
+		return true;
+	}
+	//! the lookup after MayContain() returned true found nothing
+	void AddFalsePositive() const
+	{
+		AtomicIncrement(m_numFalsePositives);
+	}
+
+	bool Save(const std::string &filePath) const;
+	bool Load(const std::string &filePath);
+
+	size_t GetNumQueries() const
+	{
+		return m_numQueries;
+	}
+	size_t GetNumSkipped() const
+	{
+		return m_numSkipped;
+	}
+	size_t GetNumFalsePositives() const
+	{
+		return m_numFalsePositives;
+	}
+	//! write counters to stderr at verbose level 2, prefixed with name of the model, and reset them. Nothing is written if there were no queries
+	void Report(const std::string &name) const;
+
+	//! key for the factor ids of a sequence of factors. Only valid in the process which created the factors
+	static UINT64 GetKey(const Factor * const *factors, size_t numFactors);
+	//! key for the factor ids of a phrase, using the factors in mask. Only valid in the process which created the factors
+	static UINT64 GetKey(const Phrase &phrase, const FactorMask &mask);
+	//! key for a phrase of words as written in a phrase table. Can be stored in a file
+	static UINT64 GetKey(const std::vector<std::string> &words);
+};
+
+}
+
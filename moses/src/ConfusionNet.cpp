@@ -10,17 +10,20 @@
 #include "StaticData.h"
 #include "Sentence.h"
 #include "UserMessage.h"
+#include "Thread.h"
 
 namespace Moses
 {
 struct CNStats {
-	size_t created,destr,read,colls,words;
+	// with async-io, nets are created on the reader thread and destroyed on the decoding threads
+	volatile size_t created,destr;
+	size_t read,colls,words;
 
 	CNStats() : created(0),destr(0),read(0),colls(0),words(0) {}
 	~CNStats() {print(std::cerr);}
 
-	void createOne() {++created;}
-	void destroyOne() {++destr;}
+	void createOne() {AtomicIncrement(created);}
+	void destroyOne() {AtomicIncrement(destr);}
 
 	void collect(const ConfusionNet& cn)
 	{
@@ -225,6 +228,72 @@ std::ostream& operator<<(std::ostream& out,const ConfusionNet& cn)
 	cn.Print(out);return out;
 }
 
+namespace
+{
+// log(exp(x)+exp(y))
+double AddLogScale(double x,double y)
+{
+	if(x>y) std::swap(x,y);
+	return y+log(1.0+exp(x-y));
+}
+
+void PrintCounts(std::ostream& out,const char* name,const std::vector<size_t>& counts,size_t maxLength)
+{
+	out<<name;
+	for(size_t len=1;len<=maxLength;++len)
+		out<<(len<counts.size() ? counts[len] : 0)<<" \t";
+	out<<"\n";
+}
+}
+
+void ConfusionNetPathStats::AddPaths(const ConfusionNet& cn)
+{
+	const size_t srcSize=cn.GetSize();
+	if(m_1Best.size()<=srcSize) m_1Best.resize(srcSize+1,0);
+	if(m_full.size()<=srcSize) m_full.resize(srcSize+1,-1.0);
+
+	for(size_t len=1;len<=srcSize;++len)
+		{
+			m_1Best[len]+=srcSize-len+1;
+			for(size_t i=0;i<=srcSize-len;++i)
+				{
+					double pd=0.0; for(size_t k=i;k<i+len;++k) pd+=log(1.0*cn[k].size());
+					m_full[len]=(m_full[len]>=0.0 ? AddLogScale(pd,m_full[len]) : pd);
+				}
+		}
+}
+
+void ConfusionNetPathStats::Add(const ConfusionNetPathStats& other)
+{
+	for(size_t len=1;len<other.m_1Best.size();++len)
+		Increment(m_1Best,len,other.m_1Best[len]);
+	if(m_full.size()<other.m_full.size()) m_full.resize(other.m_full.size(),-1.0);
+	for(size_t len=1;len<other.m_full.size();++len)
+		{
+			if(other.m_full[len]>=0.0)
+				m_full[len]=(m_full[len]>=0.0 ? AddLogScale(m_full[len],other.m_full[len]) : other.m_full[len]);
+		}
+	for(size_t len=1;len<other.m_explored.size();++len)
+		Increment(m_explored,len,other.m_explored[len]);
+	for(size_t len=1;len<other.m_recombined.size();++len)
+		Increment(m_recombined,len,other.m_recombined[len]);
+	for(size_t len=1;len<other.m_pruned.size();++len)
+		Increment(m_pruned,len,other.m_pruned[len]);
+}
+
+void ConfusionNetPathStats::Print(std::ostream& out) const
+{
+	const size_t maxLength=GetMaxLength();
+	PrintCounts(out,"1-best:          ",m_1Best,maxLength);
+	out<<"CN (full):       ";
+	for(size_t len=1;len<=maxLength;++len)
+		out<<(m_full[len]>=0.0 ? exp(m_full[len]) : 0.0)<<" \t";
+	out<<"\n";
+	PrintCounts(out,"CN (explored):   ",m_explored,maxLength);
+	PrintCounts(out,"CN (recombined): ",m_recombined,maxLength);
+	PrintCounts(out,"CN (pruned):     ",m_pruned,maxLength);
+}
+
 TranslationOptionCollection* 
 ConfusionNet::CreateTranslationOptionCollection() const 
 {
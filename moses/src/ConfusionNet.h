@@ -56,6 +56,54 @@ class ConfusionNet : public InputType {
 
 std::ostream& operator<<(std::ostream& out,const ConfusionNet& cn);
 
+/** counts of the paths through confusion networks, by number of columns spanned,
+ * when the source phrases of the paths are looked up in a phrase table.
+ * Paths are explored as long as they match a prefix of a source phrase. An explored path
+ * is recombined with another one ending in the same prefix, which is the same source phrase,
+ * over the same span. Of the two the one with the better input score is kept.
+ * Paths whose input score is too far below the best path of their span are pruned
+ */
+class ConfusionNetPathStats
+{
+protected:
+	std::vector<size_t> m_1Best; //! paths through the 1-best words, ie. spans
+	std::vector<double> m_full; //! log of the number of all paths, -1 if none
+	std::vector<size_t> m_explored, m_recombined, m_pruned;
+
+	static void Increment(std::vector<size_t> &counts, size_t length, size_t count=1)
+	{
+		if(counts.size()<=length) counts.resize(length+1,0);
+		counts[length]+=count;
+	}
+	static size_t Get(const std::vector<size_t> &counts, size_t length)
+	{
+		return (length<counts.size()) ? counts[length] : 0;
+	}
+
+public:
+	//! count the 1-best and all paths of every span of cn
+	void AddPaths(const ConfusionNet &cn);
+	void AddExplored(size_t length) {Increment(m_explored,length);}
+	void AddRecombined(size_t length) {Increment(m_recombined,length);}
+	void AddPruned(size_t length) {Increment(m_pruned,length);}
+	void Add(const ConfusionNetPathStats &other);
+
+	size_t GetNum1Best(size_t length) const {return Get(m_1Best,length);}
+	size_t GetNumExplored(size_t length) const {return Get(m_explored,length);}
+	size_t GetNumRecombined(size_t length) const {return Get(m_recombined,length);}
+	size_t GetNumPruned(size_t length) const {return Get(m_pruned,length);}
+	//! explored paths which were neither recombined nor pruned
+	size_t GetNumSurviving(size_t length) const
+	{
+		return GetNumExplored(length)-GetNumRecombined(length)-GetNumPruned(length);
+	}
+	//! longest span counted
+	size_t GetMaxLength() const {return m_1Best.empty() ? 0 : m_1Best.size()-1;}
+
+	//! one line per count, with the counts of each length from 1
+	void Print(std::ostream &out) const;
+};
+
 
 }
 
@@ -19,12 +19,17 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+#include <cmath>
 #include "DecodeStepGeneration.h"
 #include "GenerationDictionary.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
 #include "PartialTranslOptColl.h"
 #include "FactorCollection.h"
+#include "LanguageModel.h"
+#include "LMList.h"
+#include "StaticData.h"
 
 namespace Moses
 {
@@ -51,30 +56,165 @@ TranslationOption *DecodeStepGeneration::MergeGeneration(const TranslationOption
   return newTransOpt;
 }
 
-// helpers
-typedef pair<Word, ScoreComponentCollection> WordPair;
-typedef list< WordPair > WordList;
-// 1st = word
-// 2nd = score
-typedef list< WordPair >::const_iterator WordListIterator;
+namespace
+{
+/** expands a partial translation option with all combinations of the generation alternatives of its words.
+ * The alternatives of all words are flattened into arrays. Combinations are enumerated in the same order
+ * as an odometer with the first word turning fastest, and their score is bounded from above before they are
+ * created: once the collection of partial translation options has been pruned, combinations, or whole
+ * blocks of them sharing the alternatives of the later words, that can't reach its worst score are skipped
+ */
+class GenerationExpansion
+{
+protected:
+	const DecodeStepGeneration &m_step;
+	const TranslationOption &m_input;
+	PartialTranslOptColl &m_output;
+	size_t m_length; //! of the target phrase
+
+	// alternatives of word pos are m_words[m_begin[pos]] to m_words[m_begin[pos + 1] - 1]
+	std::vector<size_t> m_begin;
+	std::vector<const Word*> m_words;
+	std::vector<const ScoreComponentCollection*> m_scores;
+	std::vector<float> m_weightedScores; //! weighted generation score of each alternative
+
+	bool m_bounded; //! whether the LM weights allow bounding scores
+	float m_baseBound; //! upper bound of the score of any combination, without the generation scores
+	std::vector<float> m_bestBelow; //! sum of the best weighted generation scores of the words before pos
+	std::vector<size_t> m_numBelow; //! number of combinations of the words before pos
+
+	std::vector<size_t> m_choice; //! alternative chosen for each word
+	std::vector<const Word*> m_mergeWords;
+	ScoreComponentCollection m_generationScore;
+
+	//! whether a combination whose score is at most bound would be pruned by m_output anyway
+	bool IsPruned(float bound) const
+	{
+		// the bound sums the scores in a different order than CalcScore(), leave room for rounding
+		const float worstScore = m_output.GetWorstScore();
+		return m_bounded && bound < worstScore - 0.001f * (1.0f + std::fabs(worstScore));
+	}
+	void Create();
+	void Expand(size_t pos, float generationScore);
+
+public:
+	GenerationExpansion(const DecodeStepGeneration &step, const TranslationOption &input, PartialTranslOptColl &output)
+	:m_step(step)
+	,m_input(input)
+	,m_output(output)
+	,m_length(input.GetTargetPhrase().GetSize())
+	,m_bounded(false)
+	,m_baseBound(0)
+	{}
+
+	//! false if a word has no generation
+	bool Init(const GenerationDictionary &generationDictionary);
+	void Expand()
+	{
+		Expand(m_length - 1, 0);
+	}
+};
 
-/** used in generation: increases iterators when looping through the exponential number of generation expansions */
-inline void IncrementIterators(vector< WordListIterator > &wordListIterVector
-                               , const vector< WordList > &wordListVector)
+bool GenerationExpansion::Init(const GenerationDictionary &generationDictionary)
 {
-  for (size_t currPos = 0 ; currPos < wordListVector.size() ; currPos++)
-    {
-      WordListIterator &iter = wordListIterVector[currPos];
-      iter++;
-      if (iter != wordListVector[currPos].end())
-        { // eg. 4 -> 5
-          return;
-        }
-      else
-        { //  eg 9 -> 10
-          iter = wordListVector[currPos].begin();
-        }
-    }
+	const std::vector<float> &weights = StaticData::Instance().GetAllWeights();
+	const Phrase &targetPhrase = m_input.GetTargetPhrase();
+
+	// flatten alternatives
+	m_begin.resize(m_length + 1);
+	for (size_t pos = 0 ; pos < m_length ; ++pos)
+	{
+		m_begin[pos] = m_words.size();
+		// consult dictionary for possible generations for this word
+		const OutputWordCollection *wordColl = generationDictionary.FindWord(targetPhrase.GetWord(pos));
+		if (wordColl == NULL)
+			return false; // can't be part of a phrase, special handling
+
+		OutputWordCollection::const_iterator iterWordColl;
+		for (iterWordColl = wordColl->begin() ; iterWordColl != wordColl->end(); ++iterWordColl)
+		{
+			m_words.push_back(&iterWordColl->first);
+			m_scores.push_back(&iterWordColl->second);
+			m_weightedScores.push_back(iterWordColl->second.InnerProduct(weights));
+		}
+	}
+	m_begin[m_length] = m_words.size();
+
+	// best and number of combinations of the words before each word
+	m_bestBelow.resize(m_length);
+	m_numBelow.resize(m_length);
+	float bestBelow = 0;
+	size_t numBelow = 1;
+	for (size_t pos = 0 ; pos < m_length ; ++pos)
+	{
+		m_bestBelow[pos] = bestBelow;
+		m_numBelow[pos] = numBelow;
+		bestBelow += *std::max_element(m_weightedScores.begin() + m_begin[pos], m_weightedScores.begin() + m_begin[pos + 1]);
+		numBelow *= m_begin[pos + 1] - m_begin[pos];
+	}
+
+	/* The score of a combination is that of its breakdown, with the LM scores recalculated on the new phrase.
+	 * An LM which can be used on the new phrase adds at most 0, its weighted log probabilities are negative
+	 * for positive weights. One which can't keeps its score in the breakdown
+	 */
+	m_bounded = true;
+	ScoreComponentCollection nonLMScores = m_input.GetScoreBreakdown();
+	float lmBound = 0;
+	const LMList &allLM = StaticData::Instance().GetAllLM();
+	LMList::const_iterator lmIter;
+	for (lmIter = allLM.begin() ; lmIter != allLM.end() ; ++lmIter)
+	{
+		const LanguageModel &lm = **lmIter;
+		m_bounded = m_bounded && lm.GetWeight() >= 0;
+		const float withLM = nonLMScores.InnerProduct(weights);
+		nonLMScores.Assign(&lm, 0.0f);
+		lmBound += std::max(0.0f, withLM - nonLMScores.InnerProduct(weights));
+	}
+	m_baseBound = nonLMScores.InnerProduct(weights) + lmBound
+							- m_length * StaticData::Instance().GetWeightWordPenalty();
+
+	m_choice.resize(m_length);
+	m_mergeWords.resize(m_length);
+	return true;
+}
+
+void GenerationExpansion::Expand(size_t pos, float generationScore)
+{
+	for (size_t choice = m_begin[pos] ; choice < m_begin[pos + 1] ; ++choice)
+	{
+		const float score = generationScore + m_weightedScores[choice];
+		if (IsPruned(m_baseBound + score + m_bestBelow[pos]))
+		{
+			m_output.AddPrunedCount(m_numBelow[pos]);
+			continue;
+		}
+
+		m_choice[pos] = choice;
+		if (pos == 0)
+			Create();
+		else
+			Expand(pos - 1, score);
+	}
+}
+
+void GenerationExpansion::Create()
+{
+	// total score for this string of words
+	m_generationScore.ZeroAll();
+	for (size_t pos = 0 ; pos < m_length ; ++pos)
+	{
+		m_mergeWords[pos] = m_words[m_choice[pos]];
+		m_generationScore.PlusEquals(*m_scores[m_choice[pos]]);
+	}
+
+	// merge with existing trans opt
+	Phrase genPhrase(Output, m_mergeWords);
+	TranslationOption *newTransOpt = m_step.MergeGeneration(m_input, genPhrase, m_generationScore);
+	if (newTransOpt != NULL)
+	{
+		m_output.Add(newTransOpt);
+	}
+}
 }
 
 void DecodeStepGeneration::Process(const TranslationOption &inputPartialTranslOpt
@@ -94,83 +234,15 @@ void DecodeStepGeneration::Process(const TranslationOption &inputPartialTranslOp
 
   // normal generation step
   const GenerationDictionary &generationDictionary  = decodeStep.GetGenerationDictionary();
-//  const WordsRange &sourceWordsRange                = inputPartialTranslOpt.GetSourceWordsRange();
-
-  const Phrase &targetPhrase  = inputPartialTranslOpt.GetTargetPhrase();
-  size_t targetLength         = targetPhrase.GetSize();
 
   // generation list for each word in phrase
-  vector< WordList > wordListVector(targetLength);
-
-  // create generation list
-  int wordListVectorPos = 0;
-  for (size_t currPos = 0 ; currPos < targetLength ; currPos++) // going thorugh all words
-    {
-      // generatable factors for this word to be put in wordList
-      WordList &wordList = wordListVector[wordListVectorPos];
-      const Word &word = targetPhrase.GetWord(currPos);
-
-      // consult dictionary for possible generations for this word
-      const OutputWordCollection *wordColl = generationDictionary.FindWord(word);
-
-      if (wordColl == NULL)
-        { // word not found in generation dictionary
-          //toc->ProcessUnknownWord(sourceWordsRange.GetStartPos(), factorCollection);
-          return; // can't be part of a phrase, special handling
-        }
-      else
-        {
-          // sort(*wordColl, CompareWordCollScore);
-          OutputWordCollection::const_iterator iterWordColl;
-          for (iterWordColl = wordColl->begin() ; iterWordColl != wordColl->end(); ++iterWordColl)
-            {
-              const Word &outputWord = (*iterWordColl).first;
-              const ScoreComponentCollection& score = (*iterWordColl).second;
-              // enter into word list generated factor(s) and its(their) score(s)
-              wordList.push_back(WordPair(outputWord, score));
-            }
-
-          wordListVectorPos++; // done, next word
-        }
-    }
-
-  // use generation list (wordList)
-  // set up iterators (total number of expansions)
-  size_t numIteration = 1;
-  vector< WordListIterator >  wordListIterVector(targetLength);
-  vector< const Word* >       mergeWords(targetLength);
-  for (size_t currPos = 0 ; currPos < targetLength ; currPos++)
-    {
-      wordListIterVector[currPos] = wordListVector[currPos].begin();
-      numIteration *= wordListVector[currPos].size();
-    }
+  GenerationExpansion expansion(static_cast<const DecodeStepGeneration&>(decodeStep), inputPartialTranslOpt, outputPartialTranslOptColl);
+  if (!expansion.Init(generationDictionary))
+    return;
 
   // go thru each possible factor for each word & create hypothesis
-  for (size_t currIter = 0 ; currIter < numIteration ; currIter++)
-    {
-      ScoreComponentCollection generationScore; // total score for this string of words
-
-      // create vector of words with new factors for last phrase
-      for (size_t currPos = 0 ; currPos < targetLength ; currPos++)
-        {
-          const WordPair &wordPair = *wordListIterVector[currPos];
-          mergeWords[currPos] = &(wordPair.first);
-          generationScore.PlusEquals(wordPair.second);
-        }
-
-      // merge with existing trans opt
-      Phrase genPhrase(Output, mergeWords);
-      TranslationOption *newTransOpt = MergeGeneration(inputPartialTranslOpt, genPhrase, generationScore);
-      if (newTransOpt != NULL)
-        {
-          outputPartialTranslOptColl.Add(newTransOpt);
-        }
-
-      // increment iterators
-      IncrementIterators(wordListIterVector, wordListVector);
-    }
+  expansion.Expand();
 }
 
 }
 
-
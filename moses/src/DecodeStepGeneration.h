@@ -45,7 +45,6 @@ public:
                               , TranslationOptionCollection *toc
                               , bool adhereTableLimit) const;
 
-private:
 	/*! create new TranslationOption from merging oldTO with mergePhrase
 		This function runs IsCompatible() to ensure the two can be merged
 	*/
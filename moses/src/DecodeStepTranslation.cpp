@@ -100,13 +100,16 @@ void DecodeStepTranslation::Process(const TranslationOption &inputPartialTranslO
 void DecodeStepTranslation::ProcessInitialTranslation(
 															const InputType &source
 															,PartialTranslOptColl &outputPartialTranslOptColl
-															, size_t startPos, size_t endPos, bool adhereTableLimit) const
+															, size_t startPos, size_t endPos, bool adhereTableLimit
+															, PhraseDictionaryCursor *cursor) const
 {
 	const PhraseDictionary &phraseDictionary = GetPhraseDictionary();
 	const size_t tableLimit = phraseDictionary.GetTableLimit();
 
 	const WordsRange wordsRange(startPos, endPos);
-	const TargetPhraseCollection *phraseColl =	phraseDictionary.GetTargetPhraseCollection(source,wordsRange); 
+	const TargetPhraseCollection *phraseColl = (cursor == NULL)
+								? phraseDictionary.GetTargetPhraseCollection(source,wordsRange)
+								: phraseDictionary.ExtendLookup(source, wordsRange, *cursor); 
 
 	if (phraseColl != NULL)
 	{
@@ -27,6 +27,7 @@ namespace Moses
 {
 
 class PhraseDictionary;
+struct PhraseDictionaryCursor;
 class TargetPhrase;
 
 //! subclass of DecodeStep for translation step
@@ -47,11 +48,13 @@ public:
 
 	/*! initialize list of partial translation options by applying the first translation step 
 	* Ideally, this function should be in DecodeStepTranslation class
+	* \param cursor if not NULL, the phrase is looked up by extending cursor
 	*/
 	void ProcessInitialTranslation(
 															const InputType &source
 															, PartialTranslOptColl &outputPartialTranslOptColl
-															, size_t startPos, size_t endPos, bool adhereTableLimit) const;
+															, size_t startPos, size_t endPos, bool adhereTableLimit
+															, PhraseDictionaryCursor *cursor = NULL) const;
 private:
 	/*! create new TranslationOption from merging oldTO with mergePhrase
 		This function runs IsCompatible() to ensure the two can be merged
@@ -23,8 +23,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "FactorCollection.h"
 #include "LanguageModel.h"
+#include "InputFileStream.h"
 #include "Util.h"
 
 using namespace std;
@@ -33,57 +35,147 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
+//! initial number of slots in the hash table
+const size_t INITIAL_TABLE_SIZE = 1 << 16;
+
+FactorCollection::Table::Table(size_t size, Table *prev)
+:m_size(size)
+,m_slots(new const Factor*[size])
+,m_prev(prev)
+{
+	std::fill(m_slots, m_slots + m_size, (const Factor*) NULL);
+}
+
+FactorCollection::Table::~Table()
+{
+	delete [] m_slots;
+	delete m_prev;
+}
+
+FactorCollection::FactorCollection()
+:m_table(new Table(INITIAL_TABLE_SIZE, NULL))
+,m_factorId(0)
+,m_stringPool("FactorString", 10000)
+,m_factorPool("Factor", 10000)
+{}
+
 void FactorCollection::LoadVocab(FactorDirection direction, FactorType factorType, const string &filePath)
 {
-	ifstream 	inFile(filePath.c_str());
+	InputFileStream 	inFile(filePath);
 
 	string line;
 	
-	while( !getline(inFile, line, '\n').eof())
+	while(getline(inFile, line))
 	{
 		vector<string> token = Tokenize( line );
-		if (token.size() < 2) 
+		if (token.empty()) 
 		{
 			continue;
 		}		
 		// looks like good line
-		AddFactor(direction, factorType, token[1]);
+		AddFactor(direction, factorType, token.back());
 	}
 }
 
-bool FactorCollection::Exists(FactorDirection direction, FactorType factorType, const string &factorString)
+const Factor *FactorCollection::Find(const Table &table, const string &factorString, unsigned int hash)
 {
-	// find string id
-	const string *ptrString=&(*m_factorStringCollection.insert(factorString).first);
+	const size_t mask = table.m_size - 1;
+	for (size_t slot = hash & mask ; ; slot = (slot + 1) & mask)
+	{
+		const Factor *factor = table.m_slots[slot];
+		if (factor == NULL)
+			return NULL;
+		if (factor->GetString() == factorString)
+			return factor;
+	}
+}
+
+void FactorCollection::Grow(size_t minSize)
+{
+	Table *oldTable = m_table;
+	size_t size = oldTable->m_size;
+	while (size < minSize)
+		size *= 2;
+	if (size == oldTable->m_size)
+		return;
+
+	Table *newTable = new Table(size, oldTable);
+	const size_t mask = size - 1;
+	for (size_t i = 0 ; i < oldTable->m_size ; ++i)
+	{
+		const Factor *factor = oldTable->m_slots[i];
+		if (factor == NULL)
+			continue;
+		size_t slot = Hash(factor->GetString()) & mask;
+		while (newTable->m_slots[slot] != NULL)
+			slot = (slot + 1) & mask;
+		newTable->m_slots[slot] = factor;
+	}
 
-	FactorSet::const_iterator iterFactor;
-	Factor search(direction, factorType, ptrString); // id not used for searching
+	// readers still probing the old table are safe, it is only deleted with the collection
+	MemoryFence();
+	m_table = newTable;
+}
 
-	iterFactor = m_collection.find(search);
-	return iterFactor != m_collection.end();
+bool FactorCollection::Exists(FactorDirection /*direction*/, FactorType /*factorType*/, const string &factorString) const
+{
+	return Find(*m_table, factorString, Hash(factorString)) != NULL;
 }
 
 const Factor *FactorCollection::AddFactor(FactorDirection direction
 																				, FactorType 			factorType
 																				, const string 		&factorString)
 {
-	// find string id
-	const string *ptrString=&(*m_factorStringCollection.insert(factorString).first);
-	pair<FactorSet::iterator, bool> ret = m_collection.insert( Factor(direction, factorType, ptrString, m_factorId) );
-	if (ret.second)
-		++m_factorId; // new factor, make sure next new factor has diffrernt id
-		
-	const Factor *factor = &(*ret.first);
+	const unsigned int hash = Hash(factorString);
+	const Factor *factor = Find(*m_table, factorString, hash);
+	if (factor != NULL)
+		return factor;
+
+	ScopedLock lock(m_addLock);
+
+	// keep the load factor below 1/2 so probe sequences stay short
+	if (2 * (m_factorId + 1) > m_table->m_size)
+		Grow(2 * m_table->m_size);
+
+	// another thread may have added it while we waited for the lock
+	Table &table = *m_table;
+	const size_t mask = table.m_size - 1;
+	size_t slot = hash & mask;
+	for ( ; table.m_slots[slot] != NULL ; slot = (slot + 1) & mask)
+	{
+		if (table.m_slots[slot]->GetString() == factorString)
+			return table.m_slots[slot];
+	}
+
+	const string *ptrString = new (m_stringPool.getPtr()) string(factorString);
+	factor = new (m_factorPool.getPtr()) Factor(direction, factorType, ptrString, m_factorId);
+	++m_factorId; // new factor, make sure next new factor has diffrernt id
+	m_factorsById.push_back(factor);
+
+	// factor must be fully constructed before it becomes visible to lock-free readers
+	MemoryFence();
+	table.m_slots[slot] = factor;
 	return factor;
 }
 
+void FactorCollection::GetFactors(size_t firstId, vector<const Factor*> &factors)
+{
+	ScopedLock lock(m_addLock);
+	if (firstId < m_factorsById.size())
+		factors.insert(factors.end(), m_factorsById.begin() + firstId, m_factorsById.end());
+}
+
+void FactorCollection::Freeze()
+{
+	ScopedLock lock(m_addLock);
+	// leave room for the test vocabulary, about as much again as the models
+	Grow(4 * (m_factorId + 1));
+}
+
 FactorCollection::~FactorCollection()
 {
-	//FactorSet::iterator iter;
-	//for (iter = m_collection.begin() ; iter != m_collection.end() ; iter++)
-	//{
-	//	delete (*iter);
-	//}
+	delete m_table;
+	// factors and their strings are destroyed with the pools
 }
 
 TO_STRING_BODY(FactorCollection);
@@ -91,17 +183,15 @@ TO_STRING_BODY(FactorCollection);
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
-	FactorSet::const_iterator iterFactor;
+	const FactorCollection::Table &table = *factorCollection.m_table;
 
-	for (iterFactor = factorCollection.m_collection.begin() ; iterFactor != factorCollection.m_collection.end() ; ++iterFactor)
+	for (size_t slot = 0 ; slot < table.m_size ; ++slot)
 	{
-		const Factor &factor 	= *iterFactor;
-		out << factor;
+		if (table.m_slots[slot] != NULL)
+			out << *table.m_slots[slot];
 	}
 
 	return out;
 }
 
 }
-
-
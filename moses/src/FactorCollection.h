@@ -21,18 +21,17 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #pragma once
 
-#include <set>
 #include <string>
+#include <vector>
 #include "Factor.h"
+#include "ObjectPool.h"
+#include "Thread.h"
 
 namespace Moses
 {
 
 class LanguageModel;
 
-typedef std::set<Factor> FactorSet;
-typedef std::set<std::string> StringSet;
-
 /** collection of factors
  *
  * All Factors in moses are accessed and created by a FactorCollection.
@@ -40,6 +39,13 @@ typedef std::set<std::string> StringSet;
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * Factors are interned in an open addressing hash table keyed on the factor
+ * string. Slots are only ever filled, never emptied, and a full table is
+ * replaced rather than rehashed in place, so lookups need no lock. Adding a
+ * new factor takes a mutex, which keeps the ids contiguous.
+ * The factor strings and the factors themselves live in pools, so their
+ * addresses never change once created.
  */
 class FactorCollection
 {
@@ -48,14 +54,35 @@ class FactorCollection
 protected:
 	static FactorCollection s_instance;
 
+	//! one generation of the hash table. Superseded tables are kept alive for concurrent readers
+	struct Table
+	{
+		size_t m_size; /**< number of slots, always a power of 2 */
+		const Factor * volatile *m_slots;
+		Table *m_prev; /**< table this one replaced */
+
+		Table(size_t size, Table *prev);
+		~Table();
+	};
+
+	Table * volatile m_table; /**< current table */
 	size_t		m_factorId; /**< unique, contiguous ids, starting from 0, for each factor */	
-	FactorSet m_collection; /**< collection of all factors */
-	StringSet m_factorStringCollection; /**< collection of unique string used by factors */
+	ObjectPool<std::string> m_stringPool; /**< unique strings used by factors */
+	ObjectPool<Factor> m_factorPool; /**< collection of all factors */
+	std::vector<const Factor*> m_factorsById; /**< all factors, indexed by id. Guarded by m_addLock */
+	Mutex			m_addLock; /**< serialises insertion of new factors */
 
 	//! constructor. only the 1 static variable can be created
-	FactorCollection()
-	:m_factorId(0)
-	{}
+	FactorCollection();
+
+	static unsigned int Hash(const std::string &factorString)
+	{
+		return quick_hash(factorString.data(), factorString.size(), 0);
+	}
+	//! lock-free probe of a single table. NULL if the string hasn't been interned there
+	static const Factor *Find(const Table &table, const std::string &factorString, unsigned int hash);
+	//! replace the current table with one of at least minSize slots. Caller must hold m_addLock
+	void Grow(size_t minSize);
 
 public:		
 	static FactorCollection& Instance() { return s_instance; }
@@ -64,13 +91,27 @@ public:
 	~FactorCollection();
 
 	//! Test to see whether a factor exists
-	bool Exists(FactorDirection direction, FactorType factorType, const std::string &factorString);	
+	bool Exists(FactorDirection direction, FactorType factorType, const std::string &factorString) const;
 	/** returns a factor with the same direction, factorType and factorString. 
 	*	If a factor already exist in the collection, return the existing factor, if not create a new 1
 	*/
 	const Factor *AddFactor(FactorDirection direction, FactorType factorType, const std::string &factorString);	
-	//! Load list of factors. Deprecated
+	/** Load list of factors, 1 per line, optionally preceded by an id.
+	 *	Pre-populates the vocabulary for input which is only read on demand, eg. binary phrase tables
+	 */
 	void LoadVocab(FactorDirection direction, FactorType factorType, const std::string &filePath);
+
+	/** called once the models are loaded. Makes room so that interning the words of the input
+	 * does not have to replace the table during decoding
+	 */
+	void Freeze();
+	//! append the factors with id firstId and above to factors, in order of id
+	void GetFactors(size_t firstId, std::vector<const Factor*> &factors);
+	//! number of factors created so far, and 1 more than the highest id
+	size_t GetSize() const
+	{
+		return m_factorId;
+	}
 	
 	TO_STRING();
 	
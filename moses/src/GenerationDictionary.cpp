@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "InputFileStream.h"
 #include "StaticData.h"
 #include "UserMessage.h"
+#include "LoadFilter.h"
 
 using namespace std;
 
@@ -45,6 +46,7 @@ bool GenerationDictionary::Load(const std::vector<FactorType> &input
 																			, FactorDirection direction)
 {	
 	FactorCollection &factorCollection = FactorCollection::Instance();
+	const LoadFilter *loadFilter = StaticData::Instance().GetLoadFilter();
 
 	const size_t numFeatureValuesInConfig = this->GetNumScoreComponents();
 
@@ -62,11 +64,18 @@ bool GenerationDictionary::Load(const std::vector<FactorType> &input
 
 	m_filePath = filePath;
 	string line;
-	size_t lineNum = 0;
+	size_t lineNum = 0, numFiltered = 0;
 	while(getline(inFile, line)) 
 	{
 		++lineNum;
 		vector<string> token = Tokenize( line );
+		vector<string> factorString = Tokenize( token[0], "|" );
+
+		if (loadFilter != NULL && !loadFilter->KeepGenerationEntry(factorString, input))
+		{
+			++numFiltered;
+			continue;
+		}
 		
 		// add each line in generation file into class
 		Word *inputWord = new Word();  // deleted in destructor
@@ -75,7 +84,6 @@ bool GenerationDictionary::Load(const std::vector<FactorType> &input
 		// create word with certain factors filled out
 
 		// inputs
-		vector<string> factorString = Tokenize( token[0], "|" );
 		for (size_t i = 0 ; i < input.size() ; i++)
 		{
 			FactorType factorType = input[i];
@@ -117,6 +125,9 @@ bool GenerationDictionary::Load(const std::vector<FactorType> &input
 	}
 
 	inFile.Close();
+
+	if (loadFilter != NULL)
+		VERBOSE(1, "Filtered " << numFiltered << " of " << lineNum << " generation entries from " << filePath << endl);
 	return true;
 }
 
@@ -43,8 +43,8 @@ typedef std::map < Word , ScoreComponentCollection > OutputWordCollection;
  */
 class GenerationDictionary : public Dictionary, public StatelessFeatureFunction
 {
-	typedef std::map<const Word* , OutputWordCollection, WordComparer> Collection;
 protected:
+	typedef std::map<const Word* , OutputWordCollection, WordComparer> Collection;
 	Collection m_collection;
 	// 1st = source
 	// 2nd = target
@@ -64,7 +64,7 @@ public:
 	}
 	
 	//! load data file
-	bool Load(const std::vector<FactorType> &input
+	virtual bool Load(const std::vector<FactorType> &input
 									, const std::vector<FactorType> &output
 									, const std::string &filePath
 									, FactorDirection direction);
@@ -75,14 +75,15 @@ public:
 	/** number of unique input entries in the generation table. 
 	* NOT the number of lines in the generation table
 	*/
-	size_t GetSize() const
+	virtual size_t GetSize() const
 	{
 		return m_collection.size();
 	}
 	/** returns a bag of output words, OutputWordCollection, for a particular input word. 
-	*	Or NULL if the input word isn't found. The search function used is the WordComparer functor
+	*	Or NULL if the input word isn't found. The search function used is the WordComparer functor.
+	*	Safe to call from several threads: here it only reads the map, the binary dictionary locks its cache
 	*/
-	const OutputWordCollection *FindWord(const Word &word) const;
+	virtual const OutputWordCollection *FindWord(const Word &word) const;
 	virtual bool ComputeValueInTranslationOption() const;
 };
 
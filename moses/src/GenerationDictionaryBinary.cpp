@@ -0,0 +1,348 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <cstring>
+#include <map>
+#include <set>
+#include "GenerationDictionaryBinary.h"
+#include "FactorCollection.h"
+#include "File.h"
+#include "StaticData.h"
+#include "UserMessage.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+const char GenerationDictionaryBinary::MAGIC[8] = { 'M', 'o', 's', 'e', 's', 'G', 'e', 'n' };
+
+namespace
+{
+UINT64 Align(UINT64 offset)
+{
+	return (offset + 7) & ~(UINT64) 7;
+}
+}
+
+GenerationDictionaryBinary::Sections::Sections(const Header &header)
+{
+	m_stringBegin = Align(sizeof(Header));
+	m_strings = Align(m_stringBegin + (header.m_numStrings + 1) * sizeof(UINT64));
+	m_entryKeys = Align(m_strings + header.m_stringSize);
+	m_entryBegin = Align(m_entryKeys + header.m_numEntries * header.m_numInputFactors * sizeof(UINT32));
+	m_outputKeys = Align(m_entryBegin + (header.m_numEntries + 1) * sizeof(UINT64));
+	m_scores = Align(m_outputKeys + header.m_numOutputs * header.m_numOutputFactors * sizeof(UINT32));
+	m_end = m_scores + header.m_numOutputs * header.m_numScores * sizeof(float);
+}
+
+GenerationDictionaryBinary::~GenerationDictionaryBinary()
+{
+	CleanUp();
+}
+
+void GenerationDictionaryBinary::CleanUp()
+{
+	ScopedWriteLock lock(m_cacheLock);
+	Collection::const_iterator iter;
+	for (iter = m_cache.begin() ; iter != m_cache.end() ; ++iter)
+	{
+		delete iter->first;
+	}
+	m_cache.clear();
+}
+
+bool GenerationDictionaryBinary::Load(const std::vector<FactorType> &input
+																			, const std::vector<FactorType> &output
+																			, const std::string &filePath
+																			, FactorDirection direction)
+{
+	m_inputFactors = FactorMask(input);
+	m_outputFactors = FactorMask(output);
+	m_input = input;
+	m_output = output;
+	m_direction = direction;
+	m_filePath = filePath;
+	VERBOSE(2,"GenerationDictionaryBinary: input=" << m_inputFactors << "  output=" << m_outputFactors << std::endl);
+
+	const string binFilePath = filePath + ".bingen";
+	if (!m_file.Open(binFilePath))
+	{
+		UserMessage::Add(string("Couldn't read ") + binFilePath);
+		return false;
+	}
+
+	m_header = reinterpret_cast<const Header*>(m_file.GetData());
+	if (m_file.GetSize() < sizeof(Header) || memcmp(m_header->m_magic, MAGIC, sizeof(MAGIC)) != 0
+			|| m_file.GetSize() != Sections(*m_header).m_end)
+	{
+		UserMessage::Add(binFilePath + " is not a binary generation table, or is truncated");
+		return false;
+	}
+	if (m_header->m_numInputFactors != input.size() || m_header->m_numOutputFactors != output.size())
+	{
+		stringstream strme;
+		strme << binFilePath << ": has " << m_header->m_numInputFactors << " input and " << m_header->m_numOutputFactors
+					<< " output factors, but " << input.size() << " and " << output.size() << " are specified";
+		UserMessage::Add(strme.str());
+		return false;
+	}
+	if (m_header->m_numScores < GetNumScoreComponents())
+	{
+		stringstream strme;
+		strme << binFilePath << ": expected " << GetNumScoreComponents()
+					<< " feature values, but found " << m_header->m_numScores;
+		UserMessage::Add(strme.str());
+		return false;
+	}
+
+	const Sections sections(*m_header);
+	const char *data = m_file.GetData();
+	m_stringBegin = reinterpret_cast<const UINT64*>(data + sections.m_stringBegin);
+	m_strings = data + sections.m_strings;
+	m_entryKeys = reinterpret_cast<const UINT32*>(data + sections.m_entryKeys);
+	m_entryBegin = reinterpret_cast<const UINT64*>(data + sections.m_entryBegin);
+	m_outputKeys = reinterpret_cast<const UINT32*>(data + sections.m_outputKeys);
+	m_scores = reinterpret_cast<const float*>(data + sections.m_scores);
+
+	VERBOSE(1, "Mapped " << m_header->m_numEntries << " generation entries from " << binFilePath << endl);
+	return true;
+}
+
+bool GenerationDictionaryBinary::FindString(const string &str, UINT32 &id) const
+{
+	size_t begin = 0, end = (size_t) m_header->m_numStrings;
+	while (begin < end)
+	{
+		const size_t middle = begin + (end - begin) / 2;
+		const int comp = str.compare(0, string::npos, m_strings + m_stringBegin[middle]
+																, (size_t) (m_stringBegin[middle + 1] - m_stringBegin[middle]));
+		if (comp == 0)
+		{
+			id = (UINT32) middle;
+			return true;
+		}
+		if (comp < 0)
+			end = middle;
+		else
+			begin = middle + 1;
+	}
+	return false;
+}
+
+bool GenerationDictionaryBinary::FindEntry(const UINT32 *ids, size_t &entry) const
+{
+	const size_t numFactors = m_input.size();
+	size_t begin = 0, end = (size_t) m_header->m_numEntries;
+	while (begin < end)
+	{
+		const size_t middle = begin + (end - begin) / 2;
+		const UINT32 *keys = m_entryKeys + middle * numFactors;
+		size_t i = 0;
+		while (i < numFactors && keys[i] == ids[i])
+			++i;
+		if (i == numFactors)
+		{
+			entry = middle;
+			return true;
+		}
+		if (ids[i] < keys[i])
+			end = middle;
+		else
+			begin = middle + 1;
+	}
+	return false;
+}
+
+void GenerationDictionaryBinary::CreateOutputWords(size_t entry, OutputWordCollection &outputWords) const
+{
+	FactorCollection &factorCollection = FactorCollection::Instance();
+	const size_t numFactors = m_output.size(), numScoresInFile = m_header->m_numScores;
+	std::vector<float> scores(GetNumScoreComponents());
+
+	for (UINT64 output = m_entryBegin[entry] ; output < m_entryBegin[entry + 1] ; ++output)
+	{
+		Word outputWord;
+		const UINT32 *keys = m_outputKeys + output * numFactors;
+		for (size_t i = 0 ; i < numFactors ; ++i)
+			outputWord.SetFactor(m_output[i], factorCollection.AddFactor(m_direction, m_output[i], GetString(keys[i])));
+
+		const float *score = m_scores + output * numScoresInFile;
+		std::copy(score, score + scores.size(), scores.begin());
+		outputWords[outputWord].Assign(this, scores);
+	}
+}
+
+const OutputWordCollection *GenerationDictionaryBinary::FindWord(const Word &word) const
+{
+	{
+		ScopedReadLock lock(m_cacheLock);
+		Collection::const_iterator iter = m_cache.find(&word);
+		if (iter != m_cache.end())
+		{ // looked up before. Words not in the table have no output words
+			return iter->second.empty() ? NULL : &iter->second;
+		}
+	}
+
+	// only the input factors are used as key, like in the text table
+	Word *inputWord = new Word(); // deleted in CleanUp()
+	UINT32 ids[MAX_NUM_FACTORS];
+	bool found = true;
+	for (size_t i = 0 ; i < m_input.size() ; ++i)
+	{
+		const Factor *factor = word.GetFactor(m_input[i]);
+		inputWord->SetFactor(m_input[i], factor);
+		found = found && factor != NULL && FindString(factor->GetString(), ids[i]);
+	}
+
+	OutputWordCollection outputWords;
+	size_t entry;
+	if (found && FindEntry(ids, entry))
+		CreateOutputWords(entry, outputWords);
+
+	ScopedWriteLock lock(m_cacheLock);
+	std::pair<Collection::iterator, bool> inserted = m_cache.insert(std::make_pair(inputWord, OutputWordCollection()));
+	if (inserted.second)
+		inserted.first->second.swap(outputWords);
+	else
+		delete inputWord; // another thread looked the word up meanwhile
+	const OutputWordCollection &cachedWords = inserted.first->second;
+	return cachedWords.empty() ? NULL : &cachedWords;
+}
+
+bool GenerationDictionaryBinary::Create(istream &inFile, const string &outFilePath)
+{
+	// output words and their scores, for each input word, each as a list of factor strings
+	typedef map<vector<string>, vector<float> > Outputs;
+	typedef map<vector<string>, Outputs> Entries;
+	Entries entries;
+	set<string> strings;
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+
+	string line;
+	size_t lineNum = 0;
+	while (getline(inFile, line))
+	{
+		++lineNum;
+		vector<string> token = Tokenize(line);
+		if (token.empty())
+			continue;
+		if (token.size() < 2)
+		{
+			cerr << "line " << lineNum << ": expected input and output word" << endl;
+			return false;
+		}
+		vector<string> inputStr = Tokenize(token[0], "|")
+									, outputStr = Tokenize(token[1], "|");
+		if (header.m_numInputFactors == 0)
+		{ // the first entry determines the number of factors and scores
+			header.m_numInputFactors = inputStr.size();
+			header.m_numOutputFactors = outputStr.size();
+			header.m_numScores = token.size() - 2;
+		}
+		if (inputStr.size() != header.m_numInputFactors || outputStr.size() != header.m_numOutputFactors
+				|| token.size() - 2 != header.m_numScores)
+		{
+			cerr << "line " << lineNum << ": expected " << header.m_numInputFactors << " input factors, "
+						<< header.m_numOutputFactors << " output factors and " << header.m_numScores
+						<< " scores, like the first line" << endl;
+			return false;
+		}
+
+		// a repeated entry replaces the earlier one, as when the text table is loaded
+		vector<float> &scores = entries[inputStr][outputStr];
+		scores.resize(header.m_numScores);
+		for (size_t i = 0 ; i < scores.size() ; ++i)
+			scores[i] = FloorScore(TransformScore(Scan<float>(token[2 + i])));
+		strings.insert(inputStr.begin(), inputStr.end());
+		strings.insert(outputStr.begin(), outputStr.end());
+	}
+
+	// ids are positions in the sorted strings, so the entries sorted on their strings are sorted on the ids too
+	map<string, UINT32> ids;
+	vector<UINT64> stringBegin(1, 0);
+	for (set<string>::const_iterator iter = strings.begin() ; iter != strings.end() ; ++iter)
+	{
+		ids.insert(make_pair(*iter, (UINT32) ids.size()));
+		stringBegin.push_back(stringBegin.back() + iter->size());
+	}
+
+	vector<UINT32> entryKeys, outputKeys;
+	vector<UINT64> entryBegin(1, 0);
+	vector<float> scores;
+	for (Entries::const_iterator entry = entries.begin() ; entry != entries.end() ; ++entry)
+	{
+		for (size_t i = 0 ; i < entry->first.size() ; ++i)
+			entryKeys.push_back(ids[entry->first[i]]);
+		for (Outputs::const_iterator output = entry->second.begin() ; output != entry->second.end() ; ++output)
+		{
+			for (size_t i = 0 ; i < output->first.size() ; ++i)
+				outputKeys.push_back(ids[output->first[i]]);
+			scores.insert(scores.end(), output->second.begin(), output->second.end());
+		}
+		entryBegin.push_back(entryBegin.back() + entry->second.size());
+	}
+
+	header.m_numStrings = strings.size();
+	header.m_stringSize = stringBegin.back();
+	header.m_numEntries = entries.size();
+	header.m_numOutputs = entryBegin.back();
+	const Sections sections(header);
+
+	const string binFilePath = outFilePath + ".bingen";
+	FILE *f = fOpen(binFilePath.c_str(), "wb");
+	fWrite(f, header);
+	// each section starts at its aligned offset
+	const char padding[8] = { 0 };
+	fwrite(padding, 1, sections.m_stringBegin - sizeof(header), f);
+	fwrite(&stringBegin[0], sizeof(UINT64), stringBegin.size(), f);
+	fwrite(padding, 1, sections.m_strings - sections.m_stringBegin - stringBegin.size() * sizeof(UINT64), f);
+	for (set<string>::const_iterator iter = strings.begin() ; iter != strings.end() ; ++iter)
+		fwrite(iter->data(), 1, iter->size(), f);
+	fwrite(padding, 1, sections.m_entryKeys - sections.m_strings - header.m_stringSize, f);
+	if (!entryKeys.empty())
+		fwrite(&entryKeys[0], sizeof(UINT32), entryKeys.size(), f);
+	fwrite(padding, 1, sections.m_entryBegin - sections.m_entryKeys - entryKeys.size() * sizeof(UINT32), f);
+	fwrite(&entryBegin[0], sizeof(UINT64), entryBegin.size(), f);
+	fwrite(padding, 1, sections.m_outputKeys - sections.m_entryBegin - entryBegin.size() * sizeof(UINT64), f);
+	if (!outputKeys.empty())
+		fwrite(&outputKeys[0], sizeof(UINT32), outputKeys.size(), f);
+	fwrite(padding, 1, sections.m_scores - sections.m_outputKeys - outputKeys.size() * sizeof(UINT32), f);
+	if (!scores.empty())
+		fwrite(&scores[0], sizeof(float), scores.size(), f);
+	const bool ok = !ferror(f) && (UINT64) FTELLO(f) == sections.m_end;
+	fClose(f);
+	if (!ok)
+	{
+		cerr << "error writing " << binFilePath << endl;
+		return false;
+	}
+
+	cerr << "wrote " << header.m_numEntries << " entries with " << header.m_numOutputs << " output words to " << binFilePath << endl;
+	return true;
+}
+
+}
+
@@ -0,0 +1,123 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "GenerationDictionary.h"
+#include "MemoryMappedFile.h"
+#include "Thread.h"
+
+namespace Moses
+{
+
+/** generation table in a binary file, mapped into memory instead of being loaded.
+ * The factor strings of the table are stored once, sorted, so that their position in the
+ * string list can serve as their id. The entries are sorted on the ids of their input factors,
+ * each followed by its output words, as ids, and their scores, log-transformed and floored.
+ * A word is looked up by bisecting the strings for the ids of its input factors, then the entries.
+ * Its output words are created the first time it is looked up, and kept for the later lookups
+ * of the sentence.
+ * The binary file is created from a text generation table by Create(), and is used instead of the
+ * text table if it exists next to it, with the extension .bingen
+ */
+class GenerationDictionaryBinary : public GenerationDictionary
+{
+protected:
+	static const char MAGIC[8];
+
+	//! start of the binary file. The sections that follow are aligned to 8 bytes
+	struct Header
+	{
+		char m_magic[8];
+		UINT32 m_numInputFactors, m_numOutputFactors, m_numScores, m_unused;
+		UINT64 m_numStrings, m_stringSize, m_numEntries, m_numOutputs;
+	};
+	//! offsets of the sections of the binary file
+	struct Sections
+	{
+		UINT64 m_stringBegin; //! UINT64 offset of each string in the string data, and the end
+		UINT64 m_strings; //! string data, not 0 terminated
+		UINT64 m_entryKeys; //! UINT32 ids of the input factors of each entry
+		UINT64 m_entryBegin; //! UINT64 index of the first output of each entry, and the end
+		UINT64 m_outputKeys; //! UINT32 ids of the output factors of each output
+		UINT64 m_scores; //! float scores of each output
+		UINT64 m_end;
+
+		explicit Sections(const Header &header);
+	};
+
+	MemoryMappedFile m_file;
+	const Header *m_header;
+	const UINT64 *m_stringBegin;
+	const char *m_strings;
+	const UINT32 *m_entryKeys;
+	const UINT64 *m_entryBegin;
+	const UINT32 *m_outputKeys;
+	const float *m_scores;
+
+	std::vector<FactorType> m_input, m_output;
+	FactorDirection m_direction;
+
+	mutable Collection m_cache; //! output words of the words looked up during the sentence
+	mutable ReadWriteLock m_cacheLock; //! lookups of cached words only need to read
+
+	//! id of a factor string. false if it isn't in the table
+	bool FindString(const std::string &str, UINT32 &id) const;
+	std::string GetString(UINT32 id) const
+	{
+		return std::string(m_strings + m_stringBegin[id], m_stringBegin[id + 1] - m_stringBegin[id]);
+	}
+	//! index of the entry with the given input factor ids. false if there is none
+	bool FindEntry(const UINT32 *ids, size_t &entry) const;
+	//! create the output words of an entry
+	void CreateOutputWords(size_t entry, OutputWordCollection &outputWords) const;
+
+public:
+	GenerationDictionaryBinary(size_t numFeatures, ScoreIndexManager &scoreIndexManager)
+	:GenerationDictionary(numFeatures, scoreIndexManager)
+	,m_header(NULL)
+	{}
+	~GenerationDictionaryBinary();
+
+	//! map binary file filePath + ".bingen". filePath is the text table the binary file was created from
+	bool Load(const std::vector<FactorType> &input
+									, const std::vector<FactorType> &output
+									, const std::string &filePath
+									, FactorDirection direction);
+
+	size_t GetSize() const
+	{
+		return (size_t) m_header->m_numEntries;
+	}
+	const OutputWordCollection *FindWord(const Word &word) const;
+	//! forget the words looked up during the sentence
+	void CleanUp();
+
+	//! write text generation table read from inFile to binary file outFilePath + ".bingen"
+	static bool Create(std::istream &inFile, const std::string &outFilePath);
+};
+
+}
+
@@ -282,9 +282,15 @@ void Hypothesis::CalcScore(const SquareMatrix &futureScore)
     sfs[i]->Evaluate(m_targetPhrase, &m_scoreBreakdown);
 	}
 
+	// all LMs in one go
+	const LMList &languageModels = staticData.GetAllLM();
+	languageModels.Evaluate(*this, m_prevHypo ? &m_prevHypo->m_ffStates : NULL, m_ffStates, &m_scoreBreakdown);
+
 	const vector<const StatefulFeatureFunction*>& ffs =
 	  staticData.GetScoreIndexManager().GetStatefulFeatureFunctions();
 	for (unsigned i = 0; i < ffs.size(); ++i) {
+		if (languageModels.IsLMState(i))
+			continue;
 		m_ffStates[i] = ffs[i]->Evaluate(
 			*this,
 			m_prevHypo ? m_prevHypo->m_ffStates[i] : NULL,
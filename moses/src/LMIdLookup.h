@@ -0,0 +1,83 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "Factor.h"
+#include "Phrase.h"
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+/** dense table from factor id to the id of a word in the vocabulary of an LM implementation.
+ * Every word of the LM is added as a factor when the LM is loaded,
+ * so factors not in the table, including the ones created later, are unknown to the LM
+ */
+template <typename LmId>
+class LMIdLookup
+{
+protected:
+	std::vector<LmId> m_ids;
+	LmId m_unknownId;
+
+public:
+	LMIdLookup()
+	:m_unknownId()
+	{}
+
+	//! forget all ids. Factors map to unknownId until added
+	void Init(LmId unknownId)
+	{
+		m_ids.clear();
+		m_unknownId = unknownId;
+	}
+	void Add(const Factor *factor, LmId lmId)
+	{
+		const size_t factorId = factor->GetId();
+		if (factorId >= m_ids.size())
+			m_ids.resize(std::max(factorId + 1, m_ids.size() * 2), m_unknownId);
+		m_ids[factorId] = lmId;
+	}
+
+	LmId Get(const Factor *factor) const
+	{
+		const size_t factorId = factor->GetId();
+		return (factorId >= m_ids.size()) ? m_unknownId : m_ids[factorId];
+	}
+	LmId GetUnknownId() const
+	{
+		return m_unknownId;
+	}
+
+	//! ids of all words of phrase, in one go
+	void Map(const Phrase &phrase, FactorType factorType, LmId *lmIds) const
+	{
+		const size_t size = phrase.GetSize();
+		for (size_t pos = 0 ; pos < size ; ++pos)
+			lmIds[pos] = Get(phrase.GetFactor(pos, factorType));
+	}
+};
+
+}
+
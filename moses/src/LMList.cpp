@@ -19,10 +19,13 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
 #include "LMList.h"
 #include "Phrase.h"
 #include "LanguageModelSingleFactor.h"
 #include "ScoreComponentCollection.h"
+#include "Hypothesis.h"
+#include "StaticData.h"
 
 using namespace std;
 
@@ -42,7 +45,10 @@ void LMList::CalcScore(const Phrase &phrase, float &retFullScore, float &retNGra
 		if (!lm.Useable(phrase))
 			continue;
 
-		lm.CalcScore(phrase, fullScore, nGramScore);
+		{
+			ScopedLock lock(lm.GetScoreLock());
+			lm.CalcScore(phrase, fullScore, nGramScore);
+		}
 
 		breakdown->Assign(&lm, nGramScore);  // I'm not sure why += doesn't work here- it should be 0.0 right?
 		retFullScore   += fullScore * weightLM;
@@ -50,5 +56,55 @@ void LMList::CalcScore(const Phrase &phrase, float &retFullScore, float &retNGra
 	}	
 }
 
+void LMList::SetStatefulFeatureFunctions(const std::vector<const StatefulFeatureFunction*> &ffs)
+{
+	m_stateIndexes.clear();
+	m_isLMState.assign(ffs.size(), false);
+	m_maxContextWords = 0;
+
+	const_iterator lmIter;
+	for (lmIter = begin(); lmIter != end(); ++lmIter)
+	{
+		const LanguageModel *lm = *lmIter;
+		size_t index = std::find(ffs.begin(), ffs.end(), lm) - ffs.begin();
+		assert(index < ffs.size());
+		m_stateIndexes.push_back(index);
+		m_isLMState[index] = true;
+		m_maxContextWords = std::max(m_maxContextWords, lm->GetNGramOrder() - 1);
+	}
+}
+
+void LMList::Evaluate(const Hypothesis &hypo
+										, const std::vector<const FFState*> *prevStates
+										, std::vector<const FFState*> &states
+										, ScoreComponentCollection *out) const
+{
+	clock_t t=0;
+	IFVERBOSE(2) { t  = clock(); } // track time
+
+	// target words, after room for the longest context
+	const TargetPhrase &phrase = hypo.GetCurrTargetPhrase();
+	vector<const Word*> words(m_maxContextWords + phrase.GetSize());
+	for (size_t pos = 0 ; pos < phrase.GetSize() ; ++pos)
+		words[m_maxContextWords + pos] = &phrase.GetWord(pos);
+	vector<const Word*> contextFactor;
+	contextFactor.reserve(m_maxContextWords + 1);
+
+	const_iterator lmIter;
+	vector<size_t>::const_iterator iterIndex = m_stateIndexes.begin();
+	for (lmIter = begin(); lmIter != end(); ++lmIter, ++iterIndex)
+	{
+		const size_t index = *iterIndex;
+		states[index] = (*lmIter)->Evaluate(hypo
+																	, prevStates ? (*prevStates)[index] : NULL
+																	, words.begin() + m_maxContextWords
+																	, words.end()
+																	, contextFactor
+																	, out);
+	}
+
+	IFVERBOSE(2) { StaticData::Instance().GetSentenceStats().AddTimeCalcLM( clock()-t ); }
+}
+
 }
 
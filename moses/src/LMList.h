@@ -2,6 +2,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "LanguageModel.h"
 
 namespace Moses
@@ -10,13 +11,43 @@ namespace Moses
 class Phrase;
 class ScoreColl;
 class ScoreComponentCollection;
+class Hypothesis;
+class FFState;
+class StatefulFeatureFunction;
 
 //! List of language models
 class LMList : public std::list < LanguageModel* >	
 {
+protected:
+	std::vector<size_t> m_stateIndexes; //! index of each LM in the stateful feature functions
+	std::vector<bool> m_isLMState; //! whether each stateful feature function is one of the LMs
+	size_t m_maxContextWords; //! largest n-gram order - 1
+
 public:
+	LMList()
+	:m_maxContextWords(0)
+	{}
+
 	void CalcScore(const Phrase &phrase, float &retFullScore, float &retNGramScore, ScoreComponentCollection* breakdown) const;
 
+	//! find the LMs among the stateful feature functions. Call once all feature functions are registered
+	void SetStatefulFeatureFunctions(const std::vector<const StatefulFeatureFunction*> &ffs);
+	//! whether the stateful feature function is an LM, which Evaluate() scores instead of Hypothesis::CalcScore
+	bool IsLMState(size_t statefulIndex) const
+	{
+		return statefulIndex < m_isLMState.size() && m_isLMState[statefulIndex];
+	}
+
+	/** evaluate all LMs on the target phrase of hypo, one LM after the other.
+	 * Only the word pointers of the phrase and the context scratch space are set up once
+	 * for all LMs. Each LM still maps the words to its own vocabulary ids and keeps its own state
+	 * \param prevStates states of the stateful feature functions in the previous hypothesis, or NULL
+	 * \param states states of hypo. The LM entries are filled in
+	 */
+	void Evaluate(const Hypothesis &hypo
+							, const std::vector<const FFState*> *prevStates
+							, std::vector<const FFState*> &states
+							, ScoreComponentCollection *out) const;
 };
 
 }
@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <limits>
 #include <iostream>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 
 #include "FFState.h"
 #include "LanguageModel.h"
@@ -31,12 +33,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "FactorCollection.h"
 #include "Phrase.h"
 #include "StaticData.h"
+#include "Hypothesis.h"
 
 using namespace std;
 
 namespace Moses
 {
 LanguageModel::LanguageModel(bool registerScore, ScoreIndexManager &scoreIndexManager) 
+:m_useCache(false)
 {
 	if (registerScore)
 		scoreIndexManager.AddScoreProducer(this);
@@ -64,13 +68,13 @@ void LanguageModel::CalcScore(const Phrase &phrase
 	for (size_t currPos = 0 ; currPos < m_nGramOrder - 1 && currPos < phraseSize ; currPos++)
 	{
 		contextFactor.push_back(&phrase.GetWord(currPos));		
-		fullScore += GetValue(contextFactor);
+		fullScore += GetCachedValue(contextFactor);
 	}
 	
 	if (phraseSize >= m_nGramOrder)
 	{
 		contextFactor.push_back(&phrase.GetWord(m_nGramOrder - 1));
-		ngramScore = GetValue(contextFactor);
+		ngramScore = GetCachedValue(contextFactor);
 	}
 	
 	// main loop
@@ -81,34 +85,218 @@ void LanguageModel::CalcScore(const Phrase &phrase
 			contextFactor[currNGramOrder] = contextFactor[currNGramOrder + 1];
 		}
 		contextFactor[m_nGramOrder - 1] = &phrase.GetWord(currPos);
-		float partScore = GetValue(contextFactor);		
+		float partScore = GetCachedValue(contextFactor);		
 		ngramScore += partScore;		
 	}
 	fullScore += ngramScore;	
 }
 
+float LanguageModel::GetCachedValue(const std::vector<const Word*> &contextFactor
+												, State* finalState
+												, unsigned int* len) const
+{
+	if (!m_useCache)
+		return GetValue(contextFactor, finalState, len);
+
+	// key is the LM factors of each word
+	const Factor *key[MAX_NGRAM_SIZE * MAX_NUM_FACTORS];
+	const size_t numFactorTypes = m_contextFactorTypes.size();
+	size_t keySize = 0;
+	for (size_t pos = 0 ; pos < contextFactor.size() ; ++pos)
+		for (size_t i = 0 ; i < numFactorTypes ; ++i)
+			key[keySize++] = (*contextFactor[pos])[m_contextFactorTypes[i]];
+
+	float score;
+	if (m_cache.Find(key, keySize, score, finalState, len))
+		return score;
+
+	if (finalState == NULL && len == NULL)
+	{
+		score = GetValue(contextFactor);
+		m_cache.Insert(key, keySize, score, NULL, NULL);
+		return score;
+	}
+
+	// store state and len together, whichever was asked for
+	State state;
+	unsigned int newLen = NGramCache::NO_LEN;
+	score = GetValue(contextFactor, &state, &newLen);
+	m_cache.Insert(key, keySize, score, &state, &newLen);
+	if (finalState != NULL)
+		*finalState = state;
+	if (len != NULL && newLen != NGramCache::NO_LEN)
+		*len = newLen;
+	return score;
+}
+
+void LanguageModel::SetCacheSize(size_t numEntries)
+{
+	m_cache.Init(numEntries, m_nGramOrder * m_contextFactorTypes.size());
+}
+
+void LanguageModel::InitializeBeforeSentenceProcessing()
+{
+	m_cache.Clear();
+	m_useCache = m_cache.IsEnabled();
+}
+
+void LanguageModel::CleanUpAfterSentenceProcessing()
+{
+	IFVERBOSE(2)
+	{
+		if (m_useCache)
+		{
+			size_t lookups = m_cache.GetHits() + m_cache.GetMisses();
+			TRACE_ERR(GetScoreProducerDescription() << " cache hits: " << m_cache.GetHits() << "/" << lookups
+								<< " (" << (lookups == 0 ? 0 : (int) (100.0 * m_cache.GetHits() / lookups)) << "%)" << endl);
+		}
+	}
+	m_useCache = false;
+}
+
 LanguageModel::State LanguageModel::GetState(const std::vector<const Word*> &contextFactor, unsigned int* len) const
 {
   State state;
 	unsigned int dummy;
   if (!len) len = &dummy;
-  GetValue(contextFactor,&state,len);
+  GetCachedValue(contextFactor,&state,len);
   return state;
 }
 
+namespace
+{
+/** free list of equally sized memory blocks for LM states.
+ * A block holds the state and its context, so the block size is set by the LM
+ * with the largest context, before the first state is created
+ */
+class LMStatePool
+{
+protected:
+	size_t m_blockSize;
+	std::vector<void*> m_free;
+	std::vector<char*> m_chunks;
+
+	static const size_t BLOCKS_PER_CHUNK = 4096;
+
+public:
+	LMStatePool()
+	:m_blockSize(0)
+	{}
+	~LMStatePool()
+	{
+		for (size_t i = 0 ; i < m_chunks.size() ; ++i)
+			delete [] m_chunks[i];
+	}
+
+	void Reserve(size_t blockSize)
+	{
+		assert(m_chunks.empty());
+		// keep blocks pointer aligned
+		blockSize = (blockSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+		m_blockSize = std::max(m_blockSize, blockSize);
+	}
+	void *Allocate()
+	{
+		assert(m_blockSize > 0);
+		if (m_free.empty())
+		{
+			char *chunk = new char[m_blockSize * BLOCKS_PER_CHUNK];
+			m_chunks.push_back(chunk);
+			m_free.reserve(m_free.size() + BLOCKS_PER_CHUNK);
+			for (size_t i = BLOCKS_PER_CHUNK ; i > 0 ; --i)
+				m_free.push_back(chunk + (i - 1) * m_blockSize);
+		}
+		void *block = m_free.back();
+		m_free.pop_back();
+		return block;
+	}
+	void Free(void *block)
+	{
+		m_free.push_back(block);
+	}
+};
+
+LMStatePool s_lmStatePool;
+}
+
+/** the last (n-1) words of a hypothesis, as the factors the LM reads.
+ * Context factors are stored inline, right after the object.
+ * Only the last m_length factors can change the score of following words,
+ * so only those are compared for recombination
+ */
 struct LMState : public FFState {
-	const void* lmstate;
-	LMState(const void* lms) { lmstate = lms; }
+	size_t m_size; //! number of context factors
+	size_t m_length; //! number of context factors the LM can extend
+
+	const Factor **GetContext()
+	{
+		return reinterpret_cast<const Factor**>(this + 1);
+	}
+	const Factor * const *GetContext() const
+	{
+		return reinterpret_cast<const Factor* const*>(this + 1);
+	}
+
+	explicit LMState(size_t size)
+	:m_size(size)
+	,m_length(size)
+	{}
+	LMState(const LMState &copy)
+	:FFState()
+	,m_size(copy.m_size)
+	,m_length(copy.m_length)
+	{
+		std::memcpy(GetContext(), copy.GetContext(), m_size * sizeof(const Factor*));
+	}
+
 	virtual int Compare(const FFState& o) const {
 		const LMState& other = static_cast<const LMState&>(o);
-		if (other.lmstate > lmstate) return 1;
-		else if (other.lmstate < lmstate) return -1;
-		return 0;
+		if (m_length != other.m_length)
+			return m_length < other.m_length ? -1 : 1;
+		const size_t start = m_size - m_length;
+		return std::memcmp(GetContext() + start, other.GetContext() + start, m_length * sizeof(const Factor*));
+	}
+
+	static void *operator new(size_t)
+	{
+		return s_lmStatePool.Allocate();
+	}
+	static void operator delete(void *block)
+	{
+		s_lmStatePool.Free(block);
 	}
 };
 
+void LanguageModel::SetContextFactorTypes(const std::vector<FactorType> &factorTypes)
+{
+	m_contextFactorTypes = factorTypes;
+	s_lmStatePool.Reserve(sizeof(LMState) + GetContextSize() * sizeof(const Factor*));
+}
+
+void LanguageModel::SetContext(LMState &state, vector<const Word*>::const_iterator words) const
+{
+	const Factor **context = state.GetContext();
+	const size_t numFactorTypes = m_contextFactorTypes.size();
+	for (size_t pos = 0 ; pos < m_nGramOrder - 1 ; ++pos)
+		for (size_t i = 0 ; i < numFactorTypes ; ++i)
+			*context++ = (*words[pos])[m_contextFactorTypes[i]];
+}
+
+void LanguageModel::GetContext(const LMState &state, Word *words) const
+{
+	const Factor * const *context = state.GetContext();
+	const size_t numFactorTypes = m_contextFactorTypes.size();
+	for (size_t pos = 0 ; pos < m_nGramOrder - 1 ; ++pos)
+		for (size_t i = 0 ; i < numFactorTypes ; ++i)
+			words[pos][m_contextFactorTypes[i]] = *context++;
+}
+
 const FFState* LanguageModel::EmptyHypothesisState() const {
-	return new LMState(NULL);
+	// context before the 1st word is all sentence start
+	LMState *state = new LMState(GetContextSize());
+	vector<const Word*> words(m_nGramOrder - 1, &GetSentenceStartArray());
+	SetContext(*state, words.begin());
+	return state;
 }
 
 FFState* LanguageModel::Evaluate(
@@ -117,66 +305,80 @@ FFState* LanguageModel::Evaluate(
     ScoreComponentCollection* out) const {
 	clock_t t=0;
 	IFVERBOSE(2) { t  = clock(); } // track time
-	const void* prevlm = ps ? (static_cast<const LMState *>(ps)->lmstate) : NULL;
-	LMState* res = new LMState(prevlm);
-	if (hypo.GetCurrTargetLength() == 0)
+	const TargetPhrase &phrase = hypo.GetCurrTargetPhrase();
+	const size_t contextWords = m_nGramOrder - 1;
+	vector<const Word*> words(contextWords + phrase.GetSize());
+	for (size_t pos = 0 ; pos < phrase.GetSize() ; ++pos)
+		words[contextWords + pos] = &phrase.GetWord(pos);
+	vector<const Word*> contextFactor;
+	FFState *res = Evaluate(hypo, ps, words.begin() + contextWords, words.end(), contextFactor, out);
+	IFVERBOSE(2) { StaticData::Instance().GetSentenceStats().AddTimeCalcLM( clock()-t ); }
+	return res;
+}
+
+FFState* LanguageModel::Evaluate(const Hypothesis &hypo
+																, const FFState *ps
+																, vector<const Word*>::iterator phraseBegin
+																, vector<const Word*>::iterator phraseEnd
+																, vector<const Word*> &contextFactor
+																, ScoreComponentCollection *out) const
+{
+	LMState* res = ps ? new LMState(*static_cast<const LMState *>(ps))
+										: static_cast<LMState *>(const_cast<FFState *>(EmptyHypothesisState()));
+	const size_t phraseSize = phraseEnd - phraseBegin;
+	if (phraseSize == 0)
 		return res;
-	const size_t currEndPos = hypo.GetCurrTargetWordsRange().GetEndPos();
-	const size_t startPos = hypo.GetCurrTargetWordsRange().GetStartPos();
 
-	// 1st n-gram
-	vector<const Word*> contextFactor(m_nGramOrder);
-	size_t index = 0;
-	for (int currPos = (int) startPos - (int) m_nGramOrder + 1 ; currPos <= (int) startPos ; currPos++)
+	// the words to score: context from the previous state, then the new phrase.
+	// No need to go back through the previous hypotheses
+	const size_t contextWords = m_nGramOrder - 1;
+	Word prevContext[MAX_NGRAM_SIZE];
+	GetContext(*res, prevContext);
+	const vector<const Word*>::iterator words = phraseBegin - contextWords;
+	for (size_t pos = 0 ; pos < contextWords ; ++pos)
+		words[pos] = &prevContext[pos];
+
+	// n-grams ending in the first (n-1) words of the phrase.
+	// The n-grams within the phrase were scored with the translation option
+	// The LM also tells how many words at the end of the last n-gram it can extend
+	contextFactor.resize(m_nGramOrder);
+	float lmScore = 0;
+	unsigned int len = m_nGramOrder;
+	State lmState;
+	const size_t numNGrams = std::max(std::min(contextWords, phraseSize), (size_t) 1);
+	for (size_t start = 0 ; start < numNGrams ; ++start)
 	{
-		if (currPos >= 0)
-			contextFactor[index++] = &hypo.GetWord(currPos);
-		else			
-			contextFactor[index++] = &GetSentenceStartArray();
+		std::copy(words + start, words + start + m_nGramOrder, contextFactor.begin());
+		if (start + 1 < numNGrams)
+			lmScore	+= GetCachedValue(contextFactor);
+		else
+			lmScore	+= GetCachedValue(contextFactor, &lmState, &len);
+	}
+	if (phraseSize > numNGrams && contextWords > 0)
+	{ // last n-gram was scored with the translation option
+		std::copy(phraseEnd - m_nGramOrder, phraseEnd, contextFactor.begin());
+		GetState(contextFactor, &len);
 	}
-	float lmScore	= GetValue(contextFactor);
-	//cout<<"context factor: "<<GetValue(contextFactor)<<endl;
 
-	// main loop
-	size_t endPos = std::min(startPos + m_nGramOrder - 2
-			, currEndPos);
-	for (size_t currPos = startPos + 1 ; currPos <= endPos ; currPos++)
+	// new context is the last (n-1) words.
+	// Words before the ones the LM can extend can't change any later score, leave them out of recombination
+	SetContext(*res, words + phraseSize);
+	const size_t keepWords = std::min((size_t) len, contextWords);
+	res->m_length = keepWords * m_contextFactorTypes.size();
+	IFVERBOSE(2)
 	{
-		// shift all args down 1 place
-		for (size_t i = 0 ; i < m_nGramOrder - 1 ; i++)
-			contextFactor[i] = contextFactor[i + 1];
-
-		// add last factor
-		contextFactor.back() = &hypo.GetWord(currPos);
-
-		lmScore	+= GetValue(contextFactor);
+		if (keepWords < contextWords)
+			StaticData::Instance().GetSentenceStats().AddLMStateTruncated();
 	}
 
 	// end of sentence
 	if (hypo.IsSourceCompleted())
 	{
-		const size_t size = hypo.GetSize();
+		std::copy(words + phraseSize, phraseEnd, contextFactor.begin());
 		contextFactor.back() = &GetSentenceEndArray();
-
-		for (size_t i = 0 ; i < m_nGramOrder - 1 ; i ++)
-		{
-			int currPos = (int)(size - m_nGramOrder + i + 1);
-			if (currPos < 0)
-				contextFactor[i] = &GetSentenceStartArray();
-			else
-				contextFactor[i] = &hypo.GetWord((size_t)currPos);
-		}
-		lmScore	+= GetValue(contextFactor, &res->lmstate);
-	} else {
-		for (size_t currPos = endPos+1; currPos <= currEndPos; currPos++) {
-			for (size_t i = 0 ; i < m_nGramOrder - 1 ; i++)
-				contextFactor[i] = contextFactor[i + 1];
-			contextFactor.back() = &hypo.GetWord(currPos);
-		}
-		res->lmstate = GetState(contextFactor);
+		lmScore	+= GetCachedValue(contextFactor);
 	}
 	out->PlusEquals(this, lmScore);
-	IFVERBOSE(2) { StaticData::Instance().GetSentenceStats().AddTimeCalcLM( clock()-t ); }
 	return res;
 }
 
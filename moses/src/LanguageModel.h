@@ -27,6 +27,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TypeDef.h"
 #include "Util.h"
 #include "FeatureFunction.h"
+#include "NGramCache.h"
+#include "Thread.h"
 #include "Word.h"
 
 namespace Moses
@@ -35,6 +37,7 @@ namespace Moses
 class FactorCollection;
 class Factor;
 class Phrase;
+struct LMState;
 
 //! Abstract base class which represent a language model on a contiguous phrase
 class LanguageModel : public StatefulFeatureFunction
@@ -45,6 +48,20 @@ protected:
 	size_t			m_nGramOrder; //! max n-gram length contained in this LM
 	Word m_sentenceStartArray, m_sentenceEndArray; //! Contains factors which represents the beging and end words for this LM. 
 																								//! Usually <s> and </s>
+	std::vector<FactorType> m_contextFactorTypes; //! factors of the context words kept in the hypothesis state
+	mutable NGramCache m_cache; //! n-gram scores of the current sentence
+	bool m_useCache; //! only while decoding a sentence
+	mutable Mutex m_scoreLock; //! see GetScoreLock()
+
+	//! number of factors in the context of a state
+	size_t GetContextSize() const
+	{
+		return (m_nGramOrder - 1) * m_contextFactorTypes.size();
+	}
+	//! store the factors of (n-1) words in state
+	void SetContext(LMState &state, std::vector<const Word*>::const_iterator words) const;
+	//! (n-1) words, with only the factors of the LM, from state
+	void GetContext(const LMState &state, Word *words) const;
 
 	/** constructor to be called by inherited class
 	 * \param registerScore whether this LM will be directly used to score sentence. 
@@ -79,21 +96,42 @@ public:
 	 * \param fullScore scores of all unigram, bigram... of contiguous n-gram of the phrase
 	 * \param ngramScore score of only n-gram of order m_nGramOrder
 	 */
-	void CalcScore(const Phrase &phrase
+	virtual void CalcScore(const Phrase &phrase
 							, float &fullScore
 							, float &ngramScore) const;
 	/* get score of n-gram. n-gram should not be bigger than m_nGramOrder
 	 * Specific implementation can return State and len data to be used in hypothesis pruning
 	 * \param contextFactor n-gram to be scored
 	 * \param finalState state used by LM. Return arg
-	 * \param len ???
+	 * \param len number of words at the end of the n-gram which the LM can use as context
+	 * 						for the following words. Return arg. Words before them can't change any later score,
+	 * 						so hypotheses differing only in those can be recombined.
+	 * 						Implementations which can't tell leave it as it is
 	 */
 	virtual float GetValue(const std::vector<const Word*> &contextFactor
 												, State* finalState = 0
 												, unsigned int* len = 0) const = 0;
+	/** to be held around CalcScore() by callers which may run on several threads, ie. while the
+	 * translation options are created. Neither the cache nor the LM implementations are thread safe
+	 */
+	Mutex &GetScoreLock() const
+	{
+		return m_scoreLock;
+	}
+	//! GetValue(), going through the n-gram cache while a sentence is decoded
+	float GetCachedValue(const std::vector<const Word*> &contextFactor
+												, State* finalState = 0
+												, unsigned int* len = 0) const;
 	//! get State for a particular n-gram
 	State GetState(const std::vector<const Word*> &contextFactor, unsigned int* len = 0) const;
 
+	/** factors read by the LM, which are kept in the hypothesis states.
+	 * Must be called after loading, before decoding
+	 */
+	void SetContextFactorTypes(const std::vector<FactorType> &factorTypes);
+	//! number of n-gram scores cached for each sentence. Call after SetContextFactorTypes()
+	void SetCacheSize(size_t numEntries);
+
 	//! max n-gram order of LM
 	size_t GetNGramOrder() const
 	{
@@ -122,9 +160,11 @@ public:
 	
 	virtual std::string GetScoreProducerDescription() const = 0;
   
-	//! overrideable funtions for IRST LM to cleanup. Maybe something to do with on demand/cache loading/unloading
-	virtual void InitializeBeforeSentenceProcessing(){};
-	virtual void CleanUpAfterSentenceProcessing() {};
+	/** overrideable funtions for IRST LM to cleanup. Maybe something to do with on demand/cache loading/unloading.
+	 * Overrides must call these, they clear the n-gram cache
+	 */
+	virtual void InitializeBeforeSentenceProcessing();
+	virtual void CleanUpAfterSentenceProcessing();
 
 	virtual const FFState* EmptyHypothesisState() const;
 
@@ -133,6 +173,17 @@ public:
     const FFState* prev_state,
     ScoreComponentCollection* accumulator) const;
 
+	/** Evaluate() on the words of the target phrase of hypo, which LMList shares between LMs.
+	 * The (n-1) elements before phraseBegin are overwritten with the context.
+	 * \param contextFactor scratch space
+	 */
+	FFState* Evaluate(const Hypothesis &hypo
+									, const FFState *ps
+									, std::vector<const Word*>::iterator phraseBegin
+									, std::vector<const Word*>::iterator phraseEnd
+									, std::vector<const Word*> &contextFactor
+									, ScoreComponentCollection *out) const;
+
 };
 
 }
@@ -142,6 +142,12 @@ namespace LanguageModelFactory
   			break;
 	  	}
 	  }
+	  if (lm != NULL)
+	  {
+	  	lm->SetContextFactorTypes(lm->GetLMType() == SingleFactor
+	  														? std::vector<FactorType>(1, factorTypes[0])
+	  														: factorTypes);
+	  }
 
 	  return lm;
 	}
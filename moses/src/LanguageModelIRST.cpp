@@ -127,46 +127,25 @@ bool LanguageModelIRST::Load(const std::string &filePath,
 }
 
 void LanguageModelIRST::CreateFactors(FactorCollection &factorCollection)
-{ // add factors which have srilm id
-	// code copied & paste from SRI LM class. should do template function
-	std::map<size_t, int> lmIdMap;
-	size_t maxFactorId = 0; // to create lookup vector later on
-	
+{ // add factors which have irst id
+	m_lmIdLookup.Init(m_unknownId);
+
 	dict_entry *entry;
 	dictionary_iter iter(m_lmtb->getDict()); // at the level of micro tags
 	while ( (entry = iter.next()) != NULL)
 	{
-		size_t factorId = factorCollection.AddFactor(Output, m_factorType, entry->word)->GetId();
-		lmIdMap[factorId] = entry->code;
-		maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+		m_lmIdLookup.Add(factorCollection.AddFactor(Output, m_factorType, entry->word), entry->code);
 	}
 	
-	size_t factorId;
-	
 	m_sentenceStart = factorCollection.AddFactor(Output, m_factorType, BOS_);
-	factorId = m_sentenceStart->GetId();
-	m_lmtb_sentenceStart=lmIdMap[factorId] = GetLmID(BOS_);
-	maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+	m_lmtb_sentenceStart = GetLmID(BOS_);
+	m_lmIdLookup.Add(m_sentenceStart, m_lmtb_sentenceStart);
 	m_sentenceStartArray[m_factorType] = m_sentenceStart;
 
 	m_sentenceEnd		= factorCollection.AddFactor(Output, m_factorType, EOS_);
-	factorId = m_sentenceEnd->GetId();
-	m_lmtb_sentenceEnd=lmIdMap[factorId] = GetLmID(EOS_);
-	maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+	m_lmtb_sentenceEnd = GetLmID(EOS_);
+	m_lmIdLookup.Add(m_sentenceEnd, m_lmtb_sentenceEnd);
 	m_sentenceEndArray[m_factorType] = m_sentenceEnd;
-	
-	// add to lookup vector in object
-	m_lmIdLookup.resize(maxFactorId+1);
-	
-	fill(m_lmIdLookup.begin(), m_lmIdLookup.end(), m_unknownId);
-
-	map<size_t, int>::iterator iterMap;
-	for (iterMap = lmIdMap.begin() ; iterMap != lmIdMap.end() ; ++iterMap)
-	{
-		m_lmIdLookup[iterMap->first] = iterMap->second;
-	}
-  
-  
 }
 
 int LanguageModelIRST::GetLmID( const std::string &str ) const
@@ -189,19 +168,17 @@ float LanguageModelIRST::GetValue(const vector<const Word*> &contextFactor, Stat
 
 	for (size_t i = 0 ; i < count ; i++)
 	{
-	  //int lmId = GetLmID((*contextFactor[i])[factorType]);
 #ifdef DEBUG
 	  cout << "i=" << i << " -> " << (*contextFactor[i])[factorType]->GetString() << "\n";
 #endif
-	  int lmId = GetLmID((*contextFactor[i])[factorType]->GetString());
-	  //	  cerr << (*contextFactor[i])[factorType]->GetString() << " = " << lmId;
+	  // the lookup table has every word of the LM dictionary, no need to encode the string
+	  int lmId = GetLmID((*contextFactor[i])[factorType]);
 	  m_lmtb_ng->pushc(lmId);
 	}
   
 	if (finalState){        
 		*finalState=(State *)m_lmtb->cmaxsuffptr(*m_lmtb_ng);	
-		// back off stats not currently available
-		*len = 0;	
+		// back off stats not currently available, so len is left as it is
 	}
 
 	float prob = m_lmtb->clprob(*m_lmtb_ng);
@@ -212,6 +189,7 @@ float LanguageModelIRST::GetValue(const vector<const Word*> &contextFactor, Stat
 
 
 void LanguageModelIRST::CleanUpAfterSentenceProcessing(){
+  LanguageModel::CleanUpAfterSentenceProcessing();
   TRACE_ERR( "reset caches\n");
   m_lmtb->reset_caches(); 
 
@@ -223,7 +201,7 @@ void LanguageModelIRST::CleanUpAfterSentenceProcessing(){
 }
 
 void LanguageModelIRST::InitializeBeforeSentenceProcessing(){
-  //nothing to do
+  LanguageModel::InitializeBeforeSentenceProcessing();
 #ifdef TRACE_CACHE
  m_lmtb->sentence_id++;
 #endif
@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TypeDef.h"
 #include "Util.h"
 #include "LanguageModelSingleFactor.h"
+#include "LMIdLookup.h"
 
 class lmtable;  // irst lm table
 class lmmacro;  // irst lm for macro tags
@@ -42,7 +43,7 @@ class Phrase;
 class LanguageModelIRST : public LanguageModelSingleFactor
 {
 protected:
-	std::vector<int> m_lmIdLookup;
+	LMIdLookup<int> m_lmIdLookup;
 	lmtable* m_lmtb;
 	ngram* m_lmtb_ng;
   
@@ -60,8 +61,7 @@ protected:
 	int GetLmID( const std::string &str ) const;
 
 	int GetLmID( const Factor *factor ) const{
-	  size_t factorId = factor->GetId();
-	  return ( factorId >= m_lmIdLookup.size()) ? m_unknownId : m_lmIdLookup[factorId];        
+	  return m_lmIdLookup.Get(factor);
 	};
   
 public:
@@ -4,11 +4,55 @@
 #include "NGramNode.h"
 #include "InputFileStream.h"
 #include "StaticData.h"
+#include "LoadFilter.h"
+#include "ParallelLineReader.h"
 
 using namespace std;
 
 namespace Moses
 {
+
+namespace
+{
+//! 1 line of an ARPA file, parsed
+struct NGramLine
+{
+	vector<string> factorStr;
+	float score, logBackOff;
+	bool keep; //! false if left out by the load filter
+};
+
+class NGramLineParser
+{
+protected:
+	const LoadFilter *m_loadFilter;
+	FactorType m_factorType;
+
+public:
+	NGramLineParser(const LoadFilter *loadFilter, FactorType factorType)
+	:m_loadFilter(loadFilter)
+	,m_factorType(factorType)
+	{}
+
+	bool operator()(const string &line, size_t /*lineNum*/, NGramLine &nGramLine) const
+	{
+		if (line.size() == 0 || line[0] == '\\')
+			return false;
+		vector<string> tokens = Tokenize(line, "\t");
+		if (tokens.size() < 2)
+			return false;
+
+		// split unigram/bigram trigrams
+		nGramLine.factorStr = Tokenize(tokens[1], " ");
+		// leave out n-grams with a word which can't be produced
+		nGramLine.keep = (m_loadFilter == NULL || m_loadFilter->KeepNGram(nGramLine.factorStr, m_factorType));
+		nGramLine.score = TransformSRIScore(Scan<float>(tokens[0]));
+		nGramLine.logBackOff = (tokens.size() == 3) ? TransformSRIScore(Scan<float>(tokens[2])) : 0;
+		return true;
+	}
+};
+}
+
 LanguageModelInternal::LanguageModelInternal(bool registerScore, ScoreIndexManager &scoreIndexManager)
 :LanguageModelSingleFactor(registerScore, scoreIndexManager)
 {
@@ -29,6 +73,7 @@ bool LanguageModelInternal::Load(const std::string &filePath
 	VERBOSE(1, "Loading Internal LM: " << filePath << endl);
 	
 	FactorCollection &factorCollection = FactorCollection::Instance();
+	const LoadFilter *loadFilter = StaticData::Instance().GetLoadFilter();
 
 	m_filePath		= filePath;
 	m_factorType	= factorType;
@@ -47,75 +92,76 @@ bool LanguageModelInternal::Load(const std::string &filePath
 
 	InputFileStream 	inFile(filePath);
 
-	// to create lookup vector later on
-	size_t maxFactorId = 0; 
-	map<size_t, const NGramNode*> lmIdMap;
+	m_lmIdLookup.Init(NULL);
 
-	string line;
-	int lineNo = 0;
-	
-	while( !getline(inFile, line, '\n').eof())
-	{
-		lineNo++;
+	NGramLineParser parser(loadFilter, m_factorType);
+	ParallelLineReader<NGramLine, NGramLineParser> reader(inFile, parser, StaticData::Instance().GetLoadThreads());
+	size_t numNGrams = 0, numFiltered = 0;
+	const size_t bloomFilterBits = StaticData::Instance().GetBloomFilterBits();
+	vector<UINT64> bloomKeys;
+	vector<const Factor*> nGramFactors;
 
-		if (line.size() != 0 && line.substr(0,1) != "\\")
+	const ParallelLineReader<NGramLine, NGramLineParser>::Chunk *chunk;
+	while ((chunk = reader.Next()) != NULL)
+	{
+		for (size_t i = 0 ; i < chunk->size() ; ++i)
 		{
-			vector<string> tokens = Tokenize(line, "\t");
-			if (tokens.size() >= 2)
+			const NGramLine &line = (*chunk)[i];
+			++numNGrams;
+			if (!line.keep)
 			{
-				// split unigram/bigram trigrams
-				vector<string> factorStr = Tokenize(tokens[1], " ");
-
-				// create / traverse down tree
-				NGramCollection *ngramColl = &m_map;
-				NGramNode *nGram;
-				const Factor *factor;
-				for (int currFactor = (int) factorStr.size() - 1 ; currFactor >= 0  ; currFactor--)
-				{
-					factor = factorCollection.AddFactor(Output, m_factorType, factorStr[currFactor]);
-					nGram = ngramColl->GetOrCreateNGram(factor);
-	
-					ngramColl = nGram->GetNGramColl();
+				++numFiltered;
+				continue;
+			}
+			const vector<string> &factorStr = line.factorStr;
+
+			// create / traverse down tree
+			NGramCollection *ngramColl = &m_map;
+			NGramNode *nGram;
+			const Factor *factor;
+			nGramFactors.resize(factorStr.size());
+			for (int currFactor = (int) factorStr.size() - 1 ; currFactor >= 0  ; currFactor--)
+			{
+				factor = factorCollection.AddFactor(Output, m_factorType, factorStr[currFactor]);
+				nGramFactors[currFactor] = factor;
+				nGram = ngramColl->GetOrCreateNGram(factor);
 
-				}
+				ngramColl = nGram->GetNGramColl();
 
-				NGramNode *rootNGram = m_map.GetNGram(factor);
-				nGram->SetRootNGram(rootNGram);
+			}
 
-				// create vector of factors used in this LM
-				size_t factorId = factor->GetId();
-				maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
-				lmIdMap[factorId] = rootNGram;
-				//factorCollection.SetFactorLmId(factor, rootNGram);
+			NGramNode *rootNGram = m_map.GetNGram(factor);
+			nGram->SetRootNGram(rootNGram);
 
-				float score = TransformSRIScore(Scan<float>(tokens[0]));
-				nGram->SetScore( score );
-				if (tokens.size() == 3)
-				{
-					float logBackOff = TransformSRIScore(Scan<float>(tokens[2]));
-					nGram->SetLogBackOff( logBackOff );
-				}
-				else
-				{
-					nGram->SetLogBackOff( 0 );
-				}
+			// create vector of factors used in this LM
+			m_lmIdLookup.Add(factor, rootNGram);
+
+			// each node on the path is the n-gram of a suffix
+			if (bloomFilterBits > 0)
+			{
+				for (size_t start = 0 ; start < nGramFactors.size() ; ++start)
+					bloomKeys.push_back(BloomFilter::GetKey(&nGramFactors[start], nGramFactors.size() - start));
 			}
+
+			nGram->SetScore( line.score );
+			nGram->SetLogBackOff( line.logBackOff );
 		}
 	}
 
-		// add to lookup vector in object
-	m_lmIdLookup.resize(maxFactorId+1);
-	fill(m_lmIdLookup.begin(), m_lmIdLookup.end(), static_cast<const NGramNode*>(NULL));
-
-	map<size_t, const NGramNode*>::iterator iterMap;
-	for (iterMap = lmIdMap.begin() ; iterMap != lmIdMap.end() ; ++iterMap)
-	{
-		m_lmIdLookup[iterMap->first] = iterMap->second;
-	}
+	m_bloomFilter.Init(bloomKeys, bloomFilterBits);
 
+	if (loadFilter != NULL)
+		VERBOSE(1, "Filtered " << numFiltered << " of " << numNGrams << " n-grams from " << filePath << endl);
 	return true;
 }
 
+void LanguageModelInternal::CleanUpAfterSentenceProcessing()
+{
+	if (m_bloomFilter.IsEnabled())
+		m_bloomFilter.Report(GetScoreProducerDescription());
+	LanguageModelSingleFactor::CleanUpAfterSentenceProcessing();
+}
+
 float LanguageModelInternal::GetValue(const std::vector<const Word*> &contextFactor
 												, State* finalState
 												, unsigned int* len) const
@@ -123,19 +169,19 @@ float LanguageModelInternal::GetValue(const std::vector<const Word*> &contextFac
 	const size_t ngram = contextFactor.size();
 	switch (ngram)
 	{
-	case 1: return GetValue((*contextFactor[0])[m_factorType], finalState); break;
+	case 1: return GetValue((*contextFactor[0])[m_factorType], finalState, len); break;
 	case 2: return GetValue((*contextFactor[0])[m_factorType]
-												, (*contextFactor[1])[m_factorType], finalState); break;
+												, (*contextFactor[1])[m_factorType], finalState, len); break;
 	case 3: return GetValue((*contextFactor[0])[m_factorType]
 												, (*contextFactor[1])[m_factorType]
-												, (*contextFactor[2])[m_factorType], finalState); break;
+												, (*contextFactor[2])[m_factorType], finalState, len); break;
 	}
 
 	assert (false);
 	return 0;
 }
 
-float LanguageModelInternal::GetValue(const Factor *factor0, State* finalState) const
+float LanguageModelInternal::GetValue(const Factor *factor0, State* finalState, unsigned int* len) const
 {
 	float prob;
 	const NGramNode *nGram		= GetLmID(factor0);
@@ -143,17 +189,21 @@ float LanguageModelInternal::GetValue(const Factor *factor0, State* finalState)
 	{
 		if (finalState != NULL)
 			*finalState = NULL;
+		if (len != NULL)
+			*len = 0;
 		prob = -numeric_limits<float>::infinity();
 	}
 	else
 	{
 		if (finalState != NULL)
 			*finalState = static_cast<const void*>(nGram);
+		if (len != NULL)
+			*len = 1;
 		prob = nGram->GetScore();
 	}
 	return FloorScore(prob);
 }
-float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *factor1, State* finalState) const
+float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *factor1, State* finalState, unsigned int* len) const
 {
 	float score;
 	const NGramNode *nGram[2];
@@ -163,15 +213,20 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 	{
 		if (finalState != NULL)
 			*finalState = NULL;
+		if (len != NULL)
+			*len = 0;
 		score = -numeric_limits<float>::infinity();
 	}
 	else
 	{
-		nGram[0] = nGram[1]->GetNGram(factor0);
+		const Factor * const factors[2] = { factor0, factor1 };
+		nGram[0] = GetNGram(nGram[1], factors, 2);
 		if (nGram[0] == NULL)
 		{ // something unigram
 			if (finalState != NULL)
 				*finalState = static_cast<const void*>(nGram[1]);
+			if (len != NULL)
+				*len = 1;
 			
 			nGram[0]	= GetLmID(factor0);
 			if (nGram[0] == NULL)
@@ -187,6 +242,8 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 		{ // bigram
 			if (finalState != NULL)
 				*finalState = static_cast<const void*>(nGram[0]);
+			if (len != NULL)
+				*len = 2;
 			score			= nGram[0]->GetScore();
 		}
 	}
@@ -195,7 +252,7 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 
 }
 
-float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *factor1, const Factor *factor2, State* finalState) const
+float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *factor1, const Factor *factor2, State* finalState, unsigned int* len) const
 {
 	float score;
 	const NGramNode *nGram[3];
@@ -205,15 +262,20 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 	{
 		if (finalState != NULL)
 			*finalState = NULL;
+		if (len != NULL)
+			*len = 0;
 		score = -numeric_limits<float>::infinity();
 	}
 	else
 	{
-		nGram[1] = nGram[2]->GetNGram(factor1);
+		const Factor * const factors[3] = { factor0, factor1, factor2 };
+		nGram[1] = GetNGram(nGram[2], factors + 1, 2);
 		if (nGram[1] == NULL)
 		{ // something unigram
 			if (finalState != NULL)
 				*finalState = static_cast<const void*>(nGram[2]);
+			if (len != NULL)
+				*len = 1;
 			
 			nGram[1]	= GetLmID(factor1);
 			if (nGram[1] == NULL)
@@ -222,7 +284,7 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 			}
 			else
 			{
-				nGram[0] = nGram[1]->GetNGram(factor0);
+				nGram[0] = GetNGram(nGram[1], factors, 2);
 				if (nGram[0] == NULL)
 				{ // unigram unigram
 					score = nGram[2]->GetScore() + nGram[1]->GetLogBackOff();
@@ -235,21 +297,25 @@ float LanguageModelInternal::GetValue(const Factor *factor0, const Factor *facto
 		}
 		else
 		{ // trigram, or something bigram
-			nGram[0] = nGram[1]->GetNGram(factor0);
+			nGram[0] = GetNGram(nGram[1], factors, 3);
 			if (nGram[0] != NULL)
 			{ // trigram
 				if (finalState != NULL)
 					*finalState = static_cast<const void*>(nGram[0]);
+				if (len != NULL)
+					*len = 3;
 				score = nGram[0]->GetScore();
 			}
 			else
 			{
 				if (finalState != NULL)
 					*finalState = static_cast<const void*>(nGram[1]);
+				if (len != NULL)
+					*len = 2;
 				
 				score			= nGram[1]->GetScore();
 				nGram[1]	= nGram[1]->GetRootNGram();
-				nGram[0]	= nGram[1]->GetNGram(factor0);
+				nGram[0]	= GetNGram(nGram[1], factors, 2);
 				if (nGram[0] == NULL)
 				{ // just bigram
 					// do nothing
@@ -2,7 +2,9 @@
 #pragma once
 
 #include "LanguageModelSingleFactor.h"
+#include "LMIdLookup.h"
 #include "NGramCollection.h"
+#include "BloomFilter.h"
 
 namespace Moses
 {
@@ -12,18 +14,30 @@ namespace Moses
 class LanguageModelInternal : public LanguageModelSingleFactor
 {
 protected:
-	std::vector<const NGramNode*> m_lmIdLookup;
+	LMIdLookup<const NGramNode*> m_lmIdLookup;
 	NGramCollection m_map;
+	BloomFilter m_bloomFilter; //! all n-grams in m_map, if bloom-filter-bits is set
 
 	const NGramNode* GetLmID( const Factor *factor ) const
 	{
-		size_t factorId = factor->GetId();
-		return ( factorId >= m_lmIdLookup.size()) ? NULL : m_lmIdLookup[factorId];        
+		return m_lmIdLookup.Get(factor);
   };
 
-	float GetValue(const Factor *factor0, State* finalState) const;
-	float GetValue(const Factor *factor0, const Factor *factor1, State* finalState) const;
-	float GetValue(const Factor *factor0, const Factor *factor1, const Factor *factor2, State* finalState) const;
+	/** n-gram node extending node by the first of the factors, which are the words of the n-gram.
+	 * Skips the lookup if the n-gram certainly isn't in the LM
+	 */
+	const NGramNode *GetNGram(const NGramNode *node, const Factor * const *nGram, size_t order) const
+	{
+		if (m_bloomFilter.IsEnabled() && !m_bloomFilter.MayContain(BloomFilter::GetKey(nGram, order)))
+			return NULL;
+		const NGramNode *ret = node->GetNGram(nGram[0]);
+		if (ret == NULL && m_bloomFilter.IsEnabled())
+			m_bloomFilter.AddFalsePositive();
+		return ret;
+	}
+	float GetValue(const Factor *factor0, State* finalState, unsigned int* len) const;
+	float GetValue(const Factor *factor0, const Factor *factor1, State* finalState, unsigned int* len) const;
+	float GetValue(const Factor *factor0, const Factor *factor1, const Factor *factor2, State* finalState, unsigned int* len) const;
 
 public:
 	LanguageModelInternal(bool registerScore, ScoreIndexManager &scoreIndexManager);
@@ -31,6 +45,7 @@ public:
 					, FactorType factorType
 					, float weight
 					, size_t nGramOrder);
+	void CleanUpAfterSentenceProcessing();
 	float GetValue(const std::vector<const Word*> &contextFactor
 												, State* finalState = 0
 												, unsigned int* len = 0) const;
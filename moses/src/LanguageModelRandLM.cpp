@@ -49,38 +49,18 @@ bool LanguageModelRandLM::Load(const std::string &filePath, FactorType factorTyp
 }
 
 void LanguageModelRandLM::CreateFactors(FactorCollection &factorCollection) { // add factors which have randlm id
-  // code copied & paste from SRI LM class. should do template function
-  // first get all bf vocab in map
-  std::map<size_t, randlm::WordID> randlm_ids_map; // map from factor id -> randlm id
-  size_t maxFactorId = 0; // to create lookup vector later on
+  m_randlm_ids_vec.Init(m_oov_id);
   for(std::map<randlm::Word, randlm::WordID>::const_iterator vIter = m_lm->vocabStart();
       vIter != m_lm->vocabEnd(); vIter++){
     // get word from randlm vocab and associate with (new) factor id
-    size_t factorId=factorCollection.AddFactor(Output,m_factorType,vIter->first)->GetId();
-    randlm_ids_map[factorId] = vIter->second;
-    maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+    m_randlm_ids_vec.Add(factorCollection.AddFactor(Output,m_factorType,vIter->first), vIter->second);
   }
-  // add factors for BOS and EOS and store bf word ids
-  size_t factorId;
+  // add factors for BOS and EOS
   m_sentenceStart = factorCollection.AddFactor(Output, m_factorType, m_lm->getBOS());
-  factorId = m_sentenceStart->GetId();
-  maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
   m_sentenceStartArray[m_factorType] = m_sentenceStart;
 
   m_sentenceEnd	= factorCollection.AddFactor(Output, m_factorType, m_lm->getEOS());
-  factorId = m_sentenceEnd->GetId();
-  maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
   m_sentenceEndArray[m_factorType] = m_sentenceEnd;
-
-  // add to lookup vector in object
-  m_randlm_ids_vec.resize(maxFactorId+1);
-  // fill with OOV code
-  fill(m_randlm_ids_vec.begin(), m_randlm_ids_vec.end(), m_oov_id);
-
-  for (map<size_t, randlm::WordID>::const_iterator iter = randlm_ids_map.begin();
-       iter != randlm_ids_map.end() ; ++iter)
-    m_randlm_ids_vec[iter->first] = iter->second;
-
 }
 
 randlm::WordID LanguageModelRandLM::GetLmID( const std::string &str ) const {
@@ -101,7 +81,7 @@ float LanguageModelRandLM::GetValue(const vector<const Word*> &contextFactor,
   }
   int found = 0;
   float logprob = FloorScore(TransformSRIScore(m_lm->getProb(&ngram[0], count, &found, finalState)));
-  *len = 0; // not available
+  // len not available, left as it is
   //if (finalState)
   //  std::cerr << " = " << logprob << "(" << *finalState << ", " << *len <<")"<< std::endl;
   //else
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Factor.h"
 #include "Util.h"
 #include "LanguageModelSingleFactor.h"
+#include "LMIdLookup.h"
 #include "RandLM.h"
 
 class randlm::RandLM;
@@ -45,18 +46,17 @@ public:
     delete m_lm;
   }
   void CleanUpAfterSentenceProcessing() {
+    LanguageModel::CleanUpAfterSentenceProcessing();
     m_lm->clearCaches(); // clear caches
   }
-  void InitializeBeforeSentenceProcessing() {} // nothing to do
  protected:
-  std::vector<randlm::WordID> m_randlm_ids_vec;
+  LMIdLookup<randlm::WordID> m_randlm_ids_vec;
   randlm::RandLM* m_lm;
   randlm::WordID m_oov_id;
   void CreateFactors(FactorCollection &factorCollection);
   randlm::WordID GetLmID( const std::string &str ) const;
   randlm::WordID GetLmID( const Factor *factor ) const{
-    size_t factorId = factor->GetId();
-    return ( factorId >= m_randlm_ids_vec.size()) ? m_oov_id : m_randlm_ids_vec[factorId];
+    return m_randlm_ids_vec.Get(factor);
   };
 
 };
@@ -73,7 +73,7 @@ float LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFacto
   const FactorType factor = GetFactorType();
   if (max > count) max = count;
  
-  Cache* cur = &m_cache;
+  Cache* cur = &m_remoteCache;
   int pc = static_cast<int>(count) - 1;
   for (int i = 0; i < pc; ++i) {
     const Factor* f = contextFactor[i]->GetFactor(factor);
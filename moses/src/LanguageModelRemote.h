@@ -23,14 +23,14 @@ class LanguageModelRemote : public LanguageModelSingleFactor {
 		struct hostent *hp;
 		struct sockaddr_in server;
 		mutable size_t m_curId;
-		mutable Cache m_cache;
+		mutable Cache m_remoteCache; //! probabilities got from the server for this sentence, apart from the n-gram cache of LanguageModel
                 bool start(const std::string& host, int port);
 		static const Factor* BOS;
 		static const Factor* EOS;
 	public:
 		LanguageModelRemote(bool registerScore, ScoreIndexManager &scoreIndexManager);
 		~LanguageModelRemote();
-		void ClearSentenceCache() { m_cache.tree.clear(); m_curId = 1000; }
+		void ClearSentenceCache() { m_remoteCache.tree.clear(); m_curId = 1000; }
 		virtual float GetValue(const std::vector<const Word*> &contextFactor, State* finalState = 0, unsigned int* len = 0) const;
         	bool Load(const std::string &filePath
                                         , FactorType factorType
@@ -68,8 +68,8 @@ bool LanguageModelSRI::Load(const std::string &filePath
 	m_srilmModel->read(file);
 
 	// LM can be ok, just outputs warnings
-	CreateFactors();		
   m_unknownId = m_srilmVocab->unkIndex();
+	CreateFactors();		
   
   return true;
 }
@@ -78,43 +78,23 @@ void LanguageModelSRI::CreateFactors()
 { // add factors which have srilm id
 	FactorCollection &factorCollection = FactorCollection::Instance();
 	
-	std::map<size_t, VocabIndex> lmIdMap;
-	size_t maxFactorId = 0; // to create lookup vector later on
-	
+	m_lmIdLookup.Init(m_unknownId);
+
 	VocabString str;
 	VocabIter iter(*m_srilmVocab);
 	while ( (str = iter.next()) != NULL)
 	{
 		VocabIndex lmId = GetLmID(str);
-		size_t factorId = factorCollection.AddFactor(Output, m_factorType, str)->GetId();
-		lmIdMap[factorId] = lmId;
-		maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+		m_lmIdLookup.Add(factorCollection.AddFactor(Output, m_factorType, str), lmId);
 	}
 	
-	size_t factorId;
-	
 	m_sentenceStart = factorCollection.AddFactor(Output, m_factorType, BOS_);
-	factorId = m_sentenceStart->GetId();
-	lmIdMap[factorId] = GetLmID(BOS_);
-	maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+	m_lmIdLookup.Add(m_sentenceStart, GetLmID(BOS_));
 	m_sentenceStartArray[m_factorType] = m_sentenceStart;
 	
 	m_sentenceEnd		= factorCollection.AddFactor(Output, m_factorType, EOS_);
-	factorId = m_sentenceEnd->GetId();
-	lmIdMap[factorId] = GetLmID(EOS_);
-	maxFactorId = (factorId > maxFactorId) ? factorId : maxFactorId;
+	m_lmIdLookup.Add(m_sentenceEnd, GetLmID(EOS_));
 	m_sentenceEndArray[m_factorType] = m_sentenceEnd;
-	
-	// add to lookup vector in object
-	m_lmIdLookup.resize(maxFactorId+1);
-	
-	fill(m_lmIdLookup.begin(), m_lmIdLookup.end(), m_unknownId);
-
-	map<size_t, VocabIndex>::iterator iterMap;
-	for (iterMap = lmIdMap.begin() ; iterMap != lmIdMap.end() ; ++iterMap)
-	{
-		m_lmIdLookup[iterMap->first] = iterMap->second;
-	}
 }
 
 VocabIndex LanguageModelSRI::GetLmID( const std::string &str ) const
@@ -123,8 +103,7 @@ VocabIndex LanguageModelSRI::GetLmID( const std::string &str ) const
 }
 VocabIndex LanguageModelSRI::GetLmID( const Factor *factor ) const
 {
-	size_t factorId = factor->GetId();
-	return ( factorId >= m_lmIdLookup.size()) ? m_unknownId : m_lmIdLookup[factorId];
+	return m_lmIdLookup.Get(factor);
 }
 
 float LanguageModelSRI::GetValue(VocabIndex wordId, VocabIndex *context) const
@@ -133,6 +112,46 @@ float LanguageModelSRI::GetValue(VocabIndex wordId, VocabIndex *context) const
 	return FloorScore(TransformSRIScore(p));  // log10->log
 }
 
+void LanguageModelSRI::CalcScore(const Phrase &phrase
+																, float &fullScore
+																, float &ngramScore) const
+{
+	fullScore	= 0;
+	ngramScore	= 0;
+
+	// while a sentence is decoded, the n-grams go through the n-gram cache like those of the other LMs
+	if (m_useCache)
+	{
+		LanguageModel::CalcScore(phrase, fullScore, ngramScore);
+		return;
+	}
+
+	const size_t phraseSize = phrase.GetSize();
+	if (phraseSize == 0)
+		return;
+
+	// map the phrase once, then build each context from the ids
+	vector<VocabIndex> lmIds(phraseSize);
+	m_lmIdLookup.Map(phrase, m_factorType, &lmIds[0]);
+
+	VocabIndex context[MAX_NGRAM_SIZE];
+	for (size_t currPos = 0 ; currPos < phraseSize ; currPos++)
+	{
+		// most recent word first
+		const size_t contextSize = std::min(currPos, m_nGramOrder - 1);
+		for (size_t i = 0 ; i < contextSize ; i++)
+			context[i] = lmIds[currPos - 1 - i];
+		context[contextSize] = Vocab_None;
+
+		float score = GetValue(lmIds[currPos], context);
+		if (currPos < m_nGramOrder - 1)
+			fullScore += score;
+		else
+			ngramScore += score;
+	}
+	fullScore += ngramScore;
+}
+
 float LanguageModelSRI::GetValue(const vector<const Word*> &contextFactor, State* finalState, unsigned int *len) const
 {
 	FactorType	factorType = GetFactorType();
@@ -156,14 +175,16 @@ float LanguageModelSRI::GetValue(const vector<const Word*> &contextFactor, State
 	VocabIndex lmId= GetLmID((*contextFactor[count-1])[factorType]);
 	float ret = GetValue(lmId, context);
 
-	if (finalState) {
+	if (finalState || len) {
+		// longest context of the LM ending in this word
 		for (int i = count - 2 ; i >= 0 ; i--)
 			context[i+1] = context[i];
 		context[0] = lmId;
 		unsigned int dummy;
 		if (!len) { len = &dummy; }
-		*finalState = m_srilmModel->contextID(context,*len);
-		(*len)++;
+		State state = m_srilmModel->contextID(context,*len);
+		if (finalState)
+			*finalState = state;
 	}
 	return ret;
 }
@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TypeDef.h"
 #include "Vocab.h"
 #include "LanguageModelSingleFactor.h"
+#include "LMIdLookup.h"
 
 class Factor;
 class Phrase;
@@ -38,7 +39,7 @@ namespace Moses
 class LanguageModelSRI : public LanguageModelSingleFactor
 {
 protected:
-	std::vector<VocabIndex> m_lmIdLookup;
+	LMIdLookup<VocabIndex> m_lmIdLookup;
 	Vocab 			*m_srilmVocab;
 	Ngram 			*m_srilmModel;
 	VocabIndex	m_unknownId;
@@ -56,6 +57,10 @@ public:
 					, float weight
 					, size_t nGramOrder);
 
+	//! maps the words of the phrase to SRI ids once, rather than for each n-gram. Goes through the n-gram cache while a sentence is decoded
+	void CalcScore(const Phrase &phrase
+							, float &fullScore
+							, float &ngramScore) const;
   virtual float GetValue(const std::vector<const Word*> &contextFactor, State* finalState = 0, unsigned int* len = 0) const;
 };
 
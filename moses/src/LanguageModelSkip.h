@@ -22,7 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #pragma once
 
 #include <vector>
-#include <algorithm>
+#include <cassert>
 #include "LanguageModelMultiFactor.h"
 #include "LanguageModelSingleFactor.h"
 #include "Phrase.h"
@@ -37,9 +37,33 @@ namespace Moses
 class LanguageModelSkip : public LanguageModelSingleFactor
 {	
 protected:
+	static const size_t MAX_CHUNK_ORDER = 8; //! size of the stack buffer for the chunk context
+
 	size_t m_realNGramOrder;
 	LanguageModelSingleFactor *m_lmImpl;
-	
+	std::vector<bool> m_skipFactor; //! indexed by factor id, for all factors which existed at the start of the sentence
+	mutable std::vector<const Word*> m_chunk; //! reused by GetValue(), so queries don't allocate. LM queries aren't concurrent, see GetScoreLock()
+
+	static bool IsSkipString(const std::string &str)
+	{
+		return str.compare(0, 3, "---") == 0;
+	}
+	//! add skip flags for the factors created since the flags were last extended
+	void ExtendSkipFlags()
+	{
+		std::vector<const Factor*> factors;
+		FactorCollection::Instance().GetFactors(m_skipFactor.size(), factors);
+		m_skipFactor.reserve(m_skipFactor.size() + factors.size());
+		for (size_t i = 0 ; i < factors.size() ; ++i)
+			m_skipFactor.push_back(IsSkipString(factors[i]->GetString()));
+	}
+	//! factors created during the sentence aren't in m_skipFactor yet
+	bool IsSkipped(const Factor *factor) const
+	{
+		const size_t id = factor->GetId();
+		return (id < m_skipFactor.size()) ? m_skipFactor[id] : IsSkipString(factor->GetString());
+	}
+
 public:
 	/** Constructor
 	* \param lmImpl SRI or IRST LM which this LM can use to load data
@@ -50,6 +74,7 @@ public:
 	: LanguageModelSingleFactor(registerScore, scoreIndexManager)
 	{
 		m_lmImpl = lmImpl;		
+		m_chunk.reserve(MAX_CHUNK_ORDER);
 	}
 	~LanguageModelSkip()
 	{
@@ -66,16 +91,26 @@ public:
 		m_nGramOrder 				= nGramOrder;
 		
 		m_realNGramOrder 		= 3;
+		assert(m_realNGramOrder <= MAX_CHUNK_ORDER);
 
 		FactorCollection &factorCollection = FactorCollection::Instance();
 
 		m_sentenceStartArray[m_factorType] = factorCollection.AddFactor(Output, m_factorType, BOS_);
 		m_sentenceEndArray[m_factorType] = factorCollection.AddFactor(Output, m_factorType, EOS_);
 
-		return m_lmImpl->Load(filePath, m_factorType, weight, nGramOrder);
+		bool ret = m_lmImpl->Load(filePath, m_factorType, weight, nGramOrder);
+		ExtendSkipFlags();
+		return ret;
+	}
+
+	void InitializeBeforeSentenceProcessing()
+	{
+		LanguageModelSingleFactor::InitializeBeforeSentenceProcessing();
+		// words of the input and of later models are interned after Load()
+		ExtendSkipFlags();
 	}
 			
-	float GetValue(const std::vector<const Word*> &contextFactor, State* finalState = NULL, unsigned int* len = NULL) const
+	float GetValue(const std::vector<const Word*> &contextFactor, State* finalState = NULL, unsigned int* /*len*/ = NULL) const
 	{
 		if (contextFactor.size() == 0)
 		{
@@ -83,45 +118,31 @@ public:
 		}
 
 		// only process context where last word is a word we want
-		const Factor *factor = (*contextFactor.back())[m_factorType];
-		std::string strWord = factor->GetString();
-		if (strWord.find("---") == 0)
+		if (IsSkipped((*contextFactor.back())[m_factorType]))
 			return 0;
 		
-		// add last word
-		std::vector<const Word*> chunkContext;
-		Word* chunkWord = new Word;
-		chunkWord->SetFactor(m_factorType, factor);
-		chunkContext.push_back(chunkWord);
-		
-		// create context in reverse 'cos we skip words we don't want
-		for (int currPos = (int)contextFactor.size() - 2 ; currPos >= 0 && chunkContext.size() < m_realNGramOrder ; --currPos )
+		// create context in reverse 'cos we skip words we don't want.
+		// The LM only reads m_factorType, so the words themselves can be passed on
+		const Word *chunkBuffer[MAX_CHUNK_ORDER];
+		const Word **chunkBegin = chunkBuffer + MAX_CHUNK_ORDER;
+		*--chunkBegin = contextFactor.back();
+		for (int currPos = (int)contextFactor.size() - 2 ; currPos >= 0 && (size_t) (chunkBuffer + MAX_CHUNK_ORDER - chunkBegin) < m_realNGramOrder ; --currPos )
 		{
-			const Word &word = *contextFactor[currPos];
-			factor = word[m_factorType];
-			std::string strWord = factor->GetString();
-			bool skip = strWord.find("---") == 0;
-			if (skip)
+			const Word *word = contextFactor[currPos];
+			if (IsSkipped((*word)[m_factorType]))
 				continue;
-
-			// add word to chunked context
-			Word* chunkWord = new Word;
-			chunkWord->SetFactor(m_factorType, factor);
-			chunkContext.push_back(chunkWord);
+			*--chunkBegin = word;
 		}
-	
-		// create context factor the right way round
-		std::reverse(chunkContext.begin(), chunkContext.end());
 
 		// calc score on chunked phrase
-		float ret = m_lmImpl->GetValue(chunkContext, finalState, len);
-
-		RemoveAllInColl(chunkContext);
-
-		return ret;
+		// len from the LM counts chunked words, which don't map back to words of the context
+		const size_t chunkSize = chunkBuffer + MAX_CHUNK_ORDER - chunkBegin;
+		if (chunkSize == contextFactor.size())
+			return m_lmImpl->GetValue(contextFactor, finalState);
+		m_chunk.assign(chunkBegin, chunkBuffer + MAX_CHUNK_ORDER);
+		return m_lmImpl->GetValue(m_chunk, finalState);
 	}
 };
 
 }
 
-
@@ -0,0 +1,76 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <algorithm>
+#include "LatticeDistances.h"
+
+namespace Moses
+{
+
+const int LatticeDistances::UNREACHABLE;
+
+void LatticeDistances::Init(size_t numNodes)
+{
+	m_edges.clear();
+	m_edges.resize(numNodes);
+	m_distances.clear();
+	m_distances.resize(numNodes);
+	m_numDone.clear();
+	m_numDone.resize(numNodes, 0);
+}
+
+int LatticeDistances::GetDistance(size_t from, size_t to) const
+{
+	if (to <= from || to >= m_edges.size())
+		return UNREACHABLE;
+
+	// distances[i] is the distance from node from to node from + i
+	std::vector<int> &distances = m_distances[from];
+	size_t &numDone = m_numDone[from];
+	if (distances.empty())
+		distances.push_back(0);
+
+	// the distance to a node is final once the edges of all nodes before it have been followed
+	while (numDone < to - from)
+	{
+		const size_t node = from + numDone;
+		if (numDone < distances.size() && distances[numDone] != UNREACHABLE)
+		{
+			const int distance = distances[numDone] + 1;
+			const std::vector<size_t> &edges = m_edges[node];
+			for (size_t i = 0 ; i < edges.size() ; ++i)
+			{
+				const size_t offset = edges[i] - from;
+				if (offset >= distances.size())
+					distances.resize(offset + 1, UNREACHABLE);
+				distances[offset] = std::min(distances[offset], distance);
+			}
+		}
+		++numDone;
+	}
+
+	const size_t offset = to - from;
+	return (offset < distances.size()) ? distances[offset] : UNREACHABLE;
+}
+
+}
+
@@ -0,0 +1,65 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <climits>
+#include <vector>
+
+namespace Moses
+{
+
+/** lengths of the shortest paths between the nodes of a lattice, whose edges all lead to a later node.
+ * As the node order is topological, the distances from a node are found by a single pass over the
+ * nodes after it. The pass is only taken as far as the furthest node asked for so far, and only
+ * for the start nodes asked for, so a lattice costs nothing until distances in it are needed.
+ * Same results as floyd_warshall() on the edge matrix, including UNREACHABLE from a node to itself
+ */
+class LatticeDistances
+{
+protected:
+	std::vector<std::vector<size_t> > m_edges; //! end nodes of the edges from each node
+	mutable std::vector<std::vector<int> > m_distances; //! from each start node, to the nodes after it
+	mutable std::vector<size_t> m_numDone; //! nodes whose edges have been followed, from each start node
+
+public:
+	//! distance between nodes without a path. Can be added to a distance without overflow
+	static const int UNREACHABLE = INT_MAX / 2;
+
+	//! forget all edges and distances
+	void Init(size_t numNodes);
+	void AddEdge(size_t from, size_t to)
+	{
+		if (to > from && to < m_edges.size())
+			m_edges[from].push_back(to);
+	}
+	size_t GetNumNodes() const
+	{
+		return m_edges.size();
+	}
+
+	//! number of edges on the shortest path, UNREACHABLE if there is none
+	int GetDistance(size_t from, size_t to) const;
+};
+
+}
+
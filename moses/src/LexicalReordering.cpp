@@ -9,7 +9,7 @@ LexicalReordering::LexicalReordering(const std::string &filePath,
 									 Condition condition, 
 									 std::vector< FactorType >& f_factors, 
 									 std::vector< FactorType >& e_factors)
-  : m_NumScoreComponents(weights.size()), m_MaxContextLength(0) 
+  : m_FilePath(filePath), m_NumScoreComponents(weights.size()), m_MaxContextLength(0) 
 {
   std::cerr << "Creating lexical reordering...\n";
   //add ScoreProducer
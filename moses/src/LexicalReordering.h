@@ -62,6 +62,22 @@ class LexicalReordering : public StatefulFeatureFunction {
   void InitializeForInput(const InputType& i){
     m_Table->InitializeForInput(i);
   }
+  //! false if the table couldn't be loaded
+  bool IsLoaded() const {
+    return 0 != m_Table;
+  }
+  //! source phrases of the translation options of a sentence, which are about to be looked up
+  void Prefetch(const std::vector<const Phrase*>& sourcePhrases) const {
+    m_Table->Prefetch(sourcePhrases);
+  }
+  //! true if the scores come with the target phrases of the translation options
+  bool IsMergedIntoPhraseTable() const {
+    return m_Table->IsMergedIntoPhraseTable();
+  }
+  //! table file, or the binary phrase table the scores are merged into
+  const std::string& GetFilePath() const {
+    return m_FilePath;
+  }
 
   Score GetProb(const Phrase& f, const Phrase& e) const;
   //helpers
@@ -71,6 +87,7 @@ class LexicalReordering : public StatefulFeatureFunction {
   Phrase auxGetContext(const Hypothesis* hypothesis) const;
  private:
   LexicalReorderingTable* m_Table;
+  std::string m_FilePath;
   size_t m_NumScoreComponents;
   std::vector< Direction > m_Direction;
   std::vector< Condition > m_Condition;
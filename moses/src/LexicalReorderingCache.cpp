@@ -0,0 +1,144 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include "LexicalReorderingCache.h"
+#include "Factor.h"
+#include "Phrase.h"
+
+namespace Moses
+{
+
+const size_t LexicalReorderingCache::INITIAL_SIZE;
+
+void LexicalReorderingCache::Init(const std::vector<FactorType> &factorsF, const std::vector<FactorType> &factorsE)
+{
+	m_factorsF = factorsF;
+	m_factorsE = factorsE;
+	m_entries.clear();
+	m_entries.resize(INITIAL_SIZE);
+	m_mask = INITIAL_SIZE - 1;
+	for (size_t i = 0 ; i < m_entries.size() ; ++i)
+		m_entries[i].generation = 0;
+	m_numEntries = 0;
+	m_generation = 1;
+}
+
+void LexicalReorderingCache::Clear()
+{
+	if (++m_generation == 0)
+	{ // wrapped around. Old entries could look valid again
+		for (size_t i = 0 ; i < m_entries.size() ; ++i)
+			m_entries[i].generation = 0;
+		m_generation = 1;
+	}
+	m_numEntries = 0;
+}
+
+void LexicalReorderingCache::MakeKey(const Phrase &f, const Phrase &e)
+{
+	m_key.clear();
+	for (size_t pos = 0 ; pos < f.GetSize() ; ++pos)
+		for (size_t i = 0 ; i < m_factorsF.size() ; ++i)
+			m_key.push_back(f.GetFactor(pos, m_factorsF[i]));
+	// separates source and target, so that phrase pairs which split the same words differently differ
+	m_key.push_back(NULL);
+	for (size_t pos = 0 ; pos < e.GetSize() ; ++pos)
+		for (size_t i = 0 ; i < m_factorsE.size() ; ++i)
+			m_key.push_back(e.GetFactor(pos, m_factorsE[i]));
+
+	size_t hash = m_key.size();
+	for (size_t i = 0 ; i < m_key.size() ; ++i)
+	{
+		hash ^= (m_key[i] == NULL) ? 0 : m_key[i]->GetId() + 1;
+		hash *= 0x9E3779B1;
+		hash ^= hash >> 15;
+	}
+	m_hash = hash;
+}
+
+size_t LexicalReorderingCache::FindIndex() const
+{
+	size_t index = m_hash & m_mask;
+	while (true)
+	{
+		const Entry &entry = m_entries[index];
+		if (entry.generation != m_generation
+				|| (entry.hash == m_hash && entry.key == m_key))
+			return index;
+		index = (index + 1) & m_mask;
+	}
+}
+
+void LexicalReorderingCache::Grow()
+{
+	std::vector<Entry> entries(m_entries.empty() ? INITIAL_SIZE : m_entries.size() * 2);
+	for (size_t i = 0 ; i < entries.size() ; ++i)
+		entries[i].generation = 0;
+	const size_t mask = entries.size() - 1;
+	for (size_t i = 0 ; i < m_entries.size() ; ++i)
+	{
+		Entry &entry = m_entries[i];
+		if (entry.generation != m_generation)
+			continue;
+		size_t index = entry.hash & mask;
+		while (entries[index].generation != 0)
+			index = (index + 1) & mask;
+		Entry &newEntry = entries[index];
+		newEntry.generation = 1;
+		newEntry.hash = entry.hash;
+		newEntry.key.swap(entry.key);
+		newEntry.cands.swap(entry.cands);
+	}
+	m_entries.swap(entries);
+	m_mask = mask;
+	m_generation = 1;
+}
+
+const Candidates *LexicalReorderingCache::Find(const Phrase &f, const Phrase &e)
+{
+	if (m_entries.empty())
+		return NULL;
+	MakeKey(f, e);
+	const Entry &entry = m_entries[FindIndex()];
+	return (entry.generation == m_generation) ? &entry.cands : NULL;
+}
+
+Candidates &LexicalReorderingCache::Insert(const Phrase &f, const Phrase &e)
+{
+	// at most half full, so that probe sequences stay short
+	if (m_entries.empty() || 2 * (m_numEntries + 1) > m_entries.size())
+		Grow();
+	MakeKey(f, e);
+	Entry &entry = m_entries[FindIndex()];
+	if (entry.generation != m_generation)
+	{
+		entry.generation = m_generation;
+		entry.hash = m_hash;
+		entry.key = m_key;
+		entry.cands.clear();
+		++m_numEntries;
+	}
+	return entry.cands;
+}
+
+}
+
@@ -0,0 +1,93 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include "TypeDef.h"
+#include "PrefixTreeMap.h"
+
+namespace Moses
+{
+
+class Factor;
+class Phrase;
+
+/** cache of lexical reordering table candidates, keyed by phrase pair.
+ * Keys are the factors of the source and target phrase, hashed by their ids, so a
+ * lookup doesn't build any strings. Open addressing with linear probing in a table
+ * which grows as needed. Clear() only bumps a generation counter, so clearing for
+ * each sentence is cheap, and the memory of the entries is reused
+ */
+class LexicalReorderingCache
+{
+protected:
+	struct Entry
+	{
+		unsigned int generation; //! entry is in use if same as m_generation
+		size_t hash;
+		std::vector<const Factor*> key;
+		Candidates cands;
+	};
+
+	static const size_t INITIAL_SIZE = 1024;
+
+	std::vector<Entry> m_entries;
+	size_t m_mask, m_numEntries;
+	unsigned int m_generation;
+	std::vector<FactorType> m_factorsF, m_factorsE;
+	std::vector<const Factor*> m_key; //! of the last lookup
+	size_t m_hash;
+
+	//! set m_key and m_hash to the key of f and e
+	void MakeKey(const Phrase &f, const Phrase &e);
+	//! index of the entry for m_key, or of the free entry where it would go
+	size_t FindIndex() const;
+	void Grow();
+
+public:
+	LexicalReorderingCache()
+	:m_mask(0)
+	,m_numEntries(0)
+	,m_generation(1)
+	,m_hash(0)
+	{}
+
+	//! factors of the source and target phrases which the table is keyed on
+	void Init(const std::vector<FactorType> &factorsF, const std::vector<FactorType> &factorsE);
+	//! forget all entries
+	void Clear();
+	size_t GetSize() const
+	{
+		return m_numEntries;
+	}
+
+	//! candidates stored for f and e, or NULL. Valid until the next Insert()
+	const Candidates *Find(const Phrase &f, const Phrase &e);
+	/** entry for f and e, to be filled by the caller. Candidates of a new entry are empty.
+	 * Filled in place, table entries aren't copied, and their memory is reused. Valid until the next Insert()
+	 */
+	Candidates &Insert(const Phrase &f, const Phrase &e);
+};
+
+}
+
@@ -1,4 +1,5 @@
 #include "LexicalReorderingTable.h"
+#include "LexicalReorderingTableBinary.h"
 #include "InputFileStream.h"
 //#include "LVoc.h" //need IPhrase
 
@@ -33,19 +34,28 @@ std::string auxClearString(const std::string& str){
   return str.substr(i,j-i+1);
 }
 
-void auxAppend(IPhrase& head, const IPhrase& tail){
-  head.reserve(head.size()+tail.size());
-  for(size_t i = 0; i < tail.size(); ++i){
-	head.push_back(tail[i]);
-  }
-}
 /* 
  * functions for LexicalReorderingTable
  */
 
 LexicalReorderingTable* LexicalReorderingTable::LoadAvailable(const std::string& filePath, const FactorList& f_factors, const FactorList& e_factors, const FactorList& c_factors){
-	//decide use Tree or Memory table
-	if(FileExists(filePath+".binlexr.idx")){
+	//decide use Merged, Binary, Tree or Memory table
+	if(FileExists(filePath+".binphr.reordering")){
+	  //filePath is a binary phrase table with the scores merged in
+	  if(f_factors.empty() || e_factors.empty() || !c_factors.empty()){
+		std::cerr << "Reordering scores merged into phrase table " << filePath << " are conditioned on f and e only\n";
+		return 0;
+	  }
+	  return new LexicalReorderingTableMerged(f_factors, e_factors, c_factors);
+	} else if(c_factors.empty() && FileExists(filePath+".binlexq")){
+	  //there exists a memory mapped version, for tables not conditioned on context
+	  LexicalReorderingTableBinary* table = new LexicalReorderingTableBinary(f_factors, e_factors, c_factors);
+	  if(!table->Load(filePath)){
+		delete table;
+		return 0;
+	  }
+	  return table;
+	} else if(FileExists(filePath+".binlexr.idx")){
 	  //there exists a binary version use that
 	  return new LexicalReorderingTableTree(filePath, f_factors, e_factors, c_factors);
 	} else {
@@ -206,9 +216,10 @@ LexicalReorderingTableTree::LexicalReorderingTableTree(
 			    const std::vector<FactorType>& f_factors, 
 				const std::vector<FactorType>& e_factors,
 			    const std::vector<FactorType>& c_factors)
-  : LexicalReorderingTable(f_factors, e_factors, c_factors) 
+  : LexicalReorderingTable(f_factors, e_factors, c_factors), m_UseCache(true)
 {
   m_Table.Read(filePath+".binlexr"); 
+  m_Cache.Init(f_factors, e_factors);
 }
 
 LexicalReorderingTableTree::~LexicalReorderingTableTree(){
@@ -223,39 +234,21 @@ Score LexicalReorderingTableTree::GetScore(const Phrase& f, const Phrase& e, con
     //std::cerr << "Not a proper key!\n";
     return Score();
   }
-  CacheType::iterator i;;
-  if(m_UseCache){
-    std::pair<CacheType::iterator, bool> r = m_Cache.insert(std::make_pair(MakeCacheKey(f,e),Candidates()));
-    if(!r.second){
-      return auxFindScoreForContext((r.first)->second, c);
-    }
-    i = r.first;
-  } else if(!m_Cache.empty()) { 
+  if(m_UseCache || m_Cache.GetSize() > 0){
     //although we might not be caching now, cache might be none empty!
-	i = m_Cache.find(MakeCacheKey(f,e));
-    if(i != m_Cache.end()){
-      return auxFindScoreForContext(i->second, c);
-	}
+    const Candidates* cached = m_Cache.Find(f,e);
+    if(0 != cached){
+      return auxFindScoreForContext(*cached, c);
+    }
   }
-  //not in cache go to file...
-  Score      score;
-  Candidates cands; 
+  //not in cache go to file, and cache for future use, also if there are no candidates
+  Candidates uncached;
+  Candidates& cands = m_UseCache ? m_Cache.Insert(f,e) : uncached;
   m_Table.GetCandidates(MakeTableKey(f,e), &cands);
   if(cands.empty()){
     return Score();
   } 
-
-  if(m_FactorsC.empty()){
-	assert(1 == cands.size());
-	return cands[0].GetScore(0);
-  } else {
-	score = auxFindScoreForContext(cands, c);
-  }
-  //cache for future use
-  if(m_UseCache){
-    i->second = cands;
-  }
-  return score;
+  return auxFindScoreForContext(cands, c);
 };
 
 Score LexicalReorderingTableTree::auxFindScoreForContext(const Candidates& cands, const Phrase& context){
@@ -295,13 +288,10 @@ void LexicalReorderingTableTree::DbgDump(std::ostream* pout){
 */
 
 void LexicalReorderingTableTree::InitializeForInput(const InputType& input){
+  // phrase pairs are cached as they are looked up, for sentences as well as confusion networks.
+  // Caching all phrase pairs of the input in advance takes up too much memory
   ClearCache();
-  if(ConfusionNet const* cn = dynamic_cast<ConfusionNet const*>(&input)){
-    Cache(*cn);
-  } else if(Sentence const* s = dynamic_cast<Sentence const*>(&input)){
-    // Cache(*s); ... this just takes up too much memory, we cache elsewhere
-    DisableCache();
-  }
+  EnableCache();
 };
  
 bool LexicalReorderingTableTree::Create(std::istream& inFile, 
@@ -488,53 +478,35 @@ bool LexicalReorderingTableTree::Create(std::istream& inFile,
   return true;
 }
 
-std::string LexicalReorderingTableTree::MakeCacheKey(const Phrase& f, 
-						     const Phrase& e) const {
-  std::string key;
-  if(!m_FactorsF.empty()){
-    key += auxClearString(f.GetStringRep(m_FactorsF));
-  }
-  if(!m_FactorsE.empty()){
-    if(!key.empty()){
-      key += "|||";
-    }
-    key += auxClearString(e.GetStringRep(m_FactorsE));
-  }
-  return key;
-};
-
 IPhrase LexicalReorderingTableTree::MakeTableKey(const Phrase& f, 
-						 const Phrase& e) const {
+						 const Phrase& e) {
   IPhrase key;
-  std::vector<std::string> keyPart;
   if(!m_FactorsF.empty()){
-    for(int i = 0; i < f.GetSize(); ++i){
-	  /* old code
-      std::string s = f.GetWord(i).ToString(m_FactorsF);
-      keyPart.push_back(s.substr(0,s.size()-1));
-      */
-	  keyPart.push_back(f.GetWord(i).GetString(m_FactorsF, false));
+    for(size_t i = 0; i < f.GetSize(); ++i){
+	  key.push_back(GetLabelId(f.GetWord(i), m_FactorsF, SourceVocId, m_SourceIds));
     }
-    auxAppend(key, m_Table.ConvertPhrase(keyPart, SourceVocId));
-	keyPart.clear();
   }
   if(!m_FactorsE.empty()){
 	if(!key.empty()){
       key.push_back(PrefixTreeMap::MagicWord);
 	}
-    for(int i = 0; i < e.GetSize(); ++i){
-	  /* old code
-      std::string s = e.GetWord(i).ToString(m_FactorsE);
-      keyPart.push_back(s.substr(0,s.size()-1));
-      */
-	  keyPart.push_back(e.GetWord(i).GetString(m_FactorsE, false));
+    for(size_t i = 0; i < e.GetSize(); ++i){
+	  key.push_back(GetLabelId(e.GetWord(i), m_FactorsE, TargetVocId, m_TargetIds));
     }      
-	auxAppend(key, m_Table.ConvertPhrase(keyPart,TargetVocId));
-	//keyPart.clear();
   }
   return key;
 };
 
+LabelId LexicalReorderingTableTree::GetLabelId(const Word& word, const FactorList& factors, 
+						 unsigned int voc, std::map<Word, LabelId>& ids) {
+  std::map<Word, LabelId>::const_iterator i = ids.find(word);
+  if(i == ids.end()){
+	//first time this word is seen, look up its string in the vocabulary of the table
+	i = ids.insert(std::make_pair(word, m_Table.ConvertWord(word.GetString(factors, false), voc))).first;
+  }
+  return i->second;
+}
+
 
 struct State {
   State(PPimp* t, const std::string& p) : pos(t), path(p){
@@ -546,9 +518,7 @@ struct State {
 void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f){
   if(m_FactorsE.empty()){
 	//f is all of key...
-	Candidates cands;
-	m_Table.GetCandidates(MakeTableKey(f,Phrase(Output)),&cands);
-	m_Cache[MakeCacheKey(f,Phrase(Output))] = cands;
+	m_Table.GetCandidates(MakeTableKey(f,Phrase(Output)),&m_Cache.Insert(f,Phrase(Output)));
   } else {
 	ObjectPool<PPimp>     pool;
 	PPimp* pPos  = m_Table.GetRoot();
@@ -566,7 +536,7 @@ void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f){
 	  return;
 	}
 	//2) explore whole subtree depth first & cache
-	std::string cache_key = auxClearString(f.GetStringRep(m_FactorsF)) + "|||";
+	const std::string& factorDelimiter = StaticData::Instance().GetFactorDelimiter();
 	
 	std::vector<State> stack;
 	stack.push_back(State(pool.get(PPimp(pPos->ptr()->getPtr(pPos->idx),0,0)),""));
@@ -578,7 +548,9 @@ void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f){
 		//cache this 
 		m_Table.GetCandidates(*stack.back().pos,&cands);
 		if(!cands.empty()){ 
-		  m_Cache[cache_key + auxClearString(next_path)] = cands;
+		  Phrase e(Output);
+		  e.CreateFromString(m_FactorsE, auxClearString(next_path), factorDelimiter);
+		  m_Cache.Insert(f,e).swap(cands);
 		}
 		cands.clear();
 		PPimp* next_pos = pool.get(PPimp(stack.back().pos->ptr()->getPtr(stack.back().pos->idx),0,0));
@@ -591,22 +563,6 @@ void LexicalReorderingTableTree::auxCacheForSrcPhrase(const Phrase& f){
   }
 }
 
-void LexicalReorderingTableTree::Cache(const ConfusionNet& input){
-  return;
-}
-
-void LexicalReorderingTableTree::Cache(const Sentence& input){
-  //only works with sentences...
-  int prev_cache_size = m_Cache.size();
-  int max_phrase_length = input.GetSize();
-  for(size_t len = 0; len <= max_phrase_length; ++len){ 
-	for(size_t start = 0; start+len <= input.GetSize(); ++start){
-	  Phrase f    = input.GetSubString(WordsRange(start, start+len));
-	  auxCacheForSrcPhrase(f);
-	}
-  }
-  std::cerr << "Cached " << m_Cache.size() - prev_cache_size << " new primary reordering table keys\n"; 
-}
 /*
 Pre fetching implementation using Phrase and Generation Dictionaries 
 *//*
@@ -13,6 +13,7 @@
 #include "ConfusionNet.h"
 #include "Sentence.h"
 #include "PrefixTreeMap.h"
+#include "LexicalReorderingCache.h"
 
 namespace Moses
 {
@@ -42,6 +43,13 @@ class LexicalReorderingTable {
   };
   virtual void InitializeForInputPhrase(const Phrase&){
   };
+  //! source phrases of the translation options of a sentence, which are about to be looked up
+  virtual void Prefetch(const std::vector<const Phrase*>&){
+  };
+  //! true if the scores come with the target phrases of the phrase table instead
+  virtual bool IsMergedIntoPhraseTable() const {
+    return false;
+  }
   /*
   int GetNumScoreComponents() const {
     return m_NumScores;
@@ -87,6 +95,24 @@ class LexicalReorderingTableMemory : public LexicalReorderingTable {
   TableType m_Table; 
 };
 
+class LexicalReorderingTableMerged : public LexicalReorderingTable {
+  //scores merged into a binary phrase table by processPhraseTable -reordering, which come
+  //with the target phrases of the translation options, so nothing is looked up
+ public:
+  LexicalReorderingTableMerged(const std::vector<FactorType>& f_factors,
+							   const std::vector<FactorType>& e_factors,
+							   const std::vector<FactorType>& c_factors)
+	: LexicalReorderingTable(f_factors, e_factors, c_factors) {
+  }
+ public:
+  virtual Score GetScore(const Phrase&, const Phrase&, const Phrase&){
+	return Score();
+  }
+  virtual bool IsMergedIntoPhraseTable() const {
+	return true;
+  }
+};
+
 class LexicalReorderingTableTree : public LexicalReorderingTable {
   //implements LexicalReorderingTable using the crafty PDT code...
  public:
@@ -106,7 +132,7 @@ class LexicalReorderingTableTree : public LexicalReorderingTable {
     m_UseCache = false;
   };
   void ClearCache(){
-	m_Cache.clear();
+	m_Cache.Clear();
   };
 
   virtual std::vector<float> GetScore(const Phrase& f, const Phrase& e, const Phrase& c);
@@ -119,17 +145,16 @@ class LexicalReorderingTableTree : public LexicalReorderingTable {
  public:
   static bool Create(std::istream& inFile, const std::string& outFileName);
  private:
-  std::string MakeCacheKey(const Phrase& f, const Phrase& e) const;
-  IPhrase     MakeTableKey(const Phrase& f, const Phrase& e) const;
-  
-  void Cache(const ConfusionNet& input);
-  void Cache(const Sentence& input);
+  IPhrase     MakeTableKey(const Phrase& f, const Phrase& e);
+  //table vocabulary id of the factors of word, looked up once per word
+  LabelId     GetLabelId(const Word& word, const FactorList& factors, unsigned int voc, std::map<Word, LabelId>& ids);
 
   void  auxCacheForSrcPhrase(const Phrase& f);
   Score auxFindScoreForContext(const Candidates& cands, const Phrase& contex);
  private:
   //typedef LexicalReorderingCand          CandType;
-  typedef std::map< std::string, Candidates > CacheType;
+  //phrase pairs looked up for the current input, cleared for each sentence
+  typedef LexicalReorderingCache CacheType;
   typedef PrefixTreeMap        TableType;
   
   static const int SourceVocId = 0;
@@ -137,6 +162,7 @@ class LexicalReorderingTableTree : public LexicalReorderingTable {
 
   bool      m_UseCache;
   CacheType m_Cache;
+  std::map<Word, LabelId> m_SourceIds, m_TargetIds;
   TableType m_Table;
 };
 
@@ -0,0 +1,486 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include "LexicalReorderingTableBinary.h"
+#include "File.h"
+#include "StaticData.h"
+#include "UserMessage.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+const char LexicalReorderingTableBinary::MAGIC[8] = { 'M', 'o', 's', 'e', 's', 'L', 'R', 'q' };
+
+namespace
+{
+UINT64 Align(UINT64 offset)
+{
+	return (offset + 7) & ~(UINT64) 7;
+}
+
+//! compare phrase ids with the ids from begin to end, like vector<UINT32>::operator<
+int CompareIds(const vector<UINT32> &ids, const UINT32 *begin, const UINT32 *end)
+{
+	const size_t size = end - begin;
+	for (size_t i = 0 ; i < ids.size() && i < size ; ++i)
+	{
+		if (ids[i] != begin[i])
+			return (ids[i] < begin[i]) ? -1 : 1;
+	}
+	if (ids.size() == size)
+		return 0;
+	return (ids.size() < size) ? -1 : 1;
+}
+
+/** code book for the values of a score column, with at most numCodes values, sorted.
+ * The distinct values if there are few enough. Otherwise the means of numCodes bins with about
+ * as many values each, refined by some rounds of Lloyd's algorithm, which moves each code to the
+ * mean of the values closest to it
+ */
+vector<float> MakeCodeBook(vector<float> values, size_t numCodes)
+{
+	std::sort(values.begin(), values.end());
+	vector<float> codeBook(values);
+	codeBook.erase(std::unique(codeBook.begin(), codeBook.end()), codeBook.end());
+	if (codeBook.size() <= numCodes)
+		return codeBook;
+
+	vector<double> sums(1, 0);
+	for (size_t i = 0 ; i < values.size() ; ++i)
+		sums.push_back(sums.back() + values[i]);
+	vector<size_t> begin(numCodes + 1);
+	for (size_t code = 0 ; code <= numCodes ; ++code)
+		begin[code] = code * values.size() / numCodes;
+
+	codeBook.resize(numCodes);
+	for (size_t round = 0 ; round < 20 ; ++round)
+	{
+		for (size_t code = 0 ; code < numCodes ; ++code)
+		{
+			if (begin[code] < begin[code + 1])
+				codeBook[code] = (float) ((sums[begin[code + 1]] - sums[begin[code]]) / (begin[code + 1] - begin[code]));
+		}
+		// empty bins keep their code, which stays between its neighbours
+		for (size_t code = 1 ; code < numCodes ; ++code)
+		{
+			const float boundary = (codeBook[code - 1] + codeBook[code]) / 2;
+			begin[code] = std::lower_bound(values.begin(), values.end(), boundary) - values.begin();
+		}
+	}
+	return codeBook;
+}
+
+//! index of the value in a sorted code book closest to value
+size_t Quantize(const vector<float> &codeBook, float value)
+{
+	const size_t upper = std::lower_bound(codeBook.begin(), codeBook.end(), value) - codeBook.begin();
+	if (upper == codeBook.size())
+		return upper - 1;
+	if (upper > 0 && value - codeBook[upper - 1] < codeBook[upper] - value)
+		return upper - 1;
+	return upper;
+}
+}
+
+LexicalReorderingTableBinary::Sections::Sections(const Header &header)
+{
+	m_stringBegin = Align(sizeof(Header));
+	m_strings = Align(m_stringBegin + (header.m_numWords + 1) * sizeof(UINT64));
+	m_sourceBegin = Align(m_strings + header.m_stringSize);
+	m_sourceWords = Align(m_sourceBegin + (header.m_numSources + 1) * sizeof(UINT64));
+	m_entryBegin = Align(m_sourceWords + header.m_sourceSize * sizeof(UINT32));
+	m_targetBegin = Align(m_entryBegin + (header.m_numSources + 1) * sizeof(UINT64));
+	m_targetWords = Align(m_targetBegin + (header.m_numEntries + 1) * sizeof(UINT64));
+	m_codeBook = Align(m_targetWords + header.m_targetSize * sizeof(UINT32));
+	m_codes = Align(m_codeBook + ((UINT64) header.m_numScores << header.m_bits) * sizeof(float));
+	m_end = m_codes + header.m_numEntries * header.m_numScores * (header.m_bits / 8);
+}
+
+bool LexicalReorderingTableBinary::Load(const string &filePath)
+{
+	const string binFilePath = filePath + ".binlexq";
+	if (!m_file.Open(binFilePath))
+	{
+		UserMessage::Add(string("Couldn't read ") + binFilePath);
+		return false;
+	}
+
+	m_header = reinterpret_cast<const Header*>(m_file.GetData());
+	if (m_file.GetSize() < sizeof(Header) || memcmp(m_header->m_magic, MAGIC, sizeof(MAGIC)) != 0
+			|| (m_header->m_bits != 8 && m_header->m_bits != 16)
+			|| m_file.GetSize() != Sections(*m_header).m_end)
+	{
+		UserMessage::Add(binFilePath + " is not a binary reordering table, or is truncated");
+		return false;
+	}
+	const size_t numPhrases = (m_FactorsF.empty() ? 0 : 1) + (m_FactorsE.empty() ? 0 : 1);
+	if (m_header->m_numPhrases != numPhrases)
+	{
+		stringstream strme;
+		strme << binFilePath << ": conditioned on " << m_header->m_numPhrases
+					<< " phrases, but the model is conditioned on " << numPhrases;
+		UserMessage::Add(strme.str());
+		return false;
+	}
+
+	const Sections sections(*m_header);
+	const char *data = m_file.GetData();
+	m_stringBegin = reinterpret_cast<const UINT64*>(data + sections.m_stringBegin);
+	m_strings = data + sections.m_strings;
+	m_sourceBegin = reinterpret_cast<const UINT64*>(data + sections.m_sourceBegin);
+	m_sourceWords = reinterpret_cast<const UINT32*>(data + sections.m_sourceWords);
+	m_entryBegin = reinterpret_cast<const UINT64*>(data + sections.m_entryBegin);
+	m_targetBegin = reinterpret_cast<const UINT64*>(data + sections.m_targetBegin);
+	m_targetWords = reinterpret_cast<const UINT32*>(data + sections.m_targetWords);
+	m_codeBook = reinterpret_cast<const float*>(data + sections.m_codeBook);
+	m_codes = data + sections.m_codes;
+
+	VERBOSE(1, "Mapped " << m_header->m_numEntries << " reordering entries from " << binFilePath << endl);
+	return true;
+}
+
+bool LexicalReorderingTableBinary::GetIds(const Phrase &phrase, const FactorList &factors, map<Word, UINT32> &ids)
+{
+	m_ids.resize(phrase.GetSize());
+	for (size_t pos = 0 ; pos < phrase.GetSize() ; ++pos)
+	{
+		const Word &word = phrase.GetWord(pos);
+		map<Word, UINT32>::const_iterator iter = ids.find(word);
+		if (iter == ids.end())
+		{ // first time this word is seen, look for it in the table
+			const string str = word.GetString(factors, false);
+			UINT32 id = NO_ID;
+			size_t begin = 0, end = (size_t) m_header->m_numWords;
+			while (begin < end)
+			{
+				const size_t middle = begin + (end - begin) / 2;
+				const int comp = str.compare(0, string::npos, m_strings + m_stringBegin[middle]
+																		, (size_t) (m_stringBegin[middle + 1] - m_stringBegin[middle]));
+				if (comp == 0)
+				{
+					id = (UINT32) middle;
+					break;
+				}
+				if (comp < 0)
+					end = middle;
+				else
+					begin = middle + 1;
+			}
+			iter = ids.insert(make_pair(word, id)).first;
+		}
+		if (iter->second == NO_ID)
+			return false;
+		m_ids[pos] = iter->second;
+	}
+	return true;
+}
+
+size_t LexicalReorderingTableBinary::FindSource()
+{
+	// the translation options of a span are looked up one after the other
+	if (!m_lastSource.empty() && m_ids == m_lastSource)
+		return m_lastSourceIndex;
+
+	size_t source = NOT_FOUND;
+	size_t begin = 0, end = (size_t) m_header->m_numSources;
+	while (begin < end)
+	{
+		const size_t middle = begin + (end - begin) / 2;
+		const int comp = CompareIds(m_ids, m_sourceWords + m_sourceBegin[middle], m_sourceWords + m_sourceBegin[middle + 1]);
+		if (comp == 0)
+		{
+			source = middle;
+			break;
+		}
+		if (comp < 0)
+			end = middle;
+		else
+			begin = middle + 1;
+	}
+	m_lastSource = m_ids;
+	m_lastSourceIndex = source;
+	return source;
+}
+
+size_t LexicalReorderingTableBinary::FindTarget(size_t source) const
+{
+	size_t begin = (size_t) m_entryBegin[source], end = (size_t) m_entryBegin[source + 1];
+	while (begin < end)
+	{
+		const size_t middle = begin + (end - begin) / 2;
+		const int comp = CompareIds(m_ids, m_targetWords + m_targetBegin[middle], m_targetWords + m_targetBegin[middle + 1]);
+		if (comp == 0)
+			return middle;
+		if (comp < 0)
+			end = middle;
+		else
+			begin = middle + 1;
+	}
+	return NOT_FOUND;
+}
+
+Score LexicalReorderingTableBinary::GetScore(size_t entry) const
+{
+	const size_t numScores = m_header->m_numScores;
+	Score score(numScores);
+	for (size_t i = 0 ; i < numScores ; ++i)
+	{
+		const size_t index = entry * numScores + i;
+		const size_t code = (m_header->m_bits == 8)
+												? reinterpret_cast<const UINT8*>(m_codes)[index]
+												: reinterpret_cast<const UINT16*>(m_codes)[index];
+		score[i] = m_codeBook[(i << m_header->m_bits) + code];
+	}
+	return score;
+}
+
+void LexicalReorderingTableBinary::InitializeForInput(const InputType &)
+{
+	m_sourceIds.clear();
+	m_targetIds.clear();
+	m_lastSource.clear();
+	m_lastSourceIndex = NOT_FOUND;
+}
+
+Score LexicalReorderingTableBinary::GetScore(const Phrase &f, const Phrase &e, const Phrase &)
+{
+	if ((!m_FactorsF.empty() && f.GetSize() == 0) || (!m_FactorsE.empty() && e.GetSize() == 0))
+		return Score();
+
+	// conditioned on f, e, or both. The first of them is the source phrase of the table
+	const bool hasF = !m_FactorsF.empty();
+	if (!(hasF ? GetIds(f, m_FactorsF, m_sourceIds) : GetIds(e, m_FactorsE, m_targetIds)))
+		return Score();
+	const size_t source = FindSource();
+	if (source == NOT_FOUND)
+		return Score();
+
+	size_t entry;
+	if (hasF && !m_FactorsE.empty())
+	{
+		if (!GetIds(e, m_FactorsE, m_targetIds))
+			return Score();
+		entry = FindTarget(source);
+		if (entry == NOT_FOUND)
+			return Score();
+	}
+	else
+		entry = (size_t) m_entryBegin[source];
+	return GetScore(entry);
+}
+
+void LexicalReorderingTableBinary::Prefetch(const vector<const Phrase*> &sourcePhrases)
+{
+	if (m_FactorsF.empty())
+		return;
+
+	const size_t codeSize = m_header->m_numScores * (m_header->m_bits / 8);
+	for (size_t i = 0 ; i < sourcePhrases.size() ; ++i)
+	{
+		if (sourcePhrases[i]->GetSize() == 0 || !GetIds(*sourcePhrases[i], m_FactorsF, m_sourceIds))
+			continue;
+		// the same source phrase usually comes several times in a row
+		const bool repeated = !m_lastSource.empty() && m_ids == m_lastSource;
+		const size_t source = FindSource();
+		if (source == NOT_FOUND || repeated)
+			continue;
+
+		const size_t begin = (size_t) m_entryBegin[source], end = (size_t) m_entryBegin[source + 1];
+		const char *targetWords = reinterpret_cast<const char*>(m_targetWords + m_targetBegin[begin]);
+		m_file.Prefetch(targetWords - m_file.GetData(), (size_t) (m_targetBegin[end] - m_targetBegin[begin]) * sizeof(UINT32));
+		m_file.Prefetch(m_codes + begin * codeSize - m_file.GetData(), (end - begin) * codeSize);
+	}
+}
+
+bool LexicalReorderingTableBinary::Create(istream &inFile, const string &outFilePath, size_t bits)
+{
+	if (bits != 8 && bits != 16)
+	{
+		cerr << "scores can be quantized to 8 or 16 bits, not " << bits << endl;
+		return false;
+	}
+
+	// scores for each target phrase for each source phrase, as lists of words
+	typedef map<vector<string>, vector<float> > Targets;
+	typedef map<vector<string>, Targets> Entries;
+	Entries entries;
+	set<string> strings;
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+	header.m_bits = bits;
+
+	string line;
+	size_t lineNum = 0;
+	while (getline(inFile, line))
+	{
+		++lineNum;
+		vector<string> tokens = TokenizeMultiCharSeparator(line, "|||");
+		if (header.m_numPhrases == 0)
+		{ // the first line determines the number of phrases and scores
+			if (tokens.size() != 2 && tokens.size() != 3)
+			{
+				cerr << "line " << lineNum << ": expected f ||| scores or f ||| e ||| scores"
+							<< ", tables conditioned on context need processLexicalTable without -quantize" << endl;
+				return false;
+			}
+			header.m_numPhrases = tokens.size() - 1;
+			header.m_numScores = Tokenize(tokens.back()).size();
+		}
+		vector<string> source = Tokenize(tokens[0])
+									, target = (tokens.size() == 3) ? Tokenize(tokens[1]) : vector<string>()
+									, scoreStr = Tokenize(tokens.back());
+		if (tokens.size() != header.m_numPhrases + 1 || scoreStr.size() != header.m_numScores)
+		{
+			cerr << "line " << lineNum << ": expected " << header.m_numPhrases << " phrases and "
+						<< header.m_numScores << " scores, like the first line" << endl;
+			return false;
+		}
+		if (source.empty())
+		{
+			cerr << "line " << lineNum << ": empty phrase, skipped" << endl;
+			continue;
+		}
+
+		// a repeated entry replaces the earlier one, as when the text table is loaded
+		vector<float> &scores = entries[source][target];
+		scores.resize(header.m_numScores);
+		for (size_t i = 0 ; i < scores.size() ; ++i)
+			scores[i] = FloorScore(TransformScore(Scan<float>(scoreStr[i])));
+		strings.insert(source.begin(), source.end());
+		strings.insert(target.begin(), target.end());
+	}
+
+	// ids are positions in the sorted words, so phrases sorted on their words are sorted on the ids too
+	map<string, UINT32> ids;
+	vector<UINT64> stringBegin(1, 0);
+	for (set<string>::const_iterator iter = strings.begin() ; iter != strings.end() ; ++iter)
+	{
+		ids.insert(make_pair(*iter, (UINT32) ids.size()));
+		stringBegin.push_back(stringBegin.back() + iter->size());
+	}
+
+	vector<UINT32> sourceWords, targetWords;
+	vector<UINT64> sourceBegin(1, 0), entryBegin(1, 0), targetBegin(1, 0);
+	vector< vector<float> > columns(header.m_numScores);
+	for (Entries::const_iterator source = entries.begin() ; source != entries.end() ; ++source)
+	{
+		for (size_t i = 0 ; i < source->first.size() ; ++i)
+			sourceWords.push_back(ids[source->first[i]]);
+		sourceBegin.push_back(sourceWords.size());
+		for (Targets::const_iterator target = source->second.begin() ; target != source->second.end() ; ++target)
+		{
+			for (size_t i = 0 ; i < target->first.size() ; ++i)
+				targetWords.push_back(ids[target->first[i]]);
+			targetBegin.push_back(targetWords.size());
+			for (size_t i = 0 ; i < header.m_numScores ; ++i)
+				columns[i].push_back(target->second[i]);
+		}
+		entryBegin.push_back(targetBegin.size() - 1);
+	}
+
+	// quantize each column with its own code book
+	const size_t numCodes = (size_t) 1 << bits;
+	const size_t numEntries = targetBegin.size() - 1;
+	vector<float> codeBook(header.m_numScores * numCodes, 0);
+	vector<UINT16> codes(numEntries * header.m_numScores);
+	size_t numExact = 0;
+	float maxError = 0;
+	double sumError = 0;
+	for (size_t i = 0 ; i < header.m_numScores ; ++i)
+	{
+		const vector<float> columnCodeBook = MakeCodeBook(columns[i], numCodes);
+		numExact += (columnCodeBook.size() < numCodes || numEntries <= numCodes) ? 1 : 0;
+		std::copy(columnCodeBook.begin(), columnCodeBook.end(), codeBook.begin() + i * numCodes);
+		for (size_t entry = 0 ; entry < numEntries ; ++entry)
+		{
+			const size_t code = Quantize(columnCodeBook, columns[i][entry]);
+			codes[entry * header.m_numScores + i] = (UINT16) code;
+			const float error = std::abs(columnCodeBook[code] - columns[i][entry]);
+			maxError = std::max(maxError, error);
+			sumError += error;
+		}
+	}
+
+	header.m_numWords = strings.size();
+	header.m_stringSize = stringBegin.back();
+	header.m_numSources = entries.size();
+	header.m_sourceSize = sourceWords.size();
+	header.m_numEntries = numEntries;
+	header.m_targetSize = targetWords.size();
+	const Sections sections(header);
+
+	const string binFilePath = outFilePath + ".binlexq";
+	FILE *f = fOpen(binFilePath.c_str(), "wb");
+	fWrite(f, header);
+	// each section starts at its aligned offset
+	const char padding[8] = { 0 };
+	fwrite(padding, 1, sections.m_stringBegin - sizeof(header), f);
+	fwrite(&stringBegin[0], sizeof(UINT64), stringBegin.size(), f);
+	fwrite(padding, 1, sections.m_strings - sections.m_stringBegin - stringBegin.size() * sizeof(UINT64), f);
+	for (set<string>::const_iterator iter = strings.begin() ; iter != strings.end() ; ++iter)
+		fwrite(iter->data(), 1, iter->size(), f);
+	fwrite(padding, 1, sections.m_sourceBegin - sections.m_strings - header.m_stringSize, f);
+	fwrite(&sourceBegin[0], sizeof(UINT64), sourceBegin.size(), f);
+	fwrite(padding, 1, sections.m_sourceWords - sections.m_sourceBegin - sourceBegin.size() * sizeof(UINT64), f);
+	if (!sourceWords.empty())
+		fwrite(&sourceWords[0], sizeof(UINT32), sourceWords.size(), f);
+	fwrite(padding, 1, sections.m_entryBegin - sections.m_sourceWords - sourceWords.size() * sizeof(UINT32), f);
+	fwrite(&entryBegin[0], sizeof(UINT64), entryBegin.size(), f);
+	fwrite(padding, 1, sections.m_targetBegin - sections.m_entryBegin - entryBegin.size() * sizeof(UINT64), f);
+	fwrite(&targetBegin[0], sizeof(UINT64), targetBegin.size(), f);
+	fwrite(padding, 1, sections.m_targetWords - sections.m_targetBegin - targetBegin.size() * sizeof(UINT64), f);
+	if (!targetWords.empty())
+		fwrite(&targetWords[0], sizeof(UINT32), targetWords.size(), f);
+	fwrite(padding, 1, sections.m_codeBook - sections.m_targetWords - targetWords.size() * sizeof(UINT32), f);
+	if (!codeBook.empty())
+		fwrite(&codeBook[0], sizeof(float), codeBook.size(), f);
+	fwrite(padding, 1, sections.m_codes - sections.m_codeBook - codeBook.size() * sizeof(float), f);
+	for (size_t i = 0 ; i < codes.size() ; ++i)
+	{
+		if (bits == 8)
+			fWrite(f, (UINT8) codes[i]);
+		else
+			fWrite(f, codes[i]);
+	}
+	const bool ok = !ferror(f) && (UINT64) FTELLO(f) == sections.m_end;
+	fClose(f);
+	if (!ok)
+	{
+		cerr << "error writing " << binFilePath << endl;
+		return false;
+	}
+
+	cerr << "wrote " << header.m_numEntries << " entries for " << header.m_numSources << " phrases to " << binFilePath
+				<< ", " << numExact << " of " << header.m_numScores << " score columns exact, mean error "
+				<< ((codes.empty()) ? 0 : sumError / codes.size()) << ", largest " << maxError << endl;
+	return true;
+}
+
+}
@@ -0,0 +1,126 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "LexicalReorderingTable.h"
+#include "MemoryMappedFile.h"
+#include "Word.h"
+
+namespace Moses
+{
+
+/** lexical reordering table in a binary file, mapped into memory instead of being read with seeks.
+ * The words of the table are stored once, sorted, so that their position in the word list
+ * serves as their id. Source phrases are stored as sequences of word ids, sorted, each followed
+ * by its target phrases, also sorted, so phrases are looked up by bisecting integer keys.
+ * Each score is quantized to 8 or 16 bits, as the index into a code book of its column, which
+ * is exact when the column has no more distinct values than that.
+ * Prefetch() looks up the source phrases of a sentence up front and has the pages of their
+ * entries read ahead, so the lookups of the translation options don't wait on the disk one by one.
+ * The binary file is created from a text table by Create(), and is used instead of the text table
+ * if it exists next to it, with the extension .binlexq. Tables conditioned on context aren't supported.
+ * Lookups keep the ids of the words of the sentence and the last source phrase, so GetScore() and
+ * Prefetch() must only be called from one thread, as TranslationOptionCollection::CacheLexReordering() does
+ */
+class LexicalReorderingTableBinary : public LexicalReorderingTable
+{
+protected:
+	static const char MAGIC[8];
+	static const UINT32 NO_ID = (UINT32) -1; //! of a word not in the table
+
+	//! start of the binary file. The sections that follow are aligned to 8 bytes
+	struct Header
+	{
+		char m_magic[8];
+		UINT32 m_numScores, m_numPhrases; //! 1 if conditioned on f only, 2 on f and e
+		UINT32 m_bits, m_unused; //! of each quantized score
+		UINT64 m_numWords, m_stringSize, m_numSources, m_sourceSize, m_numEntries, m_targetSize;
+	};
+	//! offsets of the sections of the binary file
+	struct Sections
+	{
+		UINT64 m_stringBegin; //! UINT64 offset of each word in the string data, and the end
+		UINT64 m_strings; //! string data, not 0 terminated
+		UINT64 m_sourceBegin; //! UINT64 index of the first word of each source phrase, and the end
+		UINT64 m_sourceWords; //! UINT32 word ids of the source phrases
+		UINT64 m_entryBegin; //! UINT64 index of the first entry of each source phrase, and the end
+		UINT64 m_targetBegin; //! UINT64 index of the first word of the target phrase of each entry, and the end
+		UINT64 m_targetWords; //! UINT32 word ids of the target phrases
+		UINT64 m_codeBook; //! float values of the codes of each score column
+		UINT64 m_codes; //! UINT8 or UINT16 code of each score of each entry
+		UINT64 m_end;
+
+		explicit Sections(const Header &header);
+	};
+
+	MemoryMappedFile m_file;
+	const Header *m_header;
+	const UINT64 *m_stringBegin;
+	const char *m_strings;
+	const UINT64 *m_sourceBegin;
+	const UINT32 *m_sourceWords;
+	const UINT64 *m_entryBegin;
+	const UINT64 *m_targetBegin;
+	const UINT32 *m_targetWords;
+	const float *m_codeBook;
+	const char *m_codes;
+
+	std::map<Word, UINT32> m_sourceIds, m_targetIds; //! ids of the words looked up during the sentence, or NO_ID
+	std::vector<UINT32> m_ids; //! of the phrase being looked up
+	std::vector<UINT32> m_lastSource; //! ids of the last source phrase looked up
+	size_t m_lastSourceIndex; //! and its index, or NOT_FOUND
+
+	//! ids of the words of phrase in m_ids. false if a word isn't in the table
+	bool GetIds(const Phrase &phrase, const FactorList &factors, std::map<Word, UINT32> &ids);
+	//! index of the source phrase with the ids in m_ids, or NOT_FOUND
+	size_t FindSource();
+	//! index of the entry of source phrase source with target phrase ids in m_ids, or NOT_FOUND
+	size_t FindTarget(size_t source) const;
+	Score GetScore(size_t entry) const;
+
+public:
+	LexicalReorderingTableBinary(const FactorList &f_factors, const FactorList &e_factors, const FactorList &c_factors)
+	:LexicalReorderingTable(f_factors, e_factors, c_factors)
+	,m_header(NULL)
+	,m_lastSourceIndex(NOT_FOUND)
+	{}
+
+	//! map binary file filePath + ".binlexq". filePath is the text table the binary file was created from
+	bool Load(const std::string &filePath);
+
+	//! forget the word ids of the previous sentence
+	void InitializeForInput(const InputType &input);
+	Score GetScore(const Phrase &f, const Phrase &e, const Phrase &c);
+	void Prefetch(const std::vector<const Phrase*> &sourcePhrases);
+
+	/** write text reordering table read from inFile to binary file outFilePath + ".binlexq",
+	 * with scores quantized to bits bits, 8 or 16
+	 */
+	static bool Create(std::istream &inFile, const std::string &outFilePath, size_t bits);
+};
+
+}
@@ -0,0 +1,207 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+#include "LoadFilter.h"
+#include "Util.h"
+#include "InputFileStream.h"
+#include "UserMessage.h"
+#include "StaticData.h"
+#include "XmlOption.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+bool LoadFilter::SplitWord(const string &word, size_t numFactors
+													, const string &factorDelimiter, vector<string> &factorStr)
+{
+	factorStr = (factorDelimiter.size() > 1)
+							? TokenizeMultiCharSeparator(word, factorDelimiter)
+							: Tokenize(word, factorDelimiter);
+	return factorStr.size() == numFactors;
+}
+
+bool LoadFilter::IsInVocab(const Vocab *vocab
+													, const vector<string> &factorStr, const vector<FactorType> &factorTypes)
+{
+	for (size_t i = 0 ; i < factorTypes.size() ; ++i)
+	{
+		if (i >= factorStr.size() || vocab[factorTypes[i]].find(factorStr[i]) == vocab[factorTypes[i]].end())
+			return false;
+	}
+	return true;
+}
+
+void LoadFilter::AddToVocab(Vocab *vocab
+													, const vector<string> &factorStr, const vector<FactorType> &factorTypes)
+{
+	for (size_t i = 0 ; i < factorTypes.size() && i < factorStr.size() ; ++i)
+		vocab[factorTypes[i]].insert(factorStr[i]);
+}
+
+bool LoadFilter::ReadInput(const string &filePath
+													, const vector<FactorType> &inputFactorOrder
+													, const string &factorDelimiter
+													, XmlInputType xmlInputType)
+{
+	InputFileStream inFile(filePath);
+	if (!inFile.good())
+	{
+		UserMessage::Add(string("Couldn't read ") + filePath);
+		return false;
+	}
+
+	string line;
+	vector<string> factorStr;
+	while (getline(inFile, line))
+	{
+		// same words as Sentence::Read()
+		line = Trim(line);
+		ProcessAndStripSGML(line);
+		if (xmlInputType != XmlPassThrough)
+			StripXMLTags(line);
+
+		vector<string> words = Tokenize(line);
+		for (size_t i = 0 ; i < words.size() ; ++i)
+		{
+			// anything else can't match a phrase table entry anyway
+			if (SplitWord(words[i], inputFactorOrder.size(), factorDelimiter, factorStr))
+				AddToVocab(m_sourceVocab, factorStr, inputFactorOrder);
+		}
+	}
+	inFile.Close();
+
+	// unknown words are copied to the output, with factors not in the input set to UNK
+	for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; ++factorType)
+	{
+		m_targetVocab[factorType].insert(m_sourceVocab[factorType].begin(), m_sourceVocab[factorType].end());
+		m_targetVocab[factorType].insert(UNKNOWN_FACTOR);
+	}
+
+	size_t numWords = 0;
+	for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; ++factorType)
+		numWords += m_sourceVocab[factorType].size();
+	VERBOSE(1, "Filtering models to " << numWords << " source factors from " << filePath << endl);
+	return true;
+}
+
+bool LoadFilter::ScanPhraseTable(const string &filePath
+													, const vector<FactorType> &input
+													, const vector<FactorType> &output
+													, const string &factorDelimiter)
+{
+	InputFileStream inFile(filePath);
+	if (!inFile.good())
+	{
+		UserMessage::Add(string("Couldn't read ") + filePath);
+		return false;
+	}
+
+	string line;
+	vector<string> factorStr;
+	while (getline(inFile, line))
+	{
+		vector<string> tokens = TokenizeMultiCharSeparator(line, "|||");
+		if (tokens.size() < 2)
+			continue;
+
+		// compare the source side word by word without creating factors, most entries don't match
+		vector<string> words = Tokenize(tokens[0]);
+		bool keep = true;
+		for (size_t i = 0 ; i < words.size() && keep ; ++i)
+		{
+			keep = SplitWord(words[i], input.size(), factorDelimiter, factorStr)
+							&& IsInVocab(m_sourceVocab, factorStr, input);
+		}
+		if (!keep)
+			continue;
+
+		words = Tokenize(tokens[1]);
+		for (size_t i = 0 ; i < words.size() ; ++i)
+		{
+			if (SplitWord(words[i], output.size(), factorDelimiter, factorStr))
+				AddToVocab(m_targetVocab, factorStr, output);
+		}
+	}
+	inFile.Close();
+	return true;
+}
+
+bool LoadFilter::ScanGenerationTable(const string &filePath
+													, const vector<FactorType> &input
+													, const vector<FactorType> &output)
+{
+	InputFileStream inFile(filePath);
+	if (!inFile.good())
+	{
+		UserMessage::Add(string("Couldn't read ") + filePath);
+		return false;
+	}
+
+	string line;
+	while (getline(inFile, line))
+	{
+		vector<string> token = Tokenize(line);
+		if (token.size() < 2)
+			continue;
+		if (KeepGenerationEntry(Tokenize(token[0], "|"), input))
+			AddToVocab(m_targetVocab, Tokenize(token[1], "|"), output);
+	}
+	inFile.Close();
+	return true;
+}
+
+bool LoadFilter::KeepSourcePhrase(const vector< vector<string> > &phraseVector
+													, const vector<FactorType> &input) const
+{
+	for (size_t pos = 0 ; pos < phraseVector.size() ; ++pos)
+	{
+		if (!IsInVocab(m_sourceVocab, phraseVector[pos], input))
+			return false;
+	}
+	return true;
+}
+
+bool LoadFilter::KeepGenerationEntry(const vector<string> &factorStr
+													, const vector<FactorType> &input) const
+{
+	return !m_filterTarget || IsInVocab(m_targetVocab, factorStr, input);
+}
+
+bool LoadFilter::KeepNGram(const vector<string> &words, FactorType factorType) const
+{
+	if (!m_filterTarget)
+		return true;
+
+	const Vocab &vocab = m_targetVocab[factorType];
+	for (size_t i = 0 ; i < words.size() ; ++i)
+	{
+		const string &word = words[i];
+		if (word != BOS_ && word != EOS_ && word != "<unk>" && vocab.find(word) == vocab.end())
+			return false;
+	}
+	return true;
+}
+
+}
+
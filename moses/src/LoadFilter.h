@@ -0,0 +1,95 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+/** vocabulary of the text to be translated, and of everything the models can make of it.
+ * Used while loading to drop the parts of the models that cannot be reached when translating
+ * that text: phrase pairs with an unknown source word, generation entries for target words
+ * which cannot be produced and n-grams containing such words.
+ * The target vocabulary is collected by scanning the phrase and generation tables before the
+ * language models are loaded
+ */
+class LoadFilter
+{
+protected:
+	typedef std::set<std::string> Vocab;
+
+	Vocab m_sourceVocab[MAX_NUM_FACTORS], m_targetVocab[MAX_NUM_FACTORS];
+	bool m_filterTarget; //! false if the target vocabulary isn't known, eg. with binary phrase tables
+
+	//! split word into its factors. false if it doesn't have the expected number of factors
+	static bool SplitWord(const std::string &word, size_t numFactors
+											, const std::string &factorDelimiter, std::vector<std::string> &factorStr);
+	static bool IsInVocab(const Vocab *vocab
+											, const std::vector<std::string> &factorStr, const std::vector<FactorType> &factorTypes);
+	static void AddToVocab(Vocab *vocab
+											, const std::vector<std::string> &factorStr, const std::vector<FactorType> &factorTypes);
+
+public:
+	LoadFilter()
+	:m_filterTarget(true)
+	{}
+
+	//! source words of the input text, or of a vocabulary list in the same format. Markup is removed as when translating
+	bool ReadInput(const std::string &filePath
+								, const std::vector<FactorType> &inputFactorOrder
+								, const std::string &factorDelimiter
+								, XmlInputType xmlInputType);
+	//! add target words of phrase pairs whose source side can be matched
+	bool ScanPhraseTable(const std::string &filePath
+											, const std::vector<FactorType> &input
+											, const std::vector<FactorType> &output
+											, const std::string &factorDelimiter);
+	//! add output of generation entries whose input can be produced
+	bool ScanGenerationTable(const std::string &filePath
+											, const std::vector<FactorType> &input
+											, const std::vector<FactorType> &output);
+	//! keep all n-grams and generation entries
+	void DisableTargetFilter()
+	{
+		m_filterTarget = false;
+	}
+	bool IsTargetFilterEnabled() const
+	{
+		return m_filterTarget;
+	}
+
+	//! phrase as returned by Phrase::Parse()
+	bool KeepSourcePhrase(const std::vector< std::vector<std::string> > &phraseVector
+											, const std::vector<FactorType> &input) const;
+	//! generation entry with the given input factors (in the order of input)
+	bool KeepGenerationEntry(const std::vector<std::string> &factorStr
+											, const std::vector<FactorType> &input) const;
+	//! n-gram, as the words of the factor used by the language model
+	bool KeepNGram(const std::vector<std::string> &words, FactorType factorType) const;
+};
+
+}
+
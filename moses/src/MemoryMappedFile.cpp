@@ -0,0 +1,128 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#ifdef WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include "MemoryMappedFile.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+// mapped in place of an empty file, which can't be mapped
+const char s_empty[1] = { 0 };
+}
+
+bool MemoryMappedFile::Open(const string &filePath)
+{
+	Close();
+
+#ifdef WIN32
+	ifstream file(filePath.c_str(), ios::in | ios::binary);
+	if (!file.good())
+		return false;
+	file.seekg(0, ios::end);
+	m_size = (size_t) file.tellg();
+	file.seekg(0, ios::beg);
+	if (m_size == 0)
+	{
+		m_data = s_empty;
+		return true;
+	}
+	char *data = new char[m_size];
+	if (!file.read(data, m_size))
+	{
+		delete [] data;
+		m_size = 0;
+		return false;
+	}
+	m_data = data;
+	return true;
+#else
+	int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat status;
+	if (fstat(fd, &status) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	m_size = status.st_size;
+	if (m_size == 0)
+	{
+		close(fd);
+		m_data = s_empty;
+		return true;
+	}
+	void *data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping stays valid after the file is closed
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		m_size = 0;
+		return false;
+	}
+	m_data = static_cast<const char*>(data);
+	return true;
+#endif
+}
+
+void MemoryMappedFile::Close()
+{
+	if (m_data != NULL && m_data != s_empty)
+	{
+#ifdef WIN32
+		delete [] m_data;
+#else
+		munmap(const_cast<char*>(m_data), m_size);
+#endif
+	}
+	m_data = NULL;
+	m_size = 0;
+}
+
+void MemoryMappedFile::Prefetch(size_t offset, size_t size) const
+{
+#ifndef WIN32
+	if (m_data == NULL || m_data == s_empty || offset >= m_size || size == 0)
+		return;
+	static const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+	// madvise() wants the start of a page
+	const size_t begin = offset - offset % pageSize;
+	const size_t end = std::min(offset + size, m_size);
+	madvise(const_cast<char*>(m_data) + begin, end - begin, MADV_WILLNEED);
+#endif
+}
+
+}
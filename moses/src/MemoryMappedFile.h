@@ -0,0 +1,74 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <string>
+
+namespace Moses
+{
+
+/** read-only view of a whole file, mapped into memory.
+ * Pages are only read when touched, and are shared with other processes mapping the same file.
+ * Where mmap() isn't available the file is read into memory instead
+ */
+class MemoryMappedFile
+{
+protected:
+	const char *m_data;
+	size_t m_size;
+
+	// not copyable
+	MemoryMappedFile(const MemoryMappedFile&);
+	MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+public:
+	MemoryMappedFile()
+	:m_data(NULL)
+	,m_size(0)
+	{}
+	~MemoryMappedFile()
+	{
+		Close();
+	}
+
+	//! map filePath, replacing any file mapped before. false if it can't be opened
+	bool Open(const std::string &filePath);
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_data != NULL;
+	}
+	const char *GetData() const
+	{
+		return m_data;
+	}
+	size_t GetSize() const
+	{
+		return m_size;
+	}
+	//! ask for the pages of size bytes from offset to be read ahead, as they will be needed soon
+	void Prefetch(size_t offset, size_t size) const;
+};
+
+}
+
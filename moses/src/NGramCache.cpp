@@ -0,0 +1,123 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "NGramCache.h"
+
+namespace Moses
+{
+
+const unsigned int NGramCache::NO_LEN;
+
+void NGramCache::Init(size_t numEntries, size_t maxKeySize)
+{
+	size_t size = 0;
+	if (numEntries > 0)
+	{
+		size = 1;
+		while (size < numEntries)
+			size <<= 1;
+	}
+	m_entries.clear();
+	m_entries.resize(size);
+	m_keys.resize(size * maxKeySize);
+	m_maxKeySize = maxKeySize;
+	m_mask = (size > 0) ? size - 1 : 0;
+	for (size_t i = 0 ; i < size ; ++i)
+		m_entries[i].generation = 0;
+	m_generation = 1;
+	m_hits = m_misses = 0;
+}
+
+void NGramCache::Clear()
+{
+	if (++m_generation == 0)
+	{ // wrapped around. Old entries could look valid again
+		for (size_t i = 0 ; i < m_entries.size() ; ++i)
+			m_entries[i].generation = 0;
+		m_generation = 1;
+	}
+	m_hits = m_misses = 0;
+}
+
+size_t NGramCache::Hash(const Factor * const *key, size_t keySize) const
+{
+	size_t hash = keySize;
+	for (size_t i = 0 ; i < keySize ; ++i)
+	{
+		hash ^= reinterpret_cast<size_t>(key[i]) >> 3;
+		hash *= 0x9E3779B1;
+		hash ^= hash >> 15;
+	}
+	return hash;
+}
+
+bool NGramCache::Find(const Factor * const *key, size_t keySize, float &score, State *state, unsigned int *len)
+{
+	assert(keySize <= m_maxKeySize);
+	const bool wantState = (state != NULL || len != NULL);
+	size_t index = Hash(key, keySize) & m_mask;
+	for (size_t probe = 0 ; probe < MAX_PROBES ; ++probe, index = (index + 1) & m_mask)
+	{
+		if (!Matches(index, key, keySize))
+			continue;
+		const Entry &entry = m_entries[index];
+		if (wantState && !entry.hasState)
+			break;
+		score = entry.score;
+		if (state != NULL)
+			*state = entry.state;
+		if (len != NULL && entry.len != NO_LEN)
+			*len = entry.len;
+		++m_hits;
+		return true;
+	}
+	++m_misses;
+	return false;
+}
+
+void NGramCache::Insert(const Factor * const *key, size_t keySize, float score, const State *state, const unsigned int *len)
+{
+	assert(keySize <= m_maxKeySize);
+	const size_t home = Hash(key, keySize) & m_mask;
+	size_t index = home, slot = home;
+	for (size_t probe = 0 ; probe < MAX_PROBES ; ++probe, index = (index + 1) & m_mask)
+	{
+		if (m_entries[index].generation != m_generation || Matches(index, key, keySize))
+		{ // free, or the same n-gram stored without its state
+			slot = index;
+			break;
+		}
+	}
+
+	Entry &entry = m_entries[slot];
+	entry.generation = m_generation;
+	entry.keySize = keySize;
+	entry.score = score;
+	entry.hasState = (state != NULL && len != NULL);
+	entry.state = (state != NULL) ? *state : NULL;
+	entry.len = (len != NULL) ? *len : NO_LEN;
+	std::copy(key, key + keySize, m_keys.begin() + slot * m_maxKeySize);
+}
+
+}
+
@@ -0,0 +1,114 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "TypeDef.h"
+
+namespace Moses
+{
+
+class Factor;
+
+/** fixed size cache of LM probabilities, in front of the LM implementation.
+ * Keys are the factors of the words of an n-gram. Open addressing with a short probe
+ * sequence; when all slots of a sequence are in use, the first one is overwritten.
+ * Clear() only bumps a generation counter, so clearing for each sentence is cheap
+ */
+class NGramCache
+{
+public:
+	typedef const void* State;
+
+	//! value of len for LMs which don't return it
+	static const unsigned int NO_LEN = (unsigned int) -1;
+
+protected:
+	struct Entry
+	{
+		unsigned int generation; //! entry is in use if same as m_generation
+		unsigned int keySize;
+		bool hasState; //! state and len were asked for when the entry was stored
+		float score;
+		State state;
+		unsigned int len;
+	};
+
+	static const size_t MAX_PROBES = 4;
+
+	std::vector<Entry> m_entries;
+	std::vector<const Factor*> m_keys; //! keys of all entries, m_maxKeySize apart
+	size_t m_maxKeySize, m_mask;
+	unsigned int m_generation;
+	size_t m_hits, m_misses;
+
+	size_t Hash(const Factor * const *key, size_t keySize) const;
+	bool Matches(size_t index, const Factor * const *key, size_t keySize) const
+	{
+		const Entry &entry = m_entries[index];
+		if (entry.generation != m_generation || entry.keySize != keySize)
+			return false;
+		const Factor * const *entryKey = &m_keys[index * m_maxKeySize];
+		for (size_t i = 0 ; i < keySize ; ++i)
+			if (entryKey[i] != key[i])
+				return false;
+		return true;
+	}
+
+public:
+	NGramCache()
+	:m_maxKeySize(0)
+	,m_mask(0)
+	,m_generation(1)
+	,m_hits(0)
+	,m_misses(0)
+	{}
+
+	/** allocate the cache. numEntries is rounded up to a power of 2, 0 means no caching
+	 * \param maxKeySize max number of factors in a key
+	 */
+	void Init(size_t numEntries, size_t maxKeySize);
+	bool IsEnabled() const
+	{
+		return !m_entries.empty();
+	}
+	//! forget all entries and reset the counters
+	void Clear();
+
+	/** look up a score. If state is not NULL, only entries stored with their state match
+	 * \return true if found
+	 */
+	bool Find(const Factor * const *key, size_t keySize, float &score, State *state, unsigned int *len);
+	void Insert(const Factor * const *key, size_t keySize, float score, const State *state, const unsigned int *len);
+
+	size_t GetHits() const
+	{
+		return m_hits;
+	}
+	size_t GetMisses() const
+	{
+		return m_misses;
+	}
+};
+
+}
+
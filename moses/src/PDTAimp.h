@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <limits>
 #include "StaticData.h"  // needed for factor splitter
 
 namespace Moses
@@ -13,16 +14,6 @@ inline bool existsFile(const char* filePath) {
   return  (stat(filePath,&mystat)==0);
 }
 
-double addLogScale(double x,double y) 
-{
-	if(x>y) return addLogScale(y,x); else return x+log(1.0+exp(y-x));
-}
-
-double Exp(double x)
-{
-	return exp(x);
-}
-
 class PDTAimp 
 {
 	// only these classes are allowed to instantiate this class
@@ -48,13 +39,13 @@ public:
 	int useCache;
 
 	std::vector<vTPC> m_rangeCache;
+	std::vector<PhraseDictionaryTree::PrefixPtr> m_prefixes; // prefix tree nodes of the cursors of ExtendLookup()
 	unsigned m_numInputScores;
 
 	UniqueObjectManager<Phrase> uniqSrcPhr;
 
 	size_t totalE,distinctE;
-	std::vector<size_t> path1Best,pathExplored;
-	std::vector<double> pathCN;
+	ConfusionNetPathStats pathStats; // of all confusion networks
 
 	~PDTAimp() 
 	{
@@ -70,30 +61,7 @@ public:
 								 <<")\n");
 
 				TRACE_ERR("\npath statistics\n");
-
-				if(path1Best.size()) 
-					{
-						TRACE_ERR("1-best:        ");
-						std::copy(path1Best.begin()+1,path1Best.end(),
-											std::ostream_iterator<size_t>(std::cerr," \t")); 
-						TRACE_ERR("\n");
-					}
-				if(pathCN.size())
-					{
-						TRACE_ERR("CN (full):     ");
-						std::transform(pathCN.begin()+1
-													,pathCN.end()
-													,std::ostream_iterator<double>(std::cerr," \t")
-													,Exp); 
-						TRACE_ERR("\n");
-					}
-				if(pathExplored.size())
-					{
-						TRACE_ERR("CN (explored): ");
-						std::copy(pathExplored.begin()+1,pathExplored.end(),
-											std::ostream_iterator<size_t>(std::cerr," \t")); 
-						TRACE_ERR("\n");
-					}
+				pathStats.Print(std::cerr);
 			}
 
 	}
@@ -111,6 +79,7 @@ public:
 		m_tgtColls.clear();
 		m_cache.clear();
 		m_rangeCache.clear();
+		m_prefixes.clear();
 		uniqSrcPhr.clear();
 	}
 
@@ -164,6 +133,64 @@ public:
 		std::vector<StringWordAlignmentCand> twacands;
 //		m_dict->GetTargetCandidates(srcString,cands);
 		m_dict->GetTargetCandidates(srcString,cands,swacands,twacands);
+
+		TargetPhraseCollection *rv=CreateTargetPhraseCollection(src,cands,swacands,twacands);
+		if(rv && useCache) piter.first->second=rv;
+		return rv;
+	}
+
+	// as GetTargetPhraseCollection(), but the source phrase is found by extending the prefix tree
+	// node of cursor, which is kept in m_prefixes, with the words up to the end of range
+	TargetPhraseCollection const*
+	ExtendLookup(InputType const& src,WordsRange const& range,PhraseDictionaryCursor &cursor)
+	{
+		assert(m_dict);
+		size_t pos=range.GetStartPos();
+		if(cursor.m_endPos==NOT_FOUND)
+			{
+				cursor.m_node=m_prefixes.size();
+				m_prefixes.push_back(m_dict->GetRoot());
+			}
+		else pos=cursor.m_endPos+1;
+
+		std::string word;
+		for(;pos<=range.GetEndPos() && cursor.m_node!=NOT_FOUND;++pos)
+			{
+				Factors2String(src.GetWord(pos),word);
+				PPtr next=m_dict->Extend(m_prefixes[cursor.m_node],word);
+				if(next) m_prefixes[cursor.m_node]=next;
+				else cursor.m_node=NOT_FOUND;
+			}
+		cursor.m_endPos=range.GetEndPos();
+		cursor.m_targetPhrases=0;
+		if(cursor.m_node==NOT_FOUND) return 0;
+
+		Phrase const srcPhrase=src.GetSubString(range);
+		std::pair<MapSrc2Tgt::iterator,bool> piter;
+		if(useCache)
+			{
+				piter=m_cache.insert(std::make_pair(srcPhrase,static_cast<TargetPhraseCollection const*>(0)));
+				if(!piter.second) return cursor.m_targetPhrases=piter.first->second;
+			}
+
+		std::vector<StringTgtCand> cands;
+		std::vector<StringWordAlignmentCand> swacands;
+		std::vector<StringWordAlignmentCand> twacands;
+		m_dict->GetTargetCandidates(m_prefixes[cursor.m_node],cands,swacands,twacands);
+
+		TargetPhraseCollection *rv=CreateTargetPhraseCollection(srcPhrase,cands,swacands,twacands);
+		if(rv && useCache) piter.first->second=rv;
+		return cursor.m_targetPhrases=rv;
+	}
+
+	// convert target candidates of src into target phrases, pruned to the table limit.
+	// 0 if there are none
+	TargetPhraseCollection*
+	CreateTargetPhraseCollection(Phrase const &src
+															,std::vector<StringTgtCand> const& cands
+															,std::vector<StringWordAlignmentCand> const& swacands
+															,std::vector<StringWordAlignmentCand> const& twacands) const
+	{
 		if(cands.empty()) 
 		{
 			return 0;
@@ -182,13 +209,14 @@ public:
 			StringWordAlignmentCand::second_type const& swaVector=swacands[i].second;
 			StringWordAlignmentCand::second_type const& twaVector=twacands[i].second;
 			
-			std::vector<float> scoreVector(probVector.size());
-			std::transform(probVector.begin(),probVector.end(),scoreVector.begin(),
+			std::vector<float> scoreVector(probVector.begin(),probVector.begin()+GetNumTranslationScores(probVector));
+			std::transform(scoreVector.begin(),scoreVector.end(),scoreVector.begin(),
 										 TransformScore);
 			std::transform(scoreVector.begin(),scoreVector.end(),scoreVector.begin(),
 										 FloorScore);
 			//				CreateTargetPhrase(targetPhrase,factorStrings,scoreVector,&src);
 			CreateTargetPhrase(targetPhrase,factorStrings,scoreVector,swaVector,twaVector,&src);
+			SetReorderingScores(targetPhrase,probVector.begin()+GetNumTranslationScores(probVector),probVector.end());
 			costs.push_back(std::make_pair(-targetPhrase.GetFutureScore(),tCands.size()));
 			tCands.push_back(targetPhrase);
 		}
@@ -202,7 +230,6 @@ public:
 		} 
 		else 
 		{
-			if(useCache) piter.first->second=rv;
 			m_tgtColls.push_back(rv);
 			return rv;
 		}
@@ -211,6 +238,30 @@ public:
 
 
 
+	// target candidates may have lexical reordering scores after the translation scores,
+	// merged into the table by processPhraseTable. Any other number of scores is a configuration error
+	size_t GetNumTranslationScores(Scores const& probVector) const
+	{
+		const size_t numTransScores=m_weights.size()-m_numInputScores;
+		if(probVector.size()!=numTransScores+m_dict->GetNumReorderingScores()) {
+			stringstream strme;
+			strme << "Phrase table " << m_obj->GetFilePath() << " has " << probVector.size() << " scores per target phrase, but "
+						<< numTransScores << " translation weights and " << m_dict->GetNumReorderingScores() << " lexical reordering scores are configured\n";
+			UserMessage::Add(strme.str());
+			exit(1);
+		}
+		return numTransScores;
+	}
+	// reordering scores of a target candidate, transformed like in a reordering table
+	void SetReorderingScores(TargetPhrase& targetPhrase,Scores::const_iterator begin,Scores::const_iterator end) const
+	{
+		if(begin==end) return;
+		Scores reorderingScores(begin,end);
+		std::transform(reorderingScores.begin(),reorderingScores.end(),reorderingScores.begin(),TransformScore);
+		std::transform(reorderingScores.begin(),reorderingScores.end(),reorderingScores.begin(),FloorScore);
+		targetPhrase.SetReorderingScores(reorderingScores);
+	}
+
 	void Create(const std::vector<FactorType> &input
 							, const std::vector<FactorType> &output
 							, const std::string &filePath
@@ -350,63 +401,105 @@ public:
 	struct TScores {
 		float total;
 		StringTgtCand::second_type trans;
+		StringTgtCand::second_type reordering; // lexical reordering scores, as in the table
 		Phrase const* src;
 
 		TScores() : total(0.0),src(0) {}
 	};
 
-	void CacheSource(ConfusionNet const& src) 
+	typedef std::map<StringTgtCand::first_type,TScores> E2Costs;
+	// partial paths from one start position to one end position, recombined on their prefix tree node
+	typedef std::map<PPtr,State> Paths;
+
+	// weighted input score of a path, to compare paths over the same span
+	float GetInputScore(std::vector<float> const& scores) const
 	{
-		assert(m_dict);
-		const size_t srcSize=src.GetSize();
+		return std::inner_product(scores.begin(),scores.begin()+m_numInputScores,m_weights.begin(),0.0f);
+	}
 
-		std::vector<size_t> exploredPaths(srcSize+1,0);
-		std::vector<double> exPathsD(srcSize+1,-1.0);
+	// drop paths whose input score is below that of the best path by more than threshold
+	void PrunePaths(Paths& paths,float threshold,ConfusionNetPathStats& stats) const
+	{
+		if(threshold==-std::numeric_limits<float>::infinity() || paths.size()<2) return;
+		float best=-std::numeric_limits<float>::infinity();
+		for(Paths::const_iterator i=paths.begin();i!=paths.end();++i)
+			best=std::max(best,GetInputScore(i->second.scores));
+		for(Paths::iterator i=paths.begin();i!=paths.end();)
+			{
+				if(GetInputScore(i->second.scores)<best+threshold)
+					{
+						stats.AddPruned(i->second.end()-i->second.begin());
+						paths.erase(i++);
+					}
+				else ++i;
+			}
+	}
 
-		// collect some statistics
-		std::vector<size_t> cnDepths(srcSize,0);
-		for(size_t i=0;i<srcSize;++i) cnDepths[i]=src[i].size();
+	// add the target candidates of the source phrases of paths to the candidates of their span
+	void LookupPaths(Paths const& paths,std::map<Range,E2Costs>& cov2cand)
+	{
+		std::vector<StringTgtCand> tcands;
+		for(Paths::const_iterator path=paths.begin();path!=paths.end();++path)
+			{
+				State const& curr=path->second;
+				tcands.clear();
+				// now, look up the target candidates (aprx. TargetPhraseCollection) for
+				// the current path through the CN
+				m_dict->GetTargetCandidates(curr.ptr,tcands);
+				totalE+=tcands.size();
+				if(tcands.empty()) continue;
+
+				E2Costs& e2costs=cov2cand[curr.range];
+				Phrase const* srcPtr=uniqSrcPhr(curr.src);
+				for(size_t i=0;i<tcands.size();++i)
+					{
+						//put input scores in first - already logged, just drop in directly
+						std::vector<float> nscores(curr.scores);
 
-		for(size_t len=1;len<=srcSize;++len)
-			for(size_t i=0;i<=srcSize-len;++i)
-				{
-					double pd=0.0; for(size_t k=i;k<i+len;++k)	pd+=log(1.0*cnDepths[k]);
-					exPathsD[len]=(exPathsD[len]>=0.0 ? addLogScale(pd,exPathsD[len]) : pd);
-				}
+						//resize to include phrase table scores
+						const size_t numTransScores=GetNumTranslationScores(tcands[i].second);
+						nscores.resize(m_numInputScores+numTransScores,0.0f);
 
-		// update global statistics
-		if(pathCN.size()<=srcSize) pathCN.resize(srcSize+1,-1.0);
-		for(size_t len=1;len<=srcSize;++len) 
-			pathCN[len]=pathCN[len]>=0.0 ? addLogScale(pathCN[len],exPathsD[len]) : exPathsD[len];
+						//put in phrase table scores, logging as we insert
+						std::transform(tcands[i].second.begin(),tcands[i].second.begin()+numTransScores,nscores.begin() + m_numInputScores,TransformScore);
 
-		if(path1Best.size()<=srcSize) path1Best.resize(srcSize+1,0);
-		for(size_t len=1;len<=srcSize;++len) path1Best[len]+=srcSize-len+1;
+						assert(nscores.size()==m_weights.size());
 
-		
-		if (StaticData::Instance().GetVerboseLevel() >= 2 && exPathsD.size())
-			{
-				TRACE_ERR("path stats for current CN: \nCN (full):     ");
-				std::transform(exPathsD.begin()+1
-											,exPathsD.end()
-											,std::ostream_iterator<double>(std::cerr," ")
-											,Exp);
-				TRACE_ERR("\n");
-			}
+						//tally up
+						float score=std::inner_product(nscores.begin(), nscores.end(), m_weights.begin(), 0.0f);
 
-		typedef StringTgtCand::first_type sPhrase;
-		typedef std::map<StringTgtCand::first_type,TScores> E2Costs;
+						//count word penalty
+						score-=tcands[i].first.size() * m_weightWP;
 
-		std::map<Range,E2Costs> cov2cand;
-		std::vector<State> stack;
-		for(Position i=0 ; i < srcSize ; ++i) 
-			stack.push_back(State(i, i, m_dict->GetRoot(), std::vector<float>(m_numInputScores,0.0)));
-					
-		while(!stack.empty()) 
+						std::pair<E2Costs::iterator,bool> p=e2costs.insert(std::make_pair(tcands[i].first,TScores()));
+
+						if(p.second) ++distinctE;
+
+						TScores & scores=p.first->second;
+						if(p.second || scores.total<score)
+							{
+								scores.total=score;
+								scores.trans=nscores;
+								scores.src=srcPtr;
+								scores.reordering.assign(tcands[i].second.begin()+numTransScores,tcands[i].second.end());
+							}
+					}
+			}
+	}
+
+	// extend paths by each word of the next column, into paths by their end position
+	void ExtendPaths(ConfusionNet const& src,Paths const& paths,std::vector<Paths>& pathsByEnd,ConfusionNetPathStats& stats) const
+	{
+		for(Paths::const_iterator path=paths.begin();path!=paths.end();++path)
 			{
-				State curr(stack.back());
-				stack.pop_back();
-		
-				assert(curr.end()<srcSize);
+				State const& curr=path->second;
+				assert(curr.end()<src.GetSize());
+
+				//we need to sum up link weights (excluding realWordCount, which isn't in numLinkParams)
+				//if the sum is too low, then we won't expand this.
+				//TODO: dodgy! shouldn't we consider weights here? what about zero-weight params?
+				if(std::accumulate(curr.scores.begin(),curr.scores.end(),0.0f)<=LOWEST_SCORE) continue;
+
 				const ConfusionNet::Column &currCol=src[curr.end()];
 				// in a given column, loop over all possibilities
 				for(size_t colidx=0;colidx<currCol.size();++colidx)
@@ -415,112 +508,89 @@ public:
 						std::string s;
 						Factors2String(w,s);
 						bool isEpsilon=(s=="" || s==EPSILON);
-						
+
 						//assert that we have the right number of link params in this CN option
 						assert(currCol[colidx].second.size() >= m_numInputScores);
-						
+
 						// do not start with epsilon (except at first position)
-						if(isEpsilon && curr.begin()==curr.end() && curr.begin()>0) continue; 
+						if(isEpsilon && curr.begin()==curr.end() && curr.begin()>0) continue;
 
 						// At a given node in the prefix tree, look to see if w defines an edge to
 						// another node (Extend).  Stay at the same node if w==EPSILON
 						PPtr nextP = (isEpsilon ? curr.ptr : m_dict->Extend(curr.ptr,s));
-						
-						if(nextP) // w is a word that should be considered
+						if(!nextP) continue;
+
+						Range newRange(curr.begin(),curr.end()+src.GetColumnIncrement(curr.end(),colidx));
+						stats.AddExplored(newRange.second-newRange.first);
+
+						//add together the link scores from the current state and the new arc
+						std::vector<float> newInputScores(m_numInputScores,0.0);
+						if (m_numInputScores) {
+							std::transform(currCol[colidx].second.begin(), currCol[colidx].second.begin()+m_numInputScores,
+										curr.scores.begin(),
+										newInputScores.begin(),
+										std::plus<float>());
+						}
+
+						// a path with the same words over the same span shares all its extensions and target
+						// candidates, only the one with the better input score needs to be kept
+						Paths& next=pathsByEnd[newRange.second];
+						std::pair<Paths::iterator,bool> p=next.insert(std::make_pair(nextP,State(newRange,nextP,newInputScores)));
+						State& newState=p.first->second;
+						if(p.second)
 							{
-								Range newRange(curr.begin(),curr.end()+src.GetColumnIncrement(curr.end(),colidx));
-								
-								//add together the link scores from the current state and the new arc
-								float inputScoreSum = 0;
-								std::vector<float> newInputScores(m_numInputScores,0.0);
-								if (m_numInputScores) {
-									std::transform(currCol[colidx].second.begin(), currCol[colidx].second.end(),
-												curr.GetScores().begin(),
-												newInputScores.begin(),
-												std::plus<float>());
-								
-								
-									//we need to sum up link weights (excluding realWordCount, which isn't in numLinkParams)
-									//if the sum is too low, then we won't expand this.
-									//TODO: dodgy! shouldn't we consider weights here? what about zero-weight params?
-									inputScoreSum = std::accumulate(newInputScores.begin(),newInputScores.begin()+m_numInputScores,0.0);
-								}
-							
-								Phrase newSrc(curr.src);
-								if(!isEpsilon) newSrc.AddWord(w);
-								if(newRange.second<srcSize && inputScoreSum>LOWEST_SCORE)
-								{
-									  // if there is more room to grow, add a new state onto the queue
-									// to be explored that represents [begin, curEnd+)
-									stack.push_back(State(newRange,nextP,newInputScores));
-									stack.back().src=newSrc;
-								}
-
-								std::vector<StringTgtCand> tcands;
-								// now, look up the target candidates (aprx. TargetPhraseCollection) for
-								// the current path through the CN
-								m_dict->GetTargetCandidates(nextP,tcands);
-
-								if(newRange.second>=exploredPaths.size()+newRange.first) 
-									exploredPaths.resize(newRange.second-newRange.first+1,0);
-								++exploredPaths[newRange.second-newRange.first];
-	
-								totalE+=tcands.size();
-
-								if(tcands.size()) 
-									{
-										E2Costs& e2costs=cov2cand[newRange];
-										Phrase const* srcPtr=uniqSrcPhr(newSrc);
-										for(size_t i=0;i<tcands.size();++i)
-										{											
-											//put input scores in first - already logged, just drop in directly
-											std::vector<float> nscores(newInputScores);
-											
-											//resize to include phrase table scores
-											nscores.resize(m_numInputScores+tcands[i].second.size(),0.0f);
-											
-											//put in phrase table scores, logging as we insert
-											std::transform(tcands[i].second.begin(),tcands[i].second.end(),nscores.begin() + m_numInputScores,TransformScore);
-											
-											assert(nscores.size()==m_weights.size());
-											
-											//tally up
-											float score=std::inner_product(nscores.begin(), nscores.end(), m_weights.begin(), 0.0f);
-
-											//count word penalty
-											score-=tcands[i].first.size() * m_weightWP;
-											
-											std::pair<E2Costs::iterator,bool> p=e2costs.insert(std::make_pair(tcands[i].first,TScores()));
-											
-											if(p.second) ++distinctE;
-											
-											TScores & scores=p.first->second;
-											if(p.second || scores.total<score)
-											{
-												scores.total=score;
-												scores.trans=nscores;
-												scores.src=srcPtr;
-											}
-										}
-									}
+								newState.src=curr.src;
+								if(!isEpsilon) newState.src.AddWord(w);
+							}
+						else
+							{
+								stats.AddRecombined(newRange.second-newRange.first);
+								if(GetInputScore(newInputScores)>GetInputScore(newState.scores)) newState.scores=newInputScores;
 							}
 					}
-			} // end while(!stack.empty()) 
+			}
+	}
+
+	// the target phrases of all spans of src, by expanding the paths from each start position
+	// column by column, recombining and pruning them before they are looked up and extended
+	void CacheSource(ConfusionNet const& src) 
+	{
+		assert(m_dict);
+		const size_t srcSize=src.GetSize();
+		const float threshold=StaticData::Instance().GetConfusionNetPathThreshold();
 
+		ConfusionNetPathStats stats;
+		stats.AddPaths(src);
 
-		if (StaticData::Instance().GetVerboseLevel() >= 2 && exploredPaths.size())
+		std::map<Range,E2Costs> cov2cand;
+		std::vector<Paths> pathsByEnd;
+		for(Position start=0 ; start < srcSize ; ++start) 
 			{
-				TRACE_ERR("CN (explored): ");
-				std::copy(exploredPaths.begin()+1,exploredPaths.end(),
-									std::ostream_iterator<size_t>(std::cerr," ")); 
-				TRACE_ERR("\n");
-			}
+				pathsByEnd.assign(srcSize+1,Paths());
+				PPtr root=m_dict->GetRoot();
+				pathsByEnd[start].insert(std::make_pair(root,State(start, start, root, std::vector<float>(m_numInputScores,0.0))));
 
-		if(pathExplored.size()<exploredPaths.size()) 
-			pathExplored.resize(exploredPaths.size(),0);
-		for(size_t len=1;len<=srcSize;++len)
-			pathExplored[len]+=exploredPaths[len];
+				// paths only grow, so all paths to an end position are known once the ones before it are extended
+				for(size_t end=start ; end <= srcSize ; ++end)
+					{
+						Paths& paths=pathsByEnd[end];
+						if(paths.empty()) continue;
+						if(end>start)
+							{
+								PrunePaths(paths,threshold,stats);
+								LookupPaths(paths,cov2cand);
+							}
+						if(end<srcSize) ExtendPaths(src,paths,pathsByEnd,stats);
+						paths.clear();
+					}
+			}
 
+		if (StaticData::Instance().GetVerboseLevel() >= 2)
+			{
+				TRACE_ERR("path stats for current CN: \n");
+				stats.Print(std::cerr);
+			}
+		pathStats.Add(stats);
 
 		m_rangeCache.resize(src.GetSize(),vTPC(src.GetSize(),0));
 
@@ -539,6 +609,7 @@ public:
 						TScores const & scores=j->second;
 						TargetPhrase targetPhrase(Output);
 						CreateTargetPhrase(targetPhrase,j->first,scores.trans,scores.src);
+						SetReorderingScores(targetPhrase,scores.reordering.begin(),scores.reordering.end());
 						costs.push_back(std::make_pair(-targetPhrase.GetFutureScore(),tCands.size()));
 						tCands.push_back(targetPhrase);
 						//std::cerr << i->first.first << "-" << i->first.second << ": " << targetPhrase << std::endl;
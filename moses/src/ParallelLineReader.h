@@ -0,0 +1,243 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <istream>
+#include <string>
+#include <vector>
+#include "Thread.h"
+#include "Util.h"
+
+namespace Moses
+{
+
+/** parses the lines of a model file on several threads.
+ * The file is read sequentially, as gzipped files can't be split, and handed out to the
+ * workers in chunks of lines. Chunks come back in file order, so what is built from them,
+ * eg. the order in which factors are interned, is the same for any number of threads.
+ *
+ * Parser is a copyable functor
+ *   bool operator()(const std::string &line, size_t lineNum, Record &record)
+ * returning false for lines to skip. Each worker has its own copy, which is called
+ * concurrently with the others, so it mustn't change anything shared.
+ * Without --enable-threads, or with 1 thread, lines are parsed by Next()
+ */
+template<typename Record, typename Parser>
+class ParallelLineReader
+{
+public:
+	typedef std::vector<Record> Chunk;
+
+protected:
+	static const size_t CHUNK_SIZE = 4096; //! lines per chunk
+
+	struct Job
+	{
+		size_t lineNum; //! of the line before the first line in the chunk
+		std::vector<std::string> lines;
+		Chunk records;
+		bool done;
+	};
+
+	std::istream &m_in;
+	Parser m_parser;
+	size_t m_lineNum;
+	Job *m_current; //! last chunk returned by Next()
+
+	//! read next chunk of lines into job. false at end of file. Caller must be the only reader
+	bool Read(Job &job)
+	{
+		job.lineNum = m_lineNum;
+		job.lines.resize(CHUNK_SIZE);
+		size_t numLines = 0;
+		while (numLines < CHUNK_SIZE && getline(m_in, job.lines[numLines]))
+			++numLines;
+		job.lines.resize(numLines);
+		m_lineNum += numLines;
+		return numLines > 0;
+	}
+	static void Parse(Parser &parser, Job &job)
+	{
+		job.records.clear();
+		job.records.reserve(job.lines.size());
+		Record record;
+		for (size_t i = 0 ; i < job.lines.size() ; ++i)
+		{
+			if (parser(job.lines[i], job.lineNum + i + 1, record))
+				job.records.push_back(record);
+		}
+		job.lines.clear();
+	}
+
+#ifdef WITH_THREADS
+	class Worker : public Thread
+	{
+	protected:
+		ParallelLineReader &m_reader;
+		Parser m_parser;
+	public:
+		Worker(ParallelLineReader &reader, const Parser &parser)
+		:m_reader(reader)
+		,m_parser(parser)
+		{}
+		~Worker()
+		{
+			Join();
+		}
+		void Run()
+		{
+			m_reader.Work(m_parser);
+		}
+	};
+
+	std::vector<Worker*> m_workers;
+	std::deque<Job*> m_jobs; //! chunks handed out but not yet returned, in file order
+	size_t m_maxJobs;
+	bool m_eof, m_stop;
+	Mutex m_mutex, m_readMutex; //! m_readMutex is taken first
+	Condition m_changed;
+
+	void Work(Parser &parser)
+	{
+		while (true)
+		{
+			Job *job;
+			{
+				ScopedLock readLock(m_readMutex);
+				{
+					ScopedLock lock(m_mutex);
+					while (m_jobs.size() >= m_maxJobs && !m_stop)
+						m_changed.Wait(m_mutex);
+					if (m_eof || m_stop)
+						return;
+				}
+
+				job = new Job;
+				job->done = false;
+				bool read = Read(*job);
+
+				ScopedLock lock(m_mutex);
+				if (!read)
+				{
+					delete job;
+					m_eof = true;
+					m_changed.Broadcast();
+					return;
+				}
+				m_jobs.push_back(job);
+			}
+
+			Parse(parser, *job);
+
+			ScopedLock lock(m_mutex);
+			job->done = true;
+			m_changed.Broadcast();
+		}
+	}
+#endif
+
+public:
+#ifdef WITH_THREADS
+	ParallelLineReader(std::istream &in, const Parser &parser, size_t numThreads)
+#else
+	ParallelLineReader(std::istream &in, const Parser &parser, size_t /*numThreads*/)
+#endif
+	:m_in(in)
+	,m_parser(parser)
+	,m_lineNum(0)
+	,m_current(NULL)
+#ifdef WITH_THREADS
+	,m_maxJobs(2 * numThreads)
+	,m_eof(false)
+	,m_stop(false)
+#endif
+	{
+#ifdef WITH_THREADS
+		for (size_t i = 0 ; numThreads > 1 && i < numThreads ; ++i)
+		{
+			Worker *worker = new Worker(*this, parser);
+			if (!worker->Start())
+			{
+				// any workers already running will do
+				delete worker;
+				break;
+			}
+			m_workers.push_back(worker);
+		}
+#endif
+	}
+	~ParallelLineReader()
+	{
+#ifdef WITH_THREADS
+		{
+			ScopedLock lock(m_mutex);
+			m_stop = true;
+			m_changed.Broadcast();
+		}
+		RemoveAllInColl(m_workers);
+		RemoveAllInColl(m_jobs);
+#endif
+		delete m_current;
+	}
+
+	//! number of threads parsing the file. 0 if it is parsed by Next()
+	size_t GetNumThreads() const
+	{
+#ifdef WITH_THREADS
+		return m_workers.size();
+#else
+		return 0;
+#endif
+	}
+
+	//! next chunk of parsed lines, in file order. NULL at end of file. Valid until the next call
+	const Chunk *Next()
+	{
+		delete m_current;
+		m_current = NULL;
+
+#ifdef WITH_THREADS
+		if (!m_workers.empty())
+		{
+			ScopedLock lock(m_mutex);
+			while (m_jobs.empty() ? !m_eof : !m_jobs.front()->done)
+				m_changed.Wait(m_mutex);
+			if (m_jobs.empty())
+				return NULL;
+			m_current = m_jobs.front();
+			m_jobs.pop_front();
+			m_changed.Broadcast();
+			return &m_current->records;
+		}
+#endif
+
+		m_current = new Job;
+		if (!Read(*m_current))
+			return NULL;
+		Parse(m_parser, *m_current);
+		return &m_current->records;
+	}
+};
+
+}
+
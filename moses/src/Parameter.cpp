@@ -48,9 +48,13 @@ Parameter::Parameter()
 	AddParam("input-file", "i", "location of the input file to be translated");
 	AddParam("inputtype", "text (0), confusion network (1), word lattice (2) (default = 0)");
 	AddParam("labeled-n-best-list", "print out labels for each weight type in n-best list. default is true");
+	AddParam("binary-n-best-list", "write the n-best list in a binary format read by mert/extractor, without alignments. default is false");
 	AddParam("include-alignment-in-n-best", "include word alignment in the n-best list. default is false");
 	AddParam("lmodel-file", "location and properties of the language models");
 	AddParam("lmodel-dub", "dictionary upper bounds of language models");
+	AddParam("filter-input", "only load the model entries reachable from the words of this file: the input text, or a list of its words. Text input only");
+	AddParam("bloom-filter-bits", "bits per entry of a bloom filter in front of each phrase table in text format and internal language model, 0 for none (default 0). Binary phrase tables use the filter written by processPhraseTable -bloom-bits. Lookups which walk a phrase table word by word don't use it: those of sentences, and of confusion networks and lattices in binary tables");
+	AddParam("lmodel-cache-size", "number of n-gram scores each language model caches during a sentence, 0 to disable (default 65536)");
 	AddParam("lmstats", "L", "(1/0) compute LM backoff statistics for each translation hypothesis");
 	AddParam("mapping", "description of decoding steps");
 	AddParam("max-partial-trans-opt", "maximum number of partial translation options per input span (during mapping steps)");
@@ -68,6 +72,7 @@ Parameter::Parameter()
 	AddParam("ttable-file", "location and properties of the translation tables");
 	AddParam("ttable-limit", "ttl", "maximum number of translation table entries per input phrase");
 	AddParam("translation-option-threshold", "tot", "threshold for translation options relative to best for input phrase");
+	AddParam("confusion-net-path-threshold", "cnpt", "threshold for paths through a confusion network relative to the best path over the same span, by input score");
 	AddParam("early-discarding-threshold", "edt", "threshold for constructing hypotheses based on estimate cost");
 	AddParam("verbose", "v", "verbosity level of the logging");
 	AddParam("weight-d", "d", "weight(s) for distortion (reordering components)");
@@ -106,6 +111,11 @@ Parameter::Parameter()
 	AddParam("print-alignment-info", "Output word-to-word alignment into the log file. Word-to-word alignments are takne from the phrase table if any. Default is false");
 	AddParam("print-alignment-info-in-n-best", "Include word-to-word alignment in the n-best list. Word-to-word alignments are takne from the phrase table if any. Default is false");
 	AddParam("link-param-count", "Number of parameters on word links when using confusion networks or lattices (default = 1)");
+	AddParam("server", "keep the models loaded and translate sentences sent to a socket: unix:PATH, tcp:PORT or tcp:HOST:PORT");
+	AddParam("load-threads", "number of threads parsing each language model and phrase table in text format while loading (default 1, needs threads)");
+	AddParam("option-threads", "number of threads creating the translation options of each sentence (default 1, needs threads)");
+	AddParam("async-io", "read input and write output on separate threads, overlapping with decoding (default false, needs threads)");
+	AddParam("vocabulary-file", "word lists added to the vocabulary at load time, eg. for binary phrase tables (format: FACTOR-TYPE filePath)");
 }
 
 Parameter::~Parameter()
@@ -303,6 +313,8 @@ bool Parameter::Validate()
 	  //raw tables in either un compressed or compressed form
 	  ext.push_back("");
 	  ext.push_back(".gz");
+		// binary generation table
+		ext.push_back(".bingen");
 		noErrorFlag = FilesExist("generation-file", 3, ext);
 	}
 	// distortion
@@ -314,6 +326,10 @@ bool Parameter::Validate()
 	  ext.push_back(".gz");
 	  //prefix tree format
 	  ext.push_back(".binlexr.idx");
+	  // quantized binary format
+	  ext.push_back(".binlexq");
+	  // scores stored in the binary phrase table
+	  ext.push_back(".binphr.reordering");
 	  noErrorFlag = FilesExist("distortion-file", 3, ext);
 	}
 	return noErrorFlag;
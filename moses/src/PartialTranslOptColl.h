@@ -77,6 +77,14 @@ public:
 	size_t GetPrunedCount() {
 		return m_totalPruned;
 	}
+	/** count options which were never created, as they would have been pruned */
+	void AddPrunedCount(size_t numPruned) {
+		m_totalPruned += numPruned;
+	}
+	/** options scoring less than this are pruned when added. -inf until the collection has been pruned */
+	float GetWorstScore() const {
+		return m_worstScore;
+	}
 	
 };
 
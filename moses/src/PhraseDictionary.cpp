@@ -41,6 +41,14 @@ GetTargetPhraseCollection(InputType const& src,WordsRange const& range) const
 	return GetTargetPhraseCollection(src.GetSubString(range));
 }
 
+const TargetPhraseCollection *PhraseDictionary::
+ExtendLookup(InputType const& src, WordsRange const& range, PhraseDictionaryCursor &cursor) const
+{
+	cursor.m_endPos = range.GetEndPos();
+	cursor.m_targetPhrases = GetTargetPhraseCollection(src, range);
+	return cursor.m_targetPhrases;
+}
+
 std::string PhraseDictionary::GetScoreProducerDescription() const
 {
 	return "PhraseModel";
@@ -39,6 +39,23 @@ class StaticData;
 class InputType;
 class WordsRange;
 
+/** where the lookup of the phrases starting at 1 position of the input has got to in a phrase table.
+ * The phrases are looked up 1 word longer each time, so tables which can extend the lookup of the
+ * phrase 1 word shorter need 1 step per phrase, and none once no source phrase starts with the words so far
+ */
+struct PhraseDictionaryCursor
+{
+	size_t m_endPos; //! last word of the phrase looked up so far. NOT_FOUND before the first lookup
+	size_t m_node; //! position in the table's trie, meaning depends on the table. NOT_FOUND if no source phrase starts with the phrase
+	const TargetPhraseCollection *m_targetPhrases; //! translations of the phrase
+
+	PhraseDictionaryCursor()
+	:m_endPos(NOT_FOUND)
+	,m_node(NOT_FOUND)
+	,m_targetPhrases(NULL)
+	{}
+};
+
 /** abstract base class for phrase table classes
 */
 class PhraseDictionary : public Dictionary, public StatelessFeatureFunction
@@ -54,6 +71,7 @@ class PhraseDictionary : public Dictionary, public StatelessFeatureFunction
 	DecodeType GetDecodeType() const	{	return Translate;	}
 	//! table limit number. 
 	size_t GetTableLimit() const { return m_tableLimit; }
+	const std::string &GetFilePath() const { return m_filePath; }
 
 	//! Overriden by load on demand phrase tables classes to load data for each input
 	virtual void InitializeForInput(InputType const &/*source*/) {}
@@ -75,6 +93,11 @@ class PhraseDictionary : public Dictionary, public StatelessFeatureFunction
 	virtual const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase& src) const=0;
 	//! find list of translations that can translates a portion of src. Used by confusion network decoding
 	virtual const TargetPhraseCollection *GetTargetPhraseCollection(InputType const& src,WordsRange const& range) const;
+	/** as GetTargetPhraseCollection(src, range), extending cursor from a shorter phrase with the same start to range.
+	 * cursor must be new, or have been used only for shorter phrases of the same start position.
+	 * The default looks up range from scratch
+	 */
+	virtual const TargetPhraseCollection *ExtendLookup(InputType const& src, WordsRange const& range, PhraseDictionaryCursor &cursor) const;
 	//! Create entry for translation of source to targetPhrase
 	virtual void AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase)=0;
 };
@@ -0,0 +1,227 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include "PhraseDictionaryFlatTrie.h"
+#include "PhraseDictionaryNode.h"
+#include "FactorCollection.h"
+#include "Phrase.h"
+#include "Word.h"
+#include "StaticData.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+struct PhraseDictionaryFlatTrie::ChildOrderer
+{
+	size_t m_keySize;
+
+	ChildOrderer(size_t keySize)
+	:m_keySize(keySize)
+	{}
+	bool operator()(const Child &a, const Child &b) const
+	{
+		return CompareKey(a.m_key, b.m_key, m_keySize) < 0;
+	}
+};
+
+bool PhraseDictionaryFlatTrie::GetKey(const Word &word, UINT32 *key) const
+{
+	for (size_t i = 0 ; i < m_keyFactors.size() ; ++i)
+	{
+		const Factor *factor = word[m_keyFactors[i]];
+		if (factor == NULL)
+			return false;
+		key[i] = (UINT32) factor->GetId();
+	}
+	return true;
+}
+
+void PhraseDictionaryFlatTrie::Count(const PhraseDictionaryNode &node
+																		, size_t &numNodes, size_t &numCollections, size_t &numPhrases)
+{
+	++numNodes;
+	const TargetPhraseCollection *collection = node.GetTargetPhraseCollection();
+	if (collection != NULL)
+	{
+		++numCollections;
+		numPhrases += collection->GetSize();
+	}
+	PhraseDictionaryNode::const_iterator iter;
+	for (iter = node.begin() ; iter != node.end() ; ++iter)
+		Count(iter->second, numNodes, numCollections, numPhrases);
+}
+
+void PhraseDictionaryFlatTrie::Build(PhraseDictionaryNode &root, const vector<FactorType> &keyFactors)
+{
+	m_keyFactors = keyFactors;
+	m_nodes.clear();
+	m_keys.clear();
+	m_collections.clear();
+	m_targetPhrases.clear();
+
+	// everything is allocated up front, the collections point into m_targetPhrases
+	size_t numNodes = 0, numCollections = 0, numPhrases = 0;
+	Count(root, numNodes, numCollections, numPhrases);
+	m_nodes.reserve(numNodes);
+	m_keys.reserve(numNodes * m_keyFactors.size());
+	m_collections.reserve(numCollections);
+	m_targetPhrases.reserve(numPhrases);
+
+	Node rootNode = { 0, 0, NO_COLLECTION };
+	m_nodes.push_back(rootNode);
+	m_keys.resize(m_keyFactors.size(), 0);
+	Add(0, root);
+
+	VERBOSE(2, "Compacted phrase table: " << numNodes << " nodes, " << numPhrases << " target phrases, "
+						<< GetMemoryUsage() << " bytes" << endl);
+}
+
+void PhraseDictionaryFlatTrie::Add(size_t nodeIndex, PhraseDictionaryNode &node)
+{
+	TargetPhraseCollection *collection = node.ReleaseTargetPhraseCollection();
+	if (collection != NULL)
+	{
+		m_nodes[nodeIndex].m_collection = (UINT32) m_collections.size();
+		m_collections.push_back(TargetPhraseCollection(false));
+		TargetPhraseCollection &flatCollection = m_collections.back();
+		// same order as in the loaded collection, which is already sorted
+		TargetPhraseCollection::const_iterator iter;
+		for (iter = collection->begin() ; iter != collection->end() ; ++iter)
+		{
+			m_targetPhrases.push_back(**iter);
+			flatCollection.Add(&m_targetPhrases.back());
+		}
+		delete collection;
+	}
+
+	const size_t keySize = m_keyFactors.size();
+	vector<Child> children;
+	children.reserve(node.GetSize());
+	PhraseDictionaryNode::iterator iter;
+	for (iter = node.begin() ; iter != node.end() ; ++iter)
+	{
+		Child child;
+		if (!GetKey(iter->first, child.m_key))
+			continue;
+		child.m_node = &iter->second;
+		children.push_back(child);
+	}
+	std::sort(children.begin(), children.end(), ChildOrderer(keySize));
+
+	// children first, so they are consecutive, then their subtrees
+	const size_t firstChild = m_nodes.size();
+	m_nodes[nodeIndex].m_firstChild = (UINT32) firstChild;
+	m_nodes[nodeIndex].m_numChildren = (UINT32) children.size();
+	for (size_t i = 0 ; i < children.size() ; ++i)
+	{
+		Node childNode = { 0, 0, NO_COLLECTION };
+		m_nodes.push_back(childNode);
+		m_keys.insert(m_keys.end(), children[i].m_key, children[i].m_key + keySize);
+	}
+	for (size_t i = 0 ; i < children.size() ; ++i)
+	{
+		Add(firstChild + i, *children[i].m_node);
+		children[i].m_node->Clear();
+	}
+}
+
+size_t PhraseDictionaryFlatTrie::GetChild(size_t node, const Word &word) const
+{
+	UINT32 key[MAX_NUM_FACTORS];
+	if (!GetKey(word, key))
+		return NOT_FOUND;
+
+	// lower bound of key in the children
+	const size_t keySize = m_keyFactors.size();
+	size_t first = m_nodes[node].m_firstChild, last = first + m_nodes[node].m_numChildren;
+	const size_t end = last;
+	while (first < last)
+	{
+		const size_t middle = (first + last) / 2;
+		if (CompareKey(&m_keys[middle * keySize], key, keySize) < 0)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	if (first == end || CompareKey(&m_keys[first * keySize], key, keySize) != 0)
+		return NOT_FOUND;
+	return first;
+}
+
+const TargetPhraseCollection *PhraseDictionaryFlatTrie::GetTargetPhraseCollection(const Phrase &source) const
+{
+	size_t node = GetRoot();
+	for (size_t pos = 0 ; pos < source.GetSize() && node != NOT_FOUND ; ++pos)
+		node = GetChild(node, source.GetWord(pos));
+	return (node == NOT_FOUND) ? NULL : GetTargetPhraseCollection(node);
+}
+
+void PhraseDictionaryFlatTrie::SetWeightTransModel(const ScoreProducer *phraseDictionary
+																									, const vector<float> &weightT
+																									, size_t tableLimit)
+{
+	for (size_t i = 0 ; i < m_targetPhrases.size() ; ++i)
+		m_targetPhrases[i].SetWeights(phraseDictionary, weightT);
+
+	// the best translations under the new weights go first
+	for (size_t i = 0 ; i < m_collections.size() ; ++i)
+		m_collections[i].NthElement(tableLimit);
+}
+
+size_t PhraseDictionaryFlatTrie::GetMemoryUsage() const
+{
+	size_t size = m_nodes.capacity() * sizeof(Node)
+							+ m_keys.capacity() * sizeof(UINT32)
+							+ m_collections.capacity() * sizeof(TargetPhraseCollection)
+							+ m_targetPhrases.capacity() * sizeof(TargetPhrase);
+	for (size_t i = 0 ; i < m_collections.size() ; ++i)
+		size += m_collections[i].GetSize() * sizeof(TargetPhrase*);
+	for (size_t i = 0 ; i < m_targetPhrases.size() ; ++i)
+		size += m_targetPhrases[i].GetSize() * sizeof(Word);
+	return size;
+}
+
+// friend
+ostream& operator<<(ostream &out, const PhraseDictionaryFlatTrie &trie)
+{
+	if (trie.m_nodes.empty())
+		return out;
+
+	// words leading from the root
+	vector<const Factor*> factors;
+	FactorCollection::Instance().GetFactors(0, factors);
+	const size_t keySize = trie.m_keyFactors.size();
+	const PhraseDictionaryFlatTrie::Node &root = trie.m_nodes[0];
+	for (size_t i = root.m_firstChild ; i < root.m_firstChild + root.m_numChildren ; ++i)
+	{
+		Word word;
+		for (size_t j = 0 ; j < keySize ; ++j)
+			word.SetFactor(trie.m_keyFactors[j], factors[trie.m_keys[i * keySize + j]]);
+		out << word;
+	}
+	return out;
+}
+
+}
+
@@ -0,0 +1,121 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "TypeDef.h"
+#include "TargetPhrase.h"
+#include "TargetPhraseCollection.h"
+
+namespace Moses
+{
+
+class Phrase;
+class Word;
+class PhraseDictionaryNode;
+class ScoreProducer;
+
+/** read-only trie of a phrase table in a few contiguous arrays, for lookups without pointer chasing.
+ * Nodes are numbered so that the children of a node are consecutive, and are sorted by
+ * their key, the ids of the input factors of the word leading to them, which is searched by bisection.
+ * Target phrases are stored in 1 array, grouped by source phrase, which the target phrase
+ * collections point into.
+ * Compacted from the PhraseDictionaryNode trie the table was loaded into
+ */
+class PhraseDictionaryFlatTrie
+{
+	friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryFlatTrie&);
+
+protected:
+	static const UINT32 NO_COLLECTION = 0xffffffff;
+
+	struct Node
+	{
+		UINT32 m_firstChild, m_numChildren; //! children are m_nodes[m_firstChild] onwards
+		UINT32 m_collection; //! index in m_collections, NO_COLLECTION if the node has no translations
+	};
+	//! child of a node of the PhraseDictionaryNode trie, while building
+	struct Child
+	{
+		UINT32 m_key[MAX_NUM_FACTORS];
+		PhraseDictionaryNode *m_node;
+	};
+	struct ChildOrderer;
+
+	std::vector<FactorType> m_keyFactors; //! input factors which make up the key of a word
+	std::vector<Node> m_nodes; //! root first
+	std::vector<UINT32> m_keys; //! m_keyFactors.size() factor ids for each node, in the same order as m_nodes
+	std::vector<TargetPhrase> m_targetPhrases;
+	std::vector<TargetPhraseCollection> m_collections; //! pointing into m_targetPhrases
+
+	//! key of word. false if it lacks one of the key factors, so can't be in the table
+	bool GetKey(const Word &word, UINT32 *key) const;
+	static int CompareKey(const UINT32 *a, const UINT32 *b, size_t keySize)
+	{
+		for (size_t i = 0 ; i < keySize ; ++i)
+		{
+			if (a[i] != b[i])
+				return (a[i] < b[i]) ? -1 : +1;
+		}
+		return 0;
+	}
+	static void Count(const PhraseDictionaryNode &node, size_t &numNodes, size_t &numCollections, size_t &numPhrases);
+	//! move contents of node, which has already been added at nodeIndex, and its subtree. Empties node
+	void Add(size_t nodeIndex, PhraseDictionaryNode &node);
+
+public:
+	//! move the contents of root into the flat trie, leaving root empty
+	void Build(PhraseDictionaryNode &root, const std::vector<FactorType> &keyFactors);
+	bool IsEmpty() const
+	{
+		return m_nodes.empty();
+	}
+
+	//! translations of source. NULL if there are none
+	const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &source) const;
+
+	//! node of the empty phrase. NOT_FOUND if the trie is empty
+	size_t GetRoot() const
+	{
+		return m_nodes.empty() ? NOT_FOUND : 0;
+	}
+	//! node of the phrase of node followed by word. NOT_FOUND if no source phrase starts with it
+	size_t GetChild(size_t node, const Word &word) const;
+	//! translations of the phrase of node. NULL if there are none
+	const TargetPhraseCollection *GetTargetPhraseCollection(size_t node) const
+	{
+		const UINT32 collection = m_nodes[node].m_collection;
+		return (collection == NO_COLLECTION) ? NULL : &m_collections[collection];
+	}
+
+	//! recalculate the weighted scores of all target phrases, and sort them again
+	void SetWeightTransModel(const ScoreProducer *phraseDictionary
+													, const std::vector<float> &weightT
+													, size_t tableLimit);
+
+	//! rough number of bytes used
+	size_t GetMemoryUsage() const;
+};
+
+}
+
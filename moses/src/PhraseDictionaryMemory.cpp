@@ -34,11 +34,101 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "WordsRange.h"
 #include "UserMessage.h"
 #include "AlignmentPair.h"
+#include "LoadFilter.h"
+#include "ParallelLineReader.h"
+#include "InputType.h"
 
 using namespace std;
 
 namespace Moses
 {
+
+namespace
+{
+//! 1 line of a phrase table, parsed as far as possible without creating factors
+struct PhrasePairLine
+{
+	enum Status { Keep, EmptySource, Filtered };
+
+	size_t lineNum, numElement;
+	Status status;
+	vector< vector<string> > source, target;
+	string sourceAlign, targetAlign;
+	vector<float> scores; //! already transformed and floored
+};
+
+class PhrasePairLineParser
+{
+protected:
+	const vector<FactorType> &m_input, &m_output;
+	const string &m_factorDelimiter;
+	size_t m_numScoreComponent;
+	bool m_wordDeletionEnabled;
+	const LoadFilter *m_loadFilter;
+
+public:
+	PhrasePairLineParser(const vector<FactorType> &input, const vector<FactorType> &output
+										, const string &factorDelimiter, size_t numScoreComponent
+										, bool wordDeletionEnabled, const LoadFilter *loadFilter)
+	:m_input(input)
+	,m_output(output)
+	,m_factorDelimiter(factorDelimiter)
+	,m_numScoreComponent(numScoreComponent)
+	,m_wordDeletionEnabled(wordDeletionEnabled)
+	,m_loadFilter(loadFilter)
+	{}
+
+	bool operator()(const string &line, size_t lineNum, PhrasePairLine &pair) const
+	{
+		vector<string> tokens = TokenizeMultiCharSeparator( line , "|||" );
+		pair.lineNum = lineNum;
+		pair.numElement = tokens.size();
+		pair.status = PhrasePairLine::Keep;
+		// wrong number of fields is reported by the caller, which knows what to expect
+		if (tokens.size() != 3 && tokens.size() != 5)
+			return true;
+
+		const string &sourcePhraseString = tokens[0];
+		const string &scoreString = tokens[tokens.size() - 1];
+
+		bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
+		if (isLHSEmpty && !m_wordDeletionEnabled) {
+			pair.status = PhrasePairLine::EmptySource;
+			return true;
+		}
+
+		pair.source = Phrase::Parse(sourcePhraseString, m_input, m_factorDelimiter);
+		if (m_loadFilter != NULL && !m_loadFilter->KeepSourcePhrase(pair.source, m_input))
+		{
+			pair.status = PhrasePairLine::Filtered;
+			return true;
+		}
+
+		vector<float> scoreVector = Tokenize<float>(scoreString);
+		if (scoreVector.size() != m_numScoreComponent) 
+		{
+			stringstream strme;
+			strme << "Size of scoreVector != number (" <<scoreVector.size() << "!=" <<m_numScoreComponent<<") of score components on line " << lineNum;
+			UserMessage::Add(strme.str());
+			abort();
+		}
+
+		pair.target = Phrase::Parse(tokens[1], m_output, m_factorDelimiter);
+		if (tokens.size() == 5)
+		{
+			pair.sourceAlign = tokens[2];
+			pair.targetAlign = tokens[3];
+		}
+
+		// component score, for n-best output
+		pair.scores.resize(scoreVector.size());
+		std::transform(scoreVector.begin(),scoreVector.end(),pair.scores.begin(),TransformScore);
+		std::transform(pair.scores.begin(),pair.scores.end(),pair.scores.begin(),FloorScore);
+		return true;
+	}
+};
+}
+
 bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
 																			, const std::vector<FactorType> &output
 																			, const string &filePath
@@ -48,6 +138,7 @@ bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
 														          , float weightWP)
 {
 	const StaticData &staticData = StaticData::Instance();
+	const LoadFilter *loadFilter = staticData.GetLoadFilter();
 	
 	m_tableLimit = tableLimit;
 	m_filePath = filePath;
@@ -60,102 +151,83 @@ bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
 	// data from file
 	InputFileStream inFile(filePath);
 
-	// create hash file if necessary
-	ofstream tempFile;
-	string tempFilePath;
+	PhrasePairLineParser parser(input, output, staticData.GetFactorDelimiter(), m_numScoreComponent
+														, staticData.IsWordDeletionEnabled(), loadFilter);
+	ParallelLineReader<PhrasePairLine, PhrasePairLineParser> reader(inFile, parser, staticData.GetLoadThreads());
 
-	vector< vector<string> >	phraseVector;
-	string line, prevSourcePhrase = "";
-	size_t count = 0;
-  size_t line_num = 0;
+	size_t count = 0, numFiltered = 0;
+	vector<UINT64> bloomKeys;
   size_t numElement = NOT_FOUND; // 3=old format, 5=async format which include word alignment info
   
-	while(getline(inFile, line)) 
+	const ParallelLineReader<PhrasePairLine, PhrasePairLineParser>::Chunk *chunk;
+	while ((chunk = reader.Next()) != NULL)
 	{
-		++line_num;
-		vector<string> tokens = TokenizeMultiCharSeparator( line , "|||" );
-		
-		if (numElement == NOT_FOUND) 
-		{ // init numElement
-			numElement = tokens.size();
-			assert(numElement == 3 || numElement == 5);
-		}
-			 
-		if (tokens.size() != numElement)
+		for (size_t i = 0 ; i < chunk->size() ; ++i)
 		{
-			stringstream strme;
-			strme << "Syntax error at " << filePath << ":" << line_num;
-			UserMessage::Add(strme.str());
-			abort();
-		}
-
-		string sourcePhraseString, targetPhraseString;
-		string scoreString;
-		string sourceAlignString, targetAlignString;
-
-		sourcePhraseString=tokens[0];
-		targetPhraseString=tokens[1];
-		if (numElement==3){
-			scoreString=tokens[2];
-		}
-		else{
-			sourceAlignString=tokens[2];
-			targetAlignString=tokens[3];
-			scoreString=tokens[4];
-		}
+			const PhrasePairLine &line = (*chunk)[i];
 		
-		bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-		if (isLHSEmpty && !staticData.IsWordDeletionEnabled()) {
-			TRACE_ERR( filePath << ":" << line_num << ": pt entry contains empty target, skipping\n");
-			continue;
-		}
+			if (numElement == NOT_FOUND) 
+			{ // init numElement
+				numElement = line.numElement;
+				assert(numElement == 3 || numElement == 5);
+			}
+				 
+			if (line.numElement != numElement)
+			{
+				stringstream strme;
+				strme << "Syntax error at " << filePath << ":" << line.lineNum;
+				UserMessage::Add(strme.str());
+				abort();
+			}
 
-		const std::string& factorDelimiter = StaticData::Instance().GetFactorDelimiter();
-		if (sourcePhraseString != prevSourcePhrase)
-			phraseVector = Phrase::Parse(sourcePhraseString, input, factorDelimiter);
+			if (line.status == PhrasePairLine::EmptySource) {
+				TRACE_ERR( filePath << ":" << line.lineNum << ": pt entry contains empty target, skipping\n");
+				continue;
+			}
+			if (line.status == PhrasePairLine::Filtered)
+			{
+				++numFiltered;
+				continue;
+			}
 
-		vector<float> scoreVector = Tokenize<float>(scoreString);
-		if (scoreVector.size() != m_numScoreComponent) 
-		{
-			stringstream strme;
-			strme << "Size of scoreVector != number (" <<scoreVector.size() << "!=" <<m_numScoreComponent<<") of score components on line " << line_num;
-			UserMessage::Add(strme.str());
-			abort();
-		}
-//		assert(scoreVector.size() == m_numScoreComponent);
+			// source
+			Phrase sourcePhrase(Input);
+			sourcePhrase.CreateFromString( input, line.source);
+			//target
+			TargetPhrase targetPhrase(Output);
+			targetPhrase.SetSourcePhrase(&sourcePhrase);
+			targetPhrase.CreateFromString( output, line.target);
 			
-		// source
-		Phrase sourcePhrase(Input);
-		sourcePhrase.CreateFromString( input, phraseVector);
-		//target
-		TargetPhrase targetPhrase(Output);
-		targetPhrase.SetSourcePhrase(&sourcePhrase);
-		targetPhrase.CreateFromString( output, targetPhraseString, factorDelimiter);
-		
-		// load alignment info only when present and relevant	
-		if (staticData.UseAlignmentInfo()){
-			if (numElement==3){
-				stringstream strme;
-				strme << "You are using AlignmentInfo, but this info not available in the Phrase Table. Only " <<numElement<<" fields on line " << line_num;
-				UserMessage::Add(strme.str());
-				return false;
+			// load alignment info only when present and relevant	
+			if (staticData.UseAlignmentInfo()){
+				if (numElement==3){
+					stringstream strme;
+					strme << "You are using AlignmentInfo, but this info not available in the Phrase Table. Only " <<numElement<<" fields on line " << line.lineNum;
+					UserMessage::Add(strme.str());
+					return false;
+				}
+				targetPhrase.CreateAlignmentInfo(line.sourceAlign, line.targetAlign);
 			}
-			targetPhrase.CreateAlignmentInfo(sourceAlignString, targetAlignString);
-		}
-		
-		// component score, for n-best output
-		std::vector<float> scv(scoreVector.size());
-		std::transform(scoreVector.begin(),scoreVector.end(),scv.begin(),TransformScore);
-		std::transform(scv.begin(),scv.end(),scv.begin(),FloorScore);
-		targetPhrase.SetScore(this, scv, weight, weightWP, languageModels);
+			
+			targetPhrase.SetScore(this, line.scores, weight, weightWP, languageModels);
 
-		AddEquivPhrase(sourcePhrase, targetPhrase);
+			AddEquivPhrase(sourcePhrase, targetPhrase);
+			if (staticData.GetBloomFilterBits() > 0)
+				bloomKeys.push_back(BloomFilter::GetKey(sourcePhrase, m_inputFactors));
 
-		count++;
+			count++;
+		}
 	}
 
+	if (loadFilter != NULL)
+		VERBOSE(1, "Filtered " << numFiltered << " of " << (count + numFiltered) << " phrase pairs from " << filePath << endl);
+
 	// sort each target phrase collection
 	m_collection.Sort(m_tableLimit);
+	m_flatTrie.Build(m_collection, input);
+	m_collection.Clear();
+
+	m_bloomFilter.Init(bloomKeys, staticData.GetBloomFilterBits());
 
 	return true;
 }
@@ -178,6 +250,7 @@ TargetPhraseCollection *PhraseDictionaryMemory::CreateTargetPhraseCollection(con
 
 void PhraseDictionaryMemory::AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase)
 {
+	assert(m_flatTrie.GetTargetPhraseCollection(source) == NULL);
 	TargetPhraseCollection &phraseColl = *CreateTargetPhraseCollection(source);
 	phraseColl.Add(new TargetPhrase(targetPhrase));
 }
@@ -185,17 +258,55 @@ void PhraseDictionaryMemory::AddEquivPhrase(const Phrase &source, const TargetPh
 const TargetPhraseCollection *PhraseDictionaryMemory::GetTargetPhraseCollection(const Phrase &source) const
 { // exactly like CreateTargetPhraseCollection, but don't create
 	const size_t size = source.GetSize();
+
+	if (m_bloomFilter.IsEnabled() && !m_bloomFilter.MayContain(BloomFilter::GetKey(source, m_inputFactors)))
+		return NULL;
 	
-	const PhraseDictionaryNode *currNode = &m_collection;
-	for (size_t pos = 0 ; pos < size ; ++pos)
+	const TargetPhraseCollection *phraseColl = m_flatTrie.GetTargetPhraseCollection(source);
+	if (phraseColl == NULL && !m_collection.IsEmpty())
 	{
-		const Word& word = source.GetWord(pos);
-		currNode = currNode->GetChild(word);
-		if (currNode == NULL)
-			return NULL;
+		const PhraseDictionaryNode *currNode = &m_collection;
+		for (size_t pos = 0 ; pos < size && currNode != NULL ; ++pos)
+		{
+			const Word& word = source.GetWord(pos);
+			currNode = currNode->GetChild(word);
+		}
+		phraseColl = (currNode == NULL) ? NULL : currNode->GetTargetPhraseCollection();
 	}
 
-	return currNode->GetTargetPhraseCollection();
+	if (phraseColl == NULL && m_bloomFilter.IsEnabled())
+		m_bloomFilter.AddFalsePositive();
+	return phraseColl;
+}
+
+const TargetPhraseCollection *PhraseDictionaryMemory::ExtendLookup(InputType const& src
+																																	, WordsRange const& range
+																																	, PhraseDictionaryCursor &cursor) const
+{
+	// phrases added after loading aren't in the flat trie
+	if (src.GetType() != SentenceInput || !m_collection.IsEmpty()
+			|| (cursor.m_endPos != NOT_FOUND && cursor.m_endPos >= range.GetEndPos()))
+		return MyBase::ExtendLookup(src, range, cursor);
+
+	size_t pos = range.GetStartPos();
+	if (cursor.m_endPos == NOT_FOUND)
+		cursor.m_node = m_flatTrie.GetRoot();
+	else
+		pos = cursor.m_endPos + 1;
+
+	for ( ; pos <= range.GetEndPos() && cursor.m_node != NOT_FOUND ; ++pos)
+		cursor.m_node = m_flatTrie.GetChild(cursor.m_node, src.GetWord(pos));
+
+	cursor.m_endPos = range.GetEndPos();
+	cursor.m_targetPhrases = (cursor.m_node == NOT_FOUND) ? NULL : m_flatTrie.GetTargetPhraseCollection(cursor.m_node);
+	return cursor.m_targetPhrases;
+}
+
+void PhraseDictionaryMemory::CleanUp()
+{
+	if (m_bloomFilter.IsEnabled())
+		m_bloomFilter.Report(GetScoreProducerDescription());
+	MyBase::CleanUp();
 }
 
 PhraseDictionaryMemory::~PhraseDictionaryMemory()
@@ -204,6 +315,8 @@ PhraseDictionaryMemory::~PhraseDictionaryMemory()
 
 void PhraseDictionaryMemory::SetWeightTransModel(const vector<float> &weightT)
 {
+	m_flatTrie.SetWeightTransModel(this, weightT, m_tableLimit);
+
 	PhraseDictionaryNode::iterator iterDict;
 	for (iterDict = m_collection.begin() ; iterDict != m_collection.end() ; ++iterDict)
 	{
@@ -218,6 +331,7 @@ TO_STRING_BODY(PhraseDictionaryMemory);
 // friend
 ostream& operator<<(ostream& out, const PhraseDictionaryMemory& phraseDict)
 {
+	out << phraseDict.m_flatTrie;
 	const PhraseDictionaryNode &coll = phraseDict.m_collection;
 	PhraseDictionaryNode::const_iterator iter;	
 	for (iter = coll.begin() ; iter != coll.end() ; ++iter)
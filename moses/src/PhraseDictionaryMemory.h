@@ -24,12 +24,18 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "PhraseDictionary.h"
 #include "PhraseDictionaryNode.h"
+#include "PhraseDictionaryFlatTrie.h"
+#include "BloomFilter.h"
 
 namespace Moses
 {
 
 /*** Implementation of a phrase table in a trie.  Looking up a phrase of
  * length n words requires n look-ups to find the TargetPhraseCollection.
+ * The table is loaded into a trie of maps, which is then compacted into a
+ * PhraseDictionaryFlatTrie.
+ * Lookups only read the table, so they can run on several threads, as long as
+ * AddEquivPhrase() isn't called at the same time.
  */
 class PhraseDictionaryMemory : public PhraseDictionary
 {
@@ -37,7 +43,13 @@ class PhraseDictionaryMemory : public PhraseDictionary
 	friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryMemory&);
 
 protected:
-	PhraseDictionaryNode m_collection;
+	PhraseDictionaryNode m_collection; //! while loading. Afterwards, only phrases added by AddEquivPhrase()
+	PhraseDictionaryFlatTrie m_flatTrie; //! the loaded table
+	/** source phrases in the table, if bloom-filter-bits is set. Only GetTargetPhraseCollection() uses it:
+	 * the filter holds whole phrases, not prefixes, so it can't stop the trie walk of ExtendLookup() earlier
+	 * than the trie itself does
+	 */
+	BloomFilter m_bloomFilter;
 
 	TargetPhraseCollection *CreateTargetPhraseCollection(const Phrase &source);
 	
@@ -57,9 +69,14 @@ public:
 						    , float weightWP);
 	
 	const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &source) const;
+	//! 1 step in the flat trie for each word the phrase of cursor is extended by
+	const TargetPhraseCollection *ExtendLookup(InputType const& src, WordsRange const& range, PhraseDictionaryCursor &cursor) const;
 
+	//! after loading, only for source phrases which aren't in the table
 	void AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase);
 
+	void CleanUp();
+
 	// for mert
 	void SetWeightTransModel(const std::vector<float> &weightT);
 	
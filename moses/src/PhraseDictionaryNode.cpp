@@ -30,6 +30,13 @@ PhraseDictionaryNode::~PhraseDictionaryNode()
 	delete m_targetPhraseCollection;
 }
 
+void PhraseDictionaryNode::Clear()
+{
+	m_map.clear();
+	delete m_targetPhraseCollection;
+	m_targetPhraseCollection = NULL;
+}
+
 void PhraseDictionaryNode::Sort(size_t tableLimit)
 {
 	// recusively sort
@@ -87,6 +94,9 @@ void PhraseDictionaryNode::SetWeightTransModel(const PhraseDictionaryMemory *phr
 		targetPhrase.SetWeights(phraseDictionary, weightT);
 	}
 
+	// the best translations under the new weights go first
+	m_targetPhraseCollection->NthElement(phraseDictionary->GetTableLimit());
+
 }
 
 }
@@ -66,6 +66,24 @@ public:
 			m_targetPhraseCollection = new TargetPhraseCollection();
 		return m_targetPhraseCollection;
 	}
+	//! hand the target phrases over to the caller, who has to delete them
+	TargetPhraseCollection *ReleaseTargetPhraseCollection()
+	{
+		TargetPhraseCollection *ret = m_targetPhraseCollection;
+		m_targetPhraseCollection = NULL;
+		return ret;
+	}
+	//! number of children
+	size_t GetSize() const
+	{
+		return m_map.size();
+	}
+	bool IsEmpty() const
+	{
+		return m_map.empty() && m_targetPhraseCollection == NULL;
+	}
+	//! delete children and target phrases
+	void Clear();
 	// for mert
 	void SetWeightTransModel(const PhraseDictionaryMemory *phraseDictionary
 													, const std::vector<float> &weightT);
@@ -110,11 +110,75 @@ public:
 };
 
 
+// reads a lexical reordering table (f ||| e ||| scores) in step with a phrase table sorted the same way,
+// with LC_ALL=C sort. Keys are "f ||| e ||| " with single spaces, in which order the lines are sorted
+class ReorderingTableReader {
+	std::istream &in;
+	std::string key; // of the current line, empty at the end of the table
+	Scores sc;
+	size_t lnc, numScores;
+
+	void Next()
+	{
+		std::string line, prevKey(key);
+		key.clear();
+		while(key.empty() && getline(in,line))
+		{
+			++lnc;
+			std::vector<std::string> tokens=TokenizeMultiCharSeparator(line,"|||");
+			if(tokens.size()!=3)
+			{
+				std::stringstream strme;
+				strme << "Reordering table line " << lnc << ": expected f ||| e ||| scores, found " << line;
+				UserMessage::Add(strme.str());
+				abort();
+			}
+			key=MakeKey(tokens[0],tokens[1]);
+			sc=Tokenize<float>(tokens[2]);
+			if(numScores==0) numScores=sc.size();
+			if(sc.size()!=numScores || key<=prevKey)
+			{
+				std::stringstream strme;
+				strme << "Reordering table line " << lnc << ": expected " << numScores
+							<< " scores, and the line to come after the previous one in LC_ALL=C sort order: " << line;
+				UserMessage::Add(strme.str());
+				abort();
+			}
+		}
+	}
+public:
+	ReorderingTableReader(std::istream &i) : in(i), lnc(0), numScores(0) {Next();}
+
+	static std::string MakeKey(const std::string &f,const std::string &e)
+	{
+		return Join(" ",Tokenize(f))+" ||| "+Join(" ",Tokenize(e))+" ||| ";
+	}
+	size_t GetNumScores() const {return numScores;}
+
+	// append the scores of phrase pair with key k to scores. false if there are none. Keys are
+	// asked for in sort order
+	bool Append(const std::string &k,Scores &scores)
+	{
+		while(!key.empty() && key<k) Next();
+		if(key!=k) return false;
+		scores.insert(scores.end(),sc.begin(),sc.end());
+		return true;
+	}
+};
+
+
 PhraseDictionaryTree::PrefixPtr::operator bool() const 
 {
 	return imp && imp->isValid();
 }
 
+bool PhraseDictionaryTree::PrefixPtr::operator<(const PrefixPtr& other) const
+{
+	if(imp->root!=other.imp->root) return imp->root;
+	if(imp->p!=other.imp->p) return imp->p<other.imp->p;
+	return imp->idx<other.imp->idx;
+}
+
 
 struct PDTimp {
   typedef PrefixTreeF<LabelId,OFF_T> PTF;
@@ -134,7 +198,14 @@ struct PDTimp {
 	bool usewordalign;
 	bool printwordalign;
 
-	PDTimp() : os(0),ot(0), usewordalign(false), printwordalign(false) {PTF::setDefault(InvalidOffT);}
+	BloomFilter bloomFilter; // source phrases, if the table was binarized with one
+	size_t bloomFilterBits; // bits per source phrase of the filter written by Create()
+
+	std::istream *reorderingTable; // merged into the table by Create(), or 0
+	size_t numReorderingScores; // after the translation scores of the target candidates, 0 if none were merged
+
+	PDTimp() : os(0),ot(0), usewordalign(false), printwordalign(false), bloomFilterBits(0)
+		, reorderingTable(0), numReorderingScores(0) {PTF::setDefault(InvalidOffT);}
 	~PDTimp() {if(os) fClose(os);if(ot) fClose(ot);FreeMemory();}
 	
 	inline void UseWordAlignment(bool a){ usewordalign=a; }
@@ -150,6 +221,16 @@ struct PDTimp {
 	}
 
 	int Read(const std::string& fn);
+
+	// false if the source phrase is certainly not in the table
+	bool MayContain(const std::vector<std::string>& src) const
+	{
+		return !bloomFilter.IsEnabled() || bloomFilter.MayContain(BloomFilter::GetKey(src));
+	}
+	void CheckFalsePositive(bool found) const
+	{
+		if(!found && bloomFilter.IsEnabled()) bloomFilter.AddFalsePositive();
+	}
 	
 	void GetTargetCandidates(const IPhrase& f,TgtCands& tgtCands) 
 	{
@@ -302,6 +383,23 @@ int PDTimp::Read(const std::string& fn)
   
 	sv.Read(ifsv);
 	tv.Read(iftv);
+
+	if (FileExists(fn+".binphr.bloom"))
+	{
+		bloomFilter.Load(fn+".binphr.bloom");
+		TRACE_ERR("using bloom filter "<<fn<<".binphr.bloom\n");
+	}
+
+	numReorderingScores=0;
+	if (FileExists(fn+".binphr.reordering"))
+	{
+		FILE *ir=fOpen((fn+".binphr.reordering").c_str(),"rb");
+		UINT32 n;
+		fRead(ir,n);
+		fClose(ir);
+		numReorderingScores=n;
+		TRACE_ERR("target candidates have "<<n<<" lexical reordering scores\n");
+	}
   
 	TRACE_ERR("binary phrasefile loaded, default OFF_T: "<<PTF::getDefault()
 					 <<"\n");
@@ -356,6 +454,10 @@ void PhraseDictionaryTree::UseWordAlignment(bool a){ imp->UseWordAlignment(a); }
 bool PhraseDictionaryTree::UseWordAlignment(){ return imp->UseWordAlignment(); };
 
 void PhraseDictionaryTree::PrintWordAlignment(bool a){ imp->PrintWordAlignment(a); };
+void PhraseDictionaryTree::SetBloomFilterBits(size_t bitsPerPhrase){ imp->bloomFilterBits=bitsPerPhrase; }
+void PhraseDictionaryTree::SetReorderingTable(std::istream* reorderingTable){ imp->reorderingTable=reorderingTable; }
+size_t PhraseDictionaryTree::GetNumReorderingScores() const { return imp->numReorderingScores; }
+const BloomFilter& PhraseDictionaryTree::GetBloomFilter() const { return imp->bloomFilter; }
 bool PhraseDictionaryTree::PrintWordAlignment(){ return imp->PrintWordAlignment(); };
 
 void PhraseDictionaryTree::FreeMemory() const
@@ -367,15 +469,18 @@ void PhraseDictionaryTree::
 GetTargetCandidates(const std::vector<std::string>& src,
 										std::vector<StringTgtCand>& rv) const 
 {
+	if(!imp->MayContain(src)) return;
+
 	IPhrase f(src.size());
 	for(size_t i=0;i<src.size();++i) 
 		{
 			f[i]=imp->sv.index(src[i]);
-			if(f[i]==InvalidLabelId) return;
+			if(f[i]==InvalidLabelId) {imp->CheckFalsePositive(false);return;}
 		}
 
 	TgtCands tgtCands;
 	imp->GetTargetCandidates(f,tgtCands);
+	imp->CheckFalsePositive(!tgtCands.empty());
 	imp->ConvertTgtCand(tgtCands,rv);
 }
 
@@ -385,15 +490,18 @@ GetTargetCandidates(const std::vector<std::string>& src,
 										std::vector<StringWordAlignmentCand>& swa,
 										std::vector<StringWordAlignmentCand>& twa) const 
 {
+	if(!imp->MayContain(src)) return;
+
 	IPhrase f(src.size());
 	for(size_t i=0;i<src.size();++i) 
 		{
 		f[i]=imp->sv.index(src[i]);
-		if(f[i]==InvalidLabelId) return;
+		if(f[i]==InvalidLabelId) {imp->CheckFalsePositive(false);return;}
 		}
 	
 	TgtCands tgtCands;
 	imp->GetTargetCandidates(f,tgtCands);
+	imp->CheckFalsePositive(!tgtCands.empty());
 	imp->ConvertTgtCand(tgtCands,rv,swa,twa);
 }
 
@@ -428,7 +536,9 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
 		oft(out+".binphr.tgtdata"),
 		ofi(out+".binphr.idx"),
 		ofsv(out+".binphr.srcvoc"),
-		oftv(out+".binphr.tgtvoc");
+		oftv(out+".binphr.tgtvoc"),
+		ofb(out+".binphr.bloom"),
+		ofr(out+".binphr.reordering");
 	
 	if (PrintWordAlignment()){
 		ofn+=".wa";
@@ -445,6 +555,10 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
 	IPhrase currF;
 	TgtCands tgtCands;
 	std::vector<OFF_T> vo;
+	std::vector<UINT64> bloomKeys;
+	ReorderingTableReader *reordering=imp->reorderingTable ? new ReorderingTableReader(*imp->reorderingTable) : 0;
+	std::string prevKey;
+	size_t numReordered=0;
 	size_t lnc=0;
 	size_t numElement = NOT_FOUND; // 3=old format, 5=async format which include word alignment info
 	
@@ -491,6 +605,8 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
 		std::vector<std::string> wordVec = Tokenize(sourcePhraseString);
 		for (size_t i = 0 ; i < wordVec.size() ; ++i)
 			f.push_back(imp->sv.add(wordVec[i]));
+		if (imp->bloomFilterBits > 0 && f != currF)
+			bloomKeys.push_back(BloomFilter::GetKey(wordVec));
 		
 		wordVec = Tokenize(targetPhraseString);
 		for (size_t i = 0 ; i < wordVec.size() ; ++i)
@@ -544,6 +660,21 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
 			float tmp = scoreVector[i];
 			sc.push_back(((tmp>0.0)?tmp:(float)1.0e-38));
 		}
+
+		// reordering scores go after the translation scores, unchanged
+		if (reordering)
+		{
+			std::string key=ReorderingTableReader::MakeKey(sourcePhraseString,targetPhraseString);
+			if (key<prevKey)
+			{
+				std::stringstream strme;
+				strme << "Line " << lnc << ": to merge a reordering table, the phrase table has to be sorted with LC_ALL=C sort";
+				UserMessage::Add(strme.str());
+				abort();
+			}
+			prevKey=key;
+			if (reordering->Append(key,sc)) ++numReordered;
+		}
 		
 			
 		if(f.empty())
@@ -651,6 +782,26 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
 	imp->sv.Write(ofsv);
 	imp->tv.Write(oftv);
 
+	// a filter left over from an earlier binarization would drop phrases
+	if (imp->bloomFilterBits > 0)
+	{
+		imp->bloomFilter.Init(bloomKeys, imp->bloomFilterBits);
+		imp->bloomFilter.Save(ofb);
+	}
+	else if (FileExists(ofb))
+		remove(ofb.c_str());
+
+	if (reordering)
+	{
+		TRACE_ERR("phrase pairs with reordering scores: "<<numReordered<<" of "<<lnc<<"\n");
+		FILE *orf=fOpen(ofr.c_str(),"wb");
+		fWrite(orf,(UINT32) reordering->GetNumScores());
+		fClose(orf);
+		delete reordering;
+	}
+	else if (FileExists(ofr))
+		remove(ofr.c_str());
+
   return 1;
 }
 
@@ -16,6 +16,7 @@
 #include "TypeDef.h"
 #include "Util.h"
 #include "StaticData.h"
+#include "BloomFilter.h"
 
 namespace Moses
 {
@@ -44,6 +45,18 @@ public:
 	
 	void PrintWordAlignment(bool a);
 	bool PrintWordAlignment();
+
+	// bits per source phrase of a bloom filter written by Create(). 0 for none
+	void SetBloomFilterBits(size_t bitsPerPhrase);
+	// source phrases, checked before looking up the full source phrase
+	const BloomFilter& GetBloomFilter() const;
+
+	// lexical reordering table (f ||| e ||| scores), sorted like the phrase table, whose scores
+	// Create() appends to the scores of the same phrase pairs. 0 for none
+	void SetReorderingTable(std::istream* reorderingTable);
+	// number of lexical reordering scores after the translation scores of target candidates which
+	// have them. 0 if no reordering table was merged in
+	size_t GetNumReorderingScores() const;
 	
 
 	virtual ~PhraseDictionaryTree();
@@ -94,6 +107,9 @@ public:
 	public:
 		PrefixPtr(PPimp* x=0) : imp(x) {}
 		operator bool() const;
+		// order of the prefix tree nodes pointed to. Pointers to the same node,
+		// ie. reached by the same words, are equivalent. Requirement: both evaluate to true
+		bool operator<(const PrefixPtr& other) const;
 	};
 
 	// return pointer to root node
@@ -34,6 +34,8 @@ PhraseDictionaryTreeAdaptor::~PhraseDictionaryTreeAdaptor()
 
 void PhraseDictionaryTreeAdaptor::CleanUp() 
 {
+	if (imp->m_dict != NULL && imp->m_dict->GetBloomFilter().IsEnabled())
+		imp->m_dict->GetBloomFilter().Report(GetScoreProducerDescription());
 	imp->CleanUp();
 	MyBase::CleanUp();
 }
@@ -82,12 +84,14 @@ bool PhraseDictionaryTreeAdaptor::Load(const std::vector<FactorType> &input
 TargetPhraseCollection const* 
 PhraseDictionaryTreeAdaptor::GetTargetPhraseCollection(Phrase const &src) const
 {
+	ScopedLock lock(m_lock);
 	return imp->GetTargetPhraseCollection(src);
 }
 
 TargetPhraseCollection const* 
 PhraseDictionaryTreeAdaptor::GetTargetPhraseCollection(InputType const& src,WordsRange const &range) const
 {
+	ScopedLock lock(m_lock);
 	if(imp->m_rangeCache.empty())
 	{
 		return imp->GetTargetPhraseCollection(src.GetSubString(range));
@@ -98,16 +102,35 @@ PhraseDictionaryTreeAdaptor::GetTargetPhraseCollection(InputType const& src,Word
 	}
 }
 
+TargetPhraseCollection const* 
+PhraseDictionaryTreeAdaptor::ExtendLookup(InputType const& src,WordsRange const &range,PhraseDictionaryCursor &cursor) const
+{
+	{
+		ScopedLock lock(m_lock);
+		// confusion networks are looked up in InitializeForInput(). Without caching, only added phrases are looked up
+		if(imp->m_rangeCache.empty() && src.GetType()==SentenceInput
+			 && (imp->useCache || imp->m_cache.empty())
+			 && (cursor.m_endPos==NOT_FOUND || cursor.m_endPos<range.GetEndPos()))
+		{
+			return imp->ExtendLookup(src,range,cursor);
+		}
+	}
+	// not under the lock, this looks up the range with GetTargetPhraseCollection()
+	return MyBase::ExtendLookup(src,range,cursor);
+}
+
 void PhraseDictionaryTreeAdaptor::
 SetWeightTransModel(const std::vector<float> &weightT)
 {
 	CleanUp();
 	imp->m_weights=weightT;
+	imp->m_weightWP=StaticData::Instance().GetWeightWordPenalty();
 }
 
 void PhraseDictionaryTreeAdaptor::
 AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase) 
 {
+	ScopedLock lock(m_lock);
 	imp->AddEquivPhrase(source,targetPhrase);
 }
 void PhraseDictionaryTreeAdaptor::EnableCache()
@@ -121,6 +144,15 @@ void PhraseDictionaryTreeAdaptor::DisableCache()
 
 
 
+const ConfusionNetPathStats& PhraseDictionaryTreeAdaptor::GetPathStats() const
+{
+	return imp->pathStats;
+}
+
+size_t PhraseDictionaryTreeAdaptor::GetNumReorderingScores() const {
+	return imp->m_dict->GetNumReorderingScores();
+}
+
 size_t PhraseDictionaryTreeAdaptor::GetNumInputScores() const {
 	return imp->GetNumInputScores();
 }
@@ -6,6 +6,7 @@
 #include "TypeDef.h"
 #include "PhraseDictionaryMemory.h"
 #include "TargetPhraseCollection.h"
+#include "Thread.h"
 
 namespace Moses
 {
@@ -14,6 +15,7 @@ class Phrase;
 class PDTAimp;
 class WordsRange;
 class InputType;
+class ConfusionNetPathStats;
 
 /*** Implementation of a phrase table in a trie that is binarized and
  * stored on disk.
@@ -21,6 +23,8 @@ class InputType;
 class PhraseDictionaryTreeAdaptor : public PhraseDictionary {
 	typedef PhraseDictionary MyBase;
 	PDTAimp *imp;
+	//! serialises lookups, which read the file and fill the caches of imp
+	mutable Mutex m_lock;
 	friend class PDTAimp;
 	PhraseDictionaryTreeAdaptor();
 	PhraseDictionaryTreeAdaptor(const PhraseDictionaryTreeAdaptor&);
@@ -54,6 +58,9 @@ class PhraseDictionaryTreeAdaptor : public PhraseDictionary {
 	// returns null pointer if nothing found
 	TargetPhraseCollection const* GetTargetPhraseCollection(Phrase const &src) const;
 	TargetPhraseCollection const* GetTargetPhraseCollection(InputType const& src,WordsRange const & srcRange) const;
+	// extends the prefix tree node of cursor word by word. The bloom filter of the table isn't used here,
+	// as it only holds whole phrases and the prefix tree already tells when no phrase starts with the words
+	TargetPhraseCollection const* ExtendLookup(InputType const& src,WordsRange const & srcRange,PhraseDictionaryCursor &cursor) const;
 
 	// clean up temporary memory etc.
 	void CleanUp();
@@ -69,6 +76,12 @@ class PhraseDictionaryTreeAdaptor : public PhraseDictionary {
 	std::string GetScoreProducerDescription() const;
 	
 	size_t GetNumInputScores() const;
+
+	// lexical reordering scores merged into the target phrases by processPhraseTable, 0 if none
+	size_t GetNumReorderingScores() const;
+
+	// paths through the confusion networks translated so far
+	const ConfusionNetPathStats& GetPathStats() const;
 	
 };
 
@@ -61,6 +61,7 @@ class SentenceStats
 			m_numHyposDiscarded = 0;
 			m_numHyposEarlyDiscarded = 0;
 			m_numHyposNotBuilt = 0;
+			m_numLMStatesTruncated = 0;
 			m_timeCollectOpts = 0;
 			m_timeBuildHyp = 0;
 			m_timeEstimateScore = 0;
@@ -84,6 +85,14 @@ class SentenceStats
 		unsigned int GetNumHyposDiscarded() const {return m_numHyposDiscarded;}
 		unsigned int GetNumHyposEarlyDiscarded() const {return m_numHyposEarlyDiscarded;}
 		unsigned int GetNumHyposNotBuilt() const {return m_numHyposNotBuilt;}
+		unsigned int GetNumLMStatesTruncated() const {return m_numLMStatesTruncated;}
+		//! fraction of the hypotheses reaching a stack which were recombined
+		float GetRecombinationRate() const
+		{
+			size_t total = GetTotalHypos();
+			size_t notReached = m_numHyposNotBuilt + m_numHyposEarlyDiscarded + m_numHyposDiscarded;
+			return (total <= notReached) ? 0 : GetNumHyposRecombined() / (float) (total - notReached);
+		}
 		float GetTimeCollectOpts() const { return m_timeCollectOpts/(float)CLOCKS_PER_SEC; }
 		float GetTimeBuildHyp() const { return m_timeBuildHyp/(float)CLOCKS_PER_SEC; }
 		float GetTimeCalcLM() const { return m_timeCalcLM/(float)CLOCKS_PER_SEC; }
@@ -105,6 +114,7 @@ class SentenceStats
 		void AddPruning() {m_numHyposPruned++;}
 		void AddEarlyDiscarded() {m_numHyposEarlyDiscarded++;}
 		void AddNotBuilt() {m_numHyposNotBuilt++;}
+		void AddLMStateTruncated() {m_numLMStatesTruncated++;}
 		void AddDiscarded() {m_numHyposDiscarded++;}
 
 		void AddTimeCollectOpts( clock_t t ) { m_timeCollectOpts += t; }
@@ -128,6 +138,7 @@ class SentenceStats
 		unsigned int m_numHyposDiscarded;
 		unsigned int m_numHyposEarlyDiscarded;
 		unsigned int m_numHyposNotBuilt;
+		unsigned int m_numLMStatesTruncated; //! LM states with a shorter context than the n-gram order
 		clock_t m_timeCollectOpts;
 		clock_t m_timeBuildHyp;
 		clock_t m_timeEstimateScore;
@@ -151,7 +162,8 @@ inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
             << "           number not built = " << ss.GetNumHyposNotBuilt() << std::endl
             << "     number discarded early = " << ss.GetNumHyposEarlyDiscarded() << std::endl
             << "           number discarded = " << ss.GetNumHyposDiscarded() << std::endl
-            << "          number recombined = " << ss.GetNumHyposRecombined() << std::endl
+            << "          number recombined = " << ss.GetNumHyposRecombined() << " (" << (int)(100 * ss.GetRecombinationRate()) << "%)" << std::endl
+            << "    LM states w/ short ctxt = " << ss.GetNumLMStatesTruncated() << std::endl
             << "              number pruned = " << ss.GetNumHyposPruned() << std::endl
 
             << "time to collect opts    " << ss.GetTimeCollectOpts()   << " (" << (int)(100 * ss.GetTimeCollectOpts()/totalTime) << "%)" << std::endl
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "DecodeStepTranslation.h"
 #include "DecodeStepGeneration.h"
 #include "GenerationDictionary.h"
+#include "GenerationDictionaryBinary.h"
 #include "DummyScoreProducers.h"
 #include "StaticData.h"
 #include "Util.h"
@@ -38,6 +39,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "SentenceStats.h"
 #include "PhraseDictionaryTreeAdaptor.h"
 #include "UserMessage.h"
+#include "LoadFilter.h"
 #include "TranslationOption.h"
 #include "DecodeGraph.h"
 #include "InputFileStream.h"
@@ -74,9 +76,16 @@ StaticData::StaticData()
 ,m_onlyDistinctNBest(false)
 ,m_computeLMBackoffStats(false)
 ,m_factorDelimiter("|") // default delimiter between factors
+,m_lmCacheSize(0)
+,m_bloomFilterBits(0)
+,m_loadFilter(NULL)
 ,m_isAlwaysCreateDirectTranslationOption(false)
 ,m_sourceStartPosMattersForRecombination(false)
 ,m_numLinkParams(1)
+,m_optionThreads(DEFAULT_OPTION_THREADS)
+#ifdef WITH_THREADS
+,m_optionThreadPool(NULL)
+#endif
 {
   m_maxFactorIdx[0] = 0;  // source side
   m_maxFactorIdx[1] = 0;  // target side
@@ -186,9 +195,41 @@ bool StaticData::LoadData(Parameter *parameter)
 	  m_outputSearchGraphPB = false;
 #endif
 
+	// overlap reading and writing with decoding
+	SetBooleanParameter( &m_asyncIO, "async-io", false );
+
+	// skip lookups of phrases and n-grams which aren't in the models
+	m_bloomFilterBits = (m_parameter->GetParam("bloom-filter-bits").size() > 0)
+										? Scan<size_t>(m_parameter->GetParam("bloom-filter-bits")[0]) : DEFAULT_BLOOM_FILTER_BITS;
+
+	// parse text models on several threads while loading
+	m_loadThreads = (m_parameter->GetParam("load-threads").size() > 0)
+								? Scan<size_t>(m_parameter->GetParam("load-threads")[0]) : DEFAULT_LOAD_THREADS;
+#ifndef WITH_THREADS
+	if (m_loadThreads > 1)
+		TRACE_ERR("WARNING: load-threads requires moses to be configured with --enable-threads. Ignored" << endl);
+#endif
+
+	// look up the spans of a sentence on several threads
+	m_optionThreads = (m_parameter->GetParam("option-threads").size() > 0)
+								? Scan<size_t>(m_parameter->GetParam("option-threads")[0]) : DEFAULT_OPTION_THREADS;
+#ifdef WITH_THREADS
+	if (m_optionThreads > 1)
+	{
+		m_optionThreadPool = new ThreadPool(m_optionThreads);
+		VERBOSE(1, "Creating translation options on " << m_optionThreadPool->GetNumThreads() << " threads" << endl);
+	}
+#else
+	if (m_optionThreads > 1)
+		TRACE_ERR("WARNING: option-threads requires moses to be configured with --enable-threads. Ignored" << endl);
+#endif
+
 	// include feature names in the n-best list
 	SetBooleanParameter( &m_labeledNBestList, "labeled-n-best-list", true );
 
+	// n-best list in binary format, only read by mert
+	SetBooleanParameter( &m_binaryNBestList, "binary-n-best-list", false );
+
 	// include word alignment in the n-best list
 	SetBooleanParameter( &m_nBestIncludesAlignment, "include-alignment-in-n-best", false );
 
@@ -294,6 +335,9 @@ bool StaticData::LoadData(Parameter *parameter)
   m_translationOptionThreshold = (m_parameter->GetParam("translation-option-threshold").size() > 0) ?
     TransformScore(Scan<float>(m_parameter->GetParam("translation-option-threshold")[0]))
     : TransformScore(DEFAULT_TRANSLATION_OPTION_THRESHOLD);
+  m_confusionNetPathThreshold = (m_parameter->GetParam("confusion-net-path-threshold").size() > 0) ?
+    TransformScore(Scan<float>(m_parameter->GetParam("confusion-net-path-threshold")[0]))
+    : TransformScore(DEFAULT_CONFUSION_NET_PATH_THRESHOLD);
 
 	m_maxNoTransOptPerCoverage = (m_parameter->GetParam("max-trans-opt-per-coverage").size() > 0)
 				? Scan<size_t>(m_parameter->GetParam("max-trans-opt-per-coverage")[0]) : DEFAULT_MAX_TRANS_OPT_SIZE;
@@ -368,14 +412,28 @@ bool StaticData::LoadData(Parameter *parameter)
 		UserMessage::Add("invalid xml-input value, must be pass-through, exclusive, inclusive, or ignore");
 		return false;
 	}
+
+	// reading a sentence with xml markup scores its translation options with the LMs, which the decoder uses at the same time
+	if (m_asyncIO && m_xmlInputType != XmlPassThrough)
+	{
+		TRACE_ERR("WARNING: async-io can't be used with xml-input. Ignored" << endl);
+		m_asyncIO = false;
+	}
 	
 	if (!LoadLexicalReorderingModel()) return false;
+	if (!LoadFilterVocabulary()) return false;
 	if (!LoadLanguageModels()) return false;
 	if (!LoadGenerationTables()) return false;
 	if (!LoadPhraseTables()) return false;
+	if (!CheckMergedReorderingScores()) return false;
+	// only needed while loading
+	delete m_loadFilter;
+	m_loadFilter = NULL;
 	if (!LoadMapping()) return false;
+	if (!LoadVocabulary()) return false;
 
   m_scoreIndexManager.InitFeatureNames();
+	m_languageModel.SetStatefulFeatureFunctions(m_scoreIndexManager.GetStatefulFeatureFunctions());
 	if (m_parameter->GetParam("weight-file").size() > 0) {
 	  if (m_parameter->GetParam("weight-file").size() != 1) {
 	    UserMessage::Add(string("ERROR: weight-file takes a single parameter"));
@@ -412,7 +470,11 @@ void StaticData::SetBooleanParameter( bool *parameter, string parameterName, boo
 
 StaticData::~StaticData()
 {
+#ifdef WITH_THREADS
+	delete m_optionThreadPool;
+#endif
 	delete m_parameter;
+	delete m_loadFilter;
 
 	RemoveAllInColl(m_phraseDictionary);
 	RemoveAllInColl(m_generationDictionary);
@@ -421,12 +483,7 @@ StaticData::~StaticData()
 	RemoveAllInColl(m_reorderModels);
 	
 	// delete trans opt
-	map<std::pair<const DecodeGraph*, Phrase>, std::pair< TranslationOptionList*, clock_t > >::iterator iterCache;
-	for (iterCache = m_transOptCache.begin() ; iterCache != m_transOptCache.end() ; ++iterCache)
-	{
-		TranslationOptionList *transOptList = iterCache->second.first;
-		delete transOptList;
-	}
+	ClearTransOptCache();
 
 	// small score producers
 	delete m_distortionScoreProducer;
@@ -438,6 +495,39 @@ StaticData::~StaticData()
 
 }
 
+bool StaticData::CheckMergedReorderingScores() const
+{
+	for (size_t i = 0 ; i < m_reorderModels.size() ; ++i)
+	{
+		const LexicalReordering &model = *m_reorderModels[i];
+		if (!model.IsMergedIntoPhraseTable())
+			continue;
+
+		const PhraseDictionaryTreeAdaptor *phraseTable = NULL;
+		for (size_t j = 0 ; j < m_phraseDictionary.size() && phraseTable == NULL ; ++j)
+		{
+			const PhraseDictionaryTreeAdaptor *binaryTable = dynamic_cast<const PhraseDictionaryTreeAdaptor*>(m_phraseDictionary[j]);
+			if (binaryTable != NULL && binaryTable->GetFilePath() == model.GetFilePath())
+				phraseTable = binaryTable;
+		}
+		if (phraseTable == NULL)
+		{
+			UserMessage::Add("Lexical reordering scores are merged into " + model.GetFilePath()
+											+ ", which isn't loaded as a binary phrase table");
+			return false;
+		}
+		if (phraseTable->GetNumReorderingScores() != model.GetNumScoreComponents())
+		{
+			stringstream strme;
+			strme << "Phrase table " << model.GetFilePath() << " has " << phraseTable->GetNumReorderingScores()
+						<< " lexical reordering scores, but the model has " << model.GetNumScoreComponents() << " weights";
+			UserMessage::Add(strme.str());
+			return false;
+		}
+	}
+	return true;
+}
+
 bool StaticData::LoadLexicalReorderingModel()
 {
   std::cerr << "Loading lexical distortion models...\n";
@@ -588,18 +678,93 @@ bool StaticData::LoadLexicalReorderingModel()
 			std::cerr << " ...unknown type!\n";
 			return false;
 		}
+		if (!m_reorderModels.back()->IsLoaded())
+			return false;
 		//std::cerr << "\n";
 
 	} 
   return true;
 }
 
+bool StaticData::LoadFilterVocabulary()
+{
+	if (m_parameter->GetParam("filter-input").size() == 0)
+		return true;
+	// words of confusion networks and lattices can only be read once the number of input scores is known
+	if (m_inputType != SentenceInput)
+	{
+		TRACE_ERR("WARNING: filter-input only works with text input (inputtype 0). Ignored" << endl);
+		return true;
+	}
+
+	m_loadFilter = new LoadFilter();
+	if (!m_loadFilter->ReadInput(m_parameter->GetParam("filter-input")[0], m_inputFactorOrder, m_factorDelimiter, m_xmlInputType))
+		return false;
+
+	// target phrases given in the input can't be known in advance
+	if (m_xmlInputType == XmlExclusive || m_xmlInputType == XmlInclusive)
+	{
+		VERBOSE(1, "Not filtering language models and generation tables with xml-input" << endl);
+		m_loadFilter->DisableTargetFilter();
+		return true;
+	}
+
+	// the target words are those of the phrase pairs which can be used, and what can be generated from them
+	const vector<string> &translationVector = m_parameter->GetParam("ttable-file");
+	for(size_t currDict = 0 ; currDict < translationVector.size() && m_loadFilter->IsTargetFilterEnabled() ; currDict++)
+	{
+		vector<string>			token		= Tokenize(translationVector[currDict]);
+		vector<FactorType> 	input		= Tokenize<FactorType>(token[0], ",")
+												,output	= Tokenize<FactorType>(token[1], ",");
+		string filePath = token[3];
+		if (FileExists(filePath+".binphr.idx"))
+		{
+			VERBOSE(1, "Not filtering language models and generation tables with binary phrase table " << filePath << endl);
+			m_loadFilter->DisableTargetFilter();
+		}
+		else
+		{
+			if (!FileExists(filePath) && FileExists(filePath + ".gz"))
+				filePath += ".gz";
+			if (!m_loadFilter->ScanPhraseTable(filePath, input, output, m_factorDelimiter))
+				return false;
+		}
+	}
+
+	const vector<string> &generationVector = m_parameter->GetParam("generation-file");
+	for(size_t currDict = 0 ; currDict < generationVector.size() && m_loadFilter->IsTargetFilterEnabled() ; currDict++)
+	{
+		vector<string>			token		= Tokenize(generationVector[currDict]);
+		vector<FactorType> 	input		= Tokenize<FactorType>(token[0], ",")
+												,output	= Tokenize<FactorType>(token[1], ",");
+		string filePath = token[3];
+		if (FileExists(filePath + ".bingen"))
+		{
+			VERBOSE(1, "Not filtering language models with binary generation table " << filePath << endl);
+			m_loadFilter->DisableTargetFilter();
+		}
+		else
+		{
+			if (!FileExists(filePath) && FileExists(filePath + ".gz"))
+				filePath += ".gz";
+			if (!m_loadFilter->ScanGenerationTable(filePath, input, output))
+				return false;
+		}
+	}
+
+	IFVERBOSE(1)
+		PrintUserTime("Collected vocabulary for filtering");
+	return true;
+}
+
 bool StaticData::LoadLanguageModels()
 {
 	if (m_parameter->GetParam("lmodel-file").size() > 0)
 	{
 		// weights
 		vector<float> weightAll = Scan<float>(m_parameter->GetParam("weight-l"));
+		m_lmCacheSize = (m_parameter->GetParam("lmodel-cache-size").size() > 0)
+					? Scan<size_t>(m_parameter->GetParam("lmodel-cache-size")[0]) : DEFAULT_LM_CACHE_SIZE;
 		
 		for (size_t i = 0 ; i < weightAll.size() ; i++)
 		{
@@ -658,6 +823,7 @@ bool StaticData::LoadLanguageModels()
       	UserMessage::Add("no LM created. We probably don't have it compiled");
       	return false;
       }
+			lm->SetCacheSize(m_lmCacheSize);
 
 			m_languageModel.push_back(lm);
 		}
@@ -700,13 +866,20 @@ bool StaticData::LoadGenerationTables()
 			numFeatures = Scan<size_t>(token[2]);
 			filePath = token[3];
 
-			if (!FileExists(filePath) && FileExists(filePath + ".gz")) {
-				filePath += ".gz";
-			}
-
 			VERBOSE(1, filePath << endl);
 
-			m_generationDictionary.push_back(new GenerationDictionary(numFeatures, m_scoreIndexManager));
+			if (FileExists(filePath + ".bingen"))
+			{
+				VERBOSE(1, "using binary generation table" << endl);
+				m_generationDictionary.push_back(new GenerationDictionaryBinary(numFeatures, m_scoreIndexManager));
+			}
+			else
+			{
+				if (!FileExists(filePath) && FileExists(filePath + ".gz")) {
+					filePath += ".gz";
+				}
+				m_generationDictionary.push_back(new GenerationDictionary(numFeatures, m_scoreIndexManager));
+			}
 			assert(m_generationDictionary.back() && "could not create GenerationDictionary");
 			if (!m_generationDictionary.back()->Load(input
 																		, output
@@ -947,6 +1120,33 @@ bool StaticData::LoadMapping()
 	return true;
 }
 
+bool StaticData::LoadVocabulary()
+{
+	FactorCollection &factorCollection = FactorCollection::Instance();
+
+	const vector<string> &vocabVector = m_parameter->GetParam("vocabulary-file");
+	for(size_t i=0; i<vocabVector.size(); i++) 
+	{
+		vector<string>	token		= Tokenize(vocabVector[i]);
+		if (token.size() != 2)
+		{
+			UserMessage::Add("Expected format 'FACTOR-TYPE filePath' for vocabulary-file");
+			return false;
+		}
+		if (!FileExists(token[1]))
+		{
+			UserMessage::Add("Vocabulary file " + token[1] + " does not exist");
+			return false;
+		}
+		factorCollection.LoadVocab(Output, Scan<FactorType>(token[0]), token[1]);
+	}
+
+	// the models are loaded, only the words of the input are added from here on
+	factorCollection.Freeze();
+	VERBOSE(2,"Vocabulary size after loading models: " << factorCollection.GetSize() << endl);
+	return true;
+}
+
 void StaticData::CleanUpAfterSentenceProcessing() const
 {
 	for(size_t i=0;i<m_phraseDictionary.size();++i)
@@ -998,9 +1198,63 @@ void StaticData::SetWeightsForScoreProducer(const ScoreProducer* sp, const std::
     m_allWeights[i] = *weightIter++;
 }
 
+bool StaticData::SetAllWeights(const vector<float> &weights)
+{
+	if (weights.size() != m_scoreIndexManager.GetTotalNumberOfScores())
+	{
+		stringstream strme;
+		strme << "Got " << weights.size() << " weights, but there are "
+					<< m_scoreIndexManager.GetTotalNumberOfScores() << " score components";
+		UserMessage::Add(strme.str());
+		return false;
+	}
+	if (weights == m_allWeights)
+		return true;
+
+	m_allWeights = weights;
+
+	// copies of single weights
+	m_weightDistortion	= weights[m_scoreIndexManager.GetBeginIndex(m_distortionScoreProducer->GetScoreBookkeepingID())];
+	m_weightWordPenalty	= weights[m_scoreIndexManager.GetBeginIndex(m_wpProducer->GetScoreBookkeepingID())];
+	m_weightUnknownWord	= weights[m_scoreIndexManager.GetBeginIndex(m_unknownWordPenaltyProducer->GetScoreBookkeepingID())];
+	LMList::const_iterator iterLM;
+	for (iterLM = m_languageModel.begin() ; iterLM != m_languageModel.end() ; ++iterLM)
+	{
+		LanguageModel *lm = *iterLM;
+		lm->SetWeight(weights[m_scoreIndexManager.GetBeginIndex(lm->GetScoreBookkeepingID())]);
+	}
+
+	// weighted scores of the phrase tables, after the word penalty & LM weights they include
+	for (size_t i = 0 ; i < m_phraseDictionary.size() ; ++i)
+	{
+		const size_t id = m_phraseDictionary[i]->GetScoreBookkeepingID();
+		vector<float> weightT(weights.begin() + m_scoreIndexManager.GetBeginIndex(id)
+												, weights.begin() + m_scoreIndexManager.GetEndIndex(id));
+		m_phraseDictionary[i]->SetWeightTransModel(weightT);
+	}
+
+	// cached translation options have future scores under the old weights
+	ClearTransOptCache();
+
+	VERBOSE(2, "Weights changed" << endl);
+	return true;
+}
+
+void StaticData::ClearTransOptCache() const
+{
+	std::map<std::pair<const DecodeGraph*, Phrase>, std::pair<TranslationOptionList*,clock_t> >::iterator iter;
+	for (iter = m_transOptCache.begin() ; iter != m_transOptCache.end() ; ++iter)
+	{
+		TranslationOptionList *transOptList = iter->second.first;
+		delete transOptList;
+	}
+	m_transOptCache.clear();
+}
+
 const TranslationOptionList* StaticData::FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const
 {
 	std::pair<const DecodeGraph*, Phrase> key(&decodeGraph, sourcePhrase);
+	ScopedLock lock(m_transOptCacheLock);
 	
 	std::map<std::pair<const DecodeGraph*, Phrase>, std::pair<TranslationOptionList*,clock_t> >::iterator iter
 			= m_transOptCache.find(key);
@@ -1046,9 +1300,11 @@ void StaticData::ReduceTransOptCache() const
 void StaticData::AddTransOptListToCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase, const TranslationOptionList &transOptList) const
 {
 	std::pair<const DecodeGraph*, Phrase> key(&decodeGraph, sourcePhrase);
+	ScopedLock lock(m_transOptCacheLock);
+	if (m_transOptCache.find(key) != m_transOptCache.end())
+		return;
 	TranslationOptionList* storedTransOptList = new TranslationOptionList(transOptList);
 	m_transOptCache[key] = make_pair( storedTransOptList, clock() );
-	ReduceTransOptCache();
 }
 
 }
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "SentenceStats.h"
 #include "DecodeGraph.h"
 #include "TranslationOptionList.h"
+#include "Thread.h"
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -51,6 +52,7 @@ class DistortionScoreProducer;
 class WordPenaltyProducer;
 class DecodeStep;
 class UnknownWordPenaltyProducer;
+class LoadFilter;
 
 /** Contains global variables and contants */
 class StaticData
@@ -75,6 +77,7 @@ protected:
 		m_beamWidth,
 		m_earlyDiscardingThreshold,
 		m_translationOptionThreshold,
+		m_confusionNetPathThreshold,
 		m_weightDistortion, 
 		m_weightWordPenalty, 
 		m_wordDeletionWeight,
@@ -100,6 +103,7 @@ protected:
 	
 	std::string									m_nBestFilePath;
 	bool                        m_fLMsLoaded, m_labeledNBestList,m_nBestIncludesAlignment;
+	bool                        m_binaryNBestList; //! write n-best list in binary format for mert
 	/***
 	 * false = treat unknown words as unknowns, and translate them as themselves;
 	 * true = drop (ignore) them
@@ -144,11 +148,22 @@ protected:
 	bool m_useTransOptCache; //! flag indicating, if the persistent translation option cache should be used
 	mutable std::map<std::pair<const DecodeGraph*, Phrase>, pair<TranslationOptionList*,clock_t> > m_transOptCache; //! persistent translation option cache
 	size_t m_transOptCacheMaxSize; //! maximum size for persistent translation option cache
+	mutable Mutex m_transOptCacheLock; //! translation options of a sentence may be created on several threads
+	size_t m_lmCacheSize; //! number of n-gram scores cached by each LM during a sentence
+	size_t m_bloomFilterBits; //! bits per entry of the bloom filters in front of memory phrase tables and internal LMs
+	LoadFilter *m_loadFilter; //! vocabulary the models are filtered to while loading. NULL if not filtering
 
 	mutable const InputType* m_input;  //! holds reference to current sentence
 	bool m_isAlwaysCreateDirectTranslationOption;
 	//! constructor. only the 1 static variable can be created
 
+	bool m_asyncIO; //! read input and write output on separate threads
+	size_t m_loadThreads; //! number of threads parsing each text model file
+	size_t m_optionThreads; //! number of threads creating the translation options of a sentence
+#ifdef WITH_THREADS
+	ThreadPool *m_optionThreadPool; //! NULL if created on the decoding thread
+#endif
+
 	bool m_outputWordGraph; //! whether to output word graph
         bool m_outputSearchGraph; //! whether to output search graph
 #ifdef HAVE_PROTOBUF
@@ -166,6 +181,8 @@ protected:
 	 * load all language models as specified in ini file
 	 */
 	bool LoadLanguageModels();
+	//! collect the vocabulary of the text given with filter-input, and of its possible translations
+	bool LoadFilterVocabulary();
 	/***
 	 * load not only the main phrase table but also any auxiliary tables that depend on which features are being used
 	 * (eg word-deletion, word-insertion tables)
@@ -176,6 +193,10 @@ protected:
 	//! load decoding steps
 	bool LoadMapping();
 	bool LoadLexicalReorderingModel();
+	//! lexical reordering scores merged into a phrase table must come with a loaded binary phrase table, 1 score per weight
+	bool CheckMergedReorderingScores() const;
+	//! add optional word lists to the vocabulary, then freeze it
+	bool LoadVocabulary();
 	
 public:
 
@@ -201,6 +222,13 @@ public:
 	{
 		return s_instance.LoadData(parameter);
 	}
+	/** change the weights of the static instance, between sentences. This function is required
+		* as SetAllWeights() is not const
+		*/
+	static bool SetAllWeightsStatic(const std::vector<float> &weights)
+	{
+		return s_instance.SetAllWeights(weights);
+	}
 
 	/** Main function to load everything.
 	 * Also initialize the Parameter object
@@ -327,6 +355,10 @@ public:
 	{
 		return m_translationOptionThreshold;
 	}
+	float GetConfusionNetPathThreshold() const
+	{
+		return m_confusionNetPathThreshold;
+	}
 	//! returns the total number of score components across all types, all factors
 	size_t GetTotalScoreComponents() const
 	{
@@ -390,6 +422,10 @@ public:
 	{
 		return m_nBestIncludesAlignment;
 	}
+	bool IsBinaryNBestList() const
+	{
+		return m_binaryNBestList;
+	}
 	size_t GetNumLinkParams() const 
 	{
 			return m_numLinkParams;
@@ -399,6 +435,20 @@ public:
 		return m_parameter->GetParam("description");
 	}
 
+	size_t GetLMCacheSize() const
+	{
+		return m_lmCacheSize;
+	}
+	size_t GetBloomFilterBits() const
+	{
+		return m_bloomFilterBits;
+	}
+	//! only non-NULL while the models are loaded, and the filter-input option is used
+	const LoadFilter *GetLoadFilter() const
+	{
+		return m_loadFilter;
+	}
+
 	// for mert
 	size_t GetNBestSize() const
 	{
@@ -421,9 +471,26 @@ public:
 	}
 	bool GetOutputWordGraph() const
 	{ return m_outputWordGraph; }
+	bool UseAsyncIO() const
+	{ return m_asyncIO; }
+	size_t GetLoadThreads() const
+	{ return m_loadThreads; }
+	size_t GetOptionThreads() const
+	{ return m_optionThreads; }
+#ifdef WITH_THREADS
+	//! threads creating the translation options of a sentence, with the span lookups of each start position as 1 task. NULL if not used
+	ThreadPool *GetOptionThreadPool() const
+	{ return m_optionThreadPool; }
+#endif
 
 	//! Sets the global score vector weights for a given ScoreProducer.
 	void SetWeightsForScoreProducer(const ScoreProducer* sp, const std::vector<float>& weights);
+	/** change all weights of a loaded decoder, taking effect from the next sentence.
+	 * Recalculates what was precomputed with the old weights: weighted phrase table scores
+	 * and their table-limit ordering, and the translation option cache.
+	 * Returns false if weights doesn't have 1 weight per score component
+	 */
+	bool SetAllWeights(const std::vector<float> &weights);
 	InputTypeEnum GetInputType() const {return m_inputType;}
 	SearchAlgorithm GetSearchAlgorithm() const {return m_searchAlgorithm;}
 	size_t GetNumInputScores() const {return m_numInputScores;}
@@ -466,8 +533,11 @@ public:
 
 	bool GetUseTransOptCache() const { return m_useTransOptCache; }
 
+	//! thread safe. Keeps an existing entry for the same phrase, which may have been added by another thread
 	void AddTransOptListToCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase, const TranslationOptionList &transOptList) const;
+	//! evict least recently used entries once the cache is full. Not while translation options are created
 	void ReduceTransOptCache() const;
+	void ClearTransOptCache() const;
 
 	const TranslationOptionList* FindTransOptListInCache(const DecodeGraph &decodeGraph, const Phrase &sourcePhrase) const;
 };
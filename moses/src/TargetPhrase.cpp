@@ -42,7 +42,7 @@ bool TargetPhrase::printalign=StaticData::Instance().PrintAlignmentInfo();
 //bool TargetPhrase::printalign;
 
 TargetPhrase::TargetPhrase(FactorDirection direction)
-	:Phrase(direction),m_transScore(0.0), m_ngramScore(0.0), m_fullScore(0.0), m_sourcePhrase(0)
+	:Phrase(direction),m_transScore(0.0), m_ngramScore(0.0), m_fullScore(0.0), m_lmScore(0.0), m_hasLMScores(false), m_sourcePhrase(0)
 {
 		wordalignflag=StaticData::Instance().UseAlignmentInfo();
 		printalign=StaticData::Instance().PrintAlignmentInfo();
@@ -50,7 +50,8 @@ TargetPhrase::TargetPhrase(FactorDirection direction)
 
 void TargetPhrase::SetScore()
 { // used when creating translations of unknown words:
-	m_transScore = m_ngramScore = 0;	
+	m_transScore = m_ngramScore = m_lmScore = 0;	
+	m_hasLMScores = false;
 	m_fullScore = - StaticData::Instance().GetWeightWordPenalty();	
 }
 
@@ -131,31 +132,60 @@ void TargetPhrase::SetScore(const ScoreProducer* translationScoreProducer,
 	m_transScore = std::inner_product(scoreVector.begin(), scoreVector.end(), weightT.begin(), 0.0f);
 	m_scoreBreakdown.PlusEquals(translationScoreProducer, scoreVector);
 	
+	CalcFullScore(weightWP, languageModels);
+}
+
+void TargetPhrase::CalcFullScore(float weightWP, const LMList &languageModels)
+{
   // Replicated from TranslationOptions.cpp
-	float totalFutureScore = 0;
-	float totalNgramScore  = 0;
-	float totalFullScore   = 0;
-	
+	m_lmFullScores.assign(languageModels.size(), 0.0f);
+
+	size_t lmIndex = 0;
 	LMList::const_iterator lmIter;
-	for (lmIter = languageModels.begin(); lmIter != languageModels.end(); ++lmIter)
+	for (lmIter = languageModels.begin(); lmIter != languageModels.end(); ++lmIter, ++lmIndex)
 	{
 		const LanguageModel &lm = **lmIter;
 		
 		if (lm.Useable(*this))
 		{ // contains factors used by this LM
-			const float weightLM = lm.GetWeight();
 			float fullScore, nGramScore;
 			
-			lm.CalcScore(*this, fullScore, nGramScore);
+			{
+				ScopedLock lock(lm.GetScoreLock());
+				lm.CalcScore(*this, fullScore, nGramScore);
+			}
 			m_scoreBreakdown.Assign(&lm, nGramScore);
-			
+			m_lmFullScores[lmIndex] = fullScore;
+		}
+	}
+	m_hasLMScores = true;
+
+	WeightLMScores(weightWP, languageModels);
+}
+
+void TargetPhrase::WeightLMScores(float weightWP, const LMList &languageModels)
+{
+	float totalFutureScore = 0;
+	float totalNgramScore  = 0;
+	float totalFullScore   = 0;
+
+	size_t lmIndex = 0;
+	LMList::const_iterator lmIter;
+	for (lmIter = languageModels.begin(); lmIter != languageModels.end(); ++lmIter, ++lmIndex)
+	{
+		const LanguageModel &lm = **lmIter;
+
+		if (lm.Useable(*this))
+		{
+			const float weightLM = lm.GetWeight();
+
 			// total LM score so far
-			totalNgramScore  += nGramScore * weightLM;
-			totalFullScore   += fullScore * weightLM;
-			
+			totalNgramScore  += m_scoreBreakdown.GetScoreForProducer(&lm) * weightLM;
+			totalFullScore   += m_lmFullScores[lmIndex] * weightLM;
 		}
 	}
   m_ngramScore = totalNgramScore;
+	m_lmScore = totalFullScore;
 	
 	m_fullScore = m_transScore + totalFutureScore + totalFullScore
 		- (this->GetSize() * weightWP);	 // word penalty
@@ -172,11 +202,20 @@ void TargetPhrase::SetWeights(const ScoreProducer* translationScoreProducer, con
 	*/
 
 	m_transScore = m_scoreBreakdown.PartialInnerProduct(translationScoreProducer, weightT);
+
+	// the LM and word penalty weights may have changed too. The LM scores themselves don't depend on the weights
+	const StaticData &staticData = StaticData::Instance();
+	if (m_hasLMScores && m_lmFullScores.size() == staticData.GetAllLM().size())
+		WeightLMScores(staticData.GetWeightWordPenalty(), staticData.GetAllLM());
+	else
+		CalcFullScore(staticData.GetWeightWordPenalty(), staticData.GetAllLM());
 }
 
 void TargetPhrase::ResetScore()
 {
-	m_fullScore = m_ngramScore = 0;
+	m_fullScore = m_ngramScore = m_lmScore = 0;
+	m_hasLMScores = false;
+	m_lmFullScores.clear();
 	m_scoreBreakdown.ZeroAll();
 }
 
@@ -190,6 +229,7 @@ TargetPhrase *TargetPhrase::MergeNext(const TargetPhrase &inputPhrase) const
 	// ok, merge
 	TargetPhrase *clone				= new TargetPhrase(*this);
 	clone->m_sourcePhrase = m_sourcePhrase;
+	clone->InvalidateLMScores();
 	int currWord = 0;
 	const size_t len = GetSize();
 	for (size_t currPos = 0 ; currPos < len ; currPos++)
@@ -49,14 +49,23 @@ class TargetPhrase: public Phrase
 protected:
 	float m_transScore, m_ngramScore, m_fullScore;
 	//float m_ngramScore, m_fullScore;
+	float m_lmScore; //! weighted LM score of all n-grams in the phrase, including those without full context
+	bool m_hasLMScores; //! m_lmScore, m_ngramScore and the LM scores in m_scoreBreakdown are for the current words
 	ScoreComponentCollection m_scoreBreakdown;
+	Scores m_lmFullScores; //! unweighted LM score of all n-grams in the phrase, for each LM of the list. The n-gram scores are in m_scoreBreakdown
 	AlignmentPair m_alignmentPair;
 
 	// in case of confusion net, ptr to source phrase
 	Phrase const* m_sourcePhrase; 
+	Scores m_reorderingScores; //! lexical reordering scores merged into the phrase table, if any
 
 	static bool wordalignflag;
 	static bool printalign;
+
+	//! LM scores, and the full score from them, m_transScore and the word penalty
+	void CalcFullScore(float weightWP, const LMList &languageModels);
+	//! weighted LM scores and the full score, from the unweighted LM scores already calculated
+	void WeightLMScores(float weightWP, const LMList &languageModels);
 	
 public:
 		TargetPhrase(FactorDirection direction=Output);
@@ -98,6 +107,7 @@ public:
 	
 	// used when creating translations of unknown words:
 	void ResetScore();
+	//! recalculate the weighted scores with new weights, from the scores already in the score breakdown
 	void SetWeights(const ScoreProducer*, const std::vector<float> &weightT);
 
 	TargetPhrase *MergeNext(const TargetPhrase &targetPhrase) const;
@@ -121,6 +131,29 @@ public:
   {
     return m_fullScore;
   }
+
+	/** whether the LM scores computed when the phrase was scored still hold.
+	 * Saves scoring the phrase again when a translation option is made from it
+	 */
+	bool HasLMScores() const
+	{
+		return m_hasLMScores;
+	}
+	//! call after changing the words
+	void InvalidateLMScores()
+	{
+		m_hasLMScores = false;
+	}
+	//! weighted LM score of all n-grams in the phrase
+	float GetLMScore() const
+	{
+		return m_lmScore;
+	}
+	//! weighted LM score of the n-grams with full context
+	float GetNGramScore() const
+	{
+		return m_ngramScore;
+	}
 	inline const ScoreComponentCollection &GetScoreBreakdown() const
 	{
 		return m_scoreBreakdown;
@@ -135,6 +168,15 @@ public:
 	{
 		return m_sourcePhrase;
 	}
+	//! lexical reordering scores of the phrase pair, log-transformed. Empty unless merged into the phrase table
+	const Scores &GetReorderingScores() const
+	{
+		return m_reorderingScores;
+	}
+	void SetReorderingScores(const Scores &scores)
+	{
+		m_reorderingScores = scores;
+	}
 	AlignmentPair &GetAlignmentPair()
 	{
 		return m_alignmentPair;
@@ -33,6 +33,7 @@ class TargetPhraseCollection
 {
 protected:
 	std::vector<TargetPhrase*> m_collection;
+	bool m_ownsPhrases; //! whether the target phrases are deleted with the collection
 	
 public:	
 	// iters
@@ -44,8 +45,16 @@ public:
 	const_iterator begin() const { return m_collection.begin(); }
 	const_iterator end() const { return m_collection.end(); }
 	
+	TargetPhraseCollection()
+	:m_ownsPhrases(true)
+	{}
+	//! \param ownsPhrases false if the target phrases are stored elsewhere, eg. in a phrase table's array
+	explicit TargetPhraseCollection(bool ownsPhrases)
+	:m_ownsPhrases(ownsPhrases)
+	{}
 	~TargetPhraseCollection()
 	{
+		if (m_ownsPhrases)
 			RemoveAllInColl(m_collection);
 	}
 
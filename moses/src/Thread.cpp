@@ -0,0 +1,138 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "Thread.h"
+#include "Util.h"
+
+namespace Moses
+{
+#ifdef WITH_THREADS
+
+void *Thread::RunThread(void *thread)
+{
+	static_cast<Thread*>(thread)->Run();
+	return NULL;
+}
+
+Thread::~Thread()
+{
+	Join();
+}
+
+bool Thread::Start()
+{
+	if (m_running)
+		return true;
+	m_running = (pthread_create(&m_thread, NULL, &Thread::RunThread, this) == 0);
+	return m_running;
+}
+
+void Thread::Join()
+{
+	if (!m_running)
+		return;
+	pthread_join(m_thread, NULL);
+	m_running = false;
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+:m_tasks(NULL)
+,m_next(0)
+,m_numDone(0)
+,m_stop(false)
+{
+	for (size_t i = 1 ; i < numThreads ; ++i)
+	{
+		Worker *worker = new Worker(*this);
+		if (!worker->Start())
+		{
+			// any workers already running will do
+			delete worker;
+			break;
+		}
+		m_workers.push_back(worker);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		ScopedLock lock(m_mutex);
+		m_stop = true;
+		m_changed.Broadcast();
+	}
+	RemoveAllInColl(m_workers);
+}
+
+bool ThreadPool::RunNext()
+{
+	Task *task;
+	{
+		ScopedLock lock(m_mutex);
+		if (m_tasks == NULL || m_next >= m_tasks->size())
+			return false;
+		task = (*m_tasks)[m_next++];
+	}
+
+	task->Run();
+
+	ScopedLock lock(m_mutex);
+	if (++m_numDone == m_tasks->size())
+		m_done.Broadcast();
+	return true;
+}
+
+void ThreadPool::Work()
+{
+	while (true)
+	{
+		{
+			ScopedLock lock(m_mutex);
+			while (!m_stop && (m_tasks == NULL || m_next >= m_tasks->size()))
+				m_changed.Wait(m_mutex);
+			if (m_stop)
+				return;
+		}
+		RunNext();
+	}
+}
+
+void ThreadPool::Run(std::vector<Task*> &tasks)
+{
+	{
+		ScopedLock lock(m_mutex);
+		m_tasks = &tasks;
+		m_next = m_numDone = 0;
+		m_changed.Broadcast();
+	}
+
+	while (RunNext())
+		;
+
+	ScopedLock lock(m_mutex);
+	while (m_numDone < tasks.size())
+		m_done.Wait(m_mutex);
+	m_tasks = NULL;
+}
+
+#endif
+}
+
@@ -0,0 +1,381 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "TypeDef.h"
+
+#ifdef WITH_THREADS
+#include <pthread.h>
+#endif
+
+namespace Moses
+{
+
+/** thin wrapper around a pthread mutex.
+ * Compiles to nothing unless moses is configured with --enable-threads,
+ * so single-threaded builds pay nothing for the locking.
+ */
+class Mutex
+{
+	friend class Condition;
+
+protected:
+#ifdef WITH_THREADS
+	pthread_mutex_t m_mutex;
+#endif
+
+	// not copyable
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+
+public:
+	Mutex()
+	{
+#ifdef WITH_THREADS
+		pthread_mutex_init(&m_mutex, NULL);
+#endif
+	}
+	~Mutex()
+	{
+#ifdef WITH_THREADS
+		pthread_mutex_destroy(&m_mutex);
+#endif
+	}
+	void Lock()
+	{
+#ifdef WITH_THREADS
+		pthread_mutex_lock(&m_mutex);
+#endif
+	}
+	void Unlock()
+	{
+#ifdef WITH_THREADS
+		pthread_mutex_unlock(&m_mutex);
+#endif
+	}
+};
+
+//! holds a mutex for the lifetime of the object
+class ScopedLock
+{
+protected:
+	Mutex &m_mutex;
+
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+
+public:
+	explicit ScopedLock(Mutex &mutex)
+	:m_mutex(mutex)
+	{
+		m_mutex.Lock();
+	}
+	~ScopedLock()
+	{
+		m_mutex.Unlock();
+	}
+};
+
+/** thin wrapper around a pthread read-write lock, for data which is mostly read by several
+ * threads, eg. caches. Like Mutex, compiles to nothing without --enable-threads
+ */
+class ReadWriteLock
+{
+protected:
+#ifdef WITH_THREADS
+	pthread_rwlock_t m_lock;
+#endif
+
+	ReadWriteLock(const ReadWriteLock&);
+	ReadWriteLock& operator=(const ReadWriteLock&);
+
+public:
+	ReadWriteLock()
+	{
+#ifdef WITH_THREADS
+		pthread_rwlock_init(&m_lock, NULL);
+#endif
+	}
+	~ReadWriteLock()
+	{
+#ifdef WITH_THREADS
+		pthread_rwlock_destroy(&m_lock);
+#endif
+	}
+	void ReadLock()
+	{
+#ifdef WITH_THREADS
+		pthread_rwlock_rdlock(&m_lock);
+#endif
+	}
+	void WriteLock()
+	{
+#ifdef WITH_THREADS
+		pthread_rwlock_wrlock(&m_lock);
+#endif
+	}
+	void Unlock()
+	{
+#ifdef WITH_THREADS
+		pthread_rwlock_unlock(&m_lock);
+#endif
+	}
+};
+
+//! holds a read-write lock for reading for the lifetime of the object
+class ScopedReadLock
+{
+protected:
+	ReadWriteLock &m_lock;
+
+	ScopedReadLock(const ScopedReadLock&);
+	ScopedReadLock& operator=(const ScopedReadLock&);
+
+public:
+	explicit ScopedReadLock(ReadWriteLock &lock)
+	:m_lock(lock)
+	{
+		m_lock.ReadLock();
+	}
+	~ScopedReadLock()
+	{
+		m_lock.Unlock();
+	}
+};
+
+//! holds a read-write lock for writing for the lifetime of the object
+class ScopedWriteLock
+{
+protected:
+	ReadWriteLock &m_lock;
+
+	ScopedWriteLock(const ScopedWriteLock&);
+	ScopedWriteLock& operator=(const ScopedWriteLock&);
+
+public:
+	explicit ScopedWriteLock(ReadWriteLock &lock)
+	:m_lock(lock)
+	{
+		m_lock.WriteLock();
+	}
+	~ScopedWriteLock()
+	{
+		m_lock.Unlock();
+	}
+};
+
+#ifdef WITH_THREADS
+
+//! condition variable, used together with a Mutex
+class Condition
+{
+protected:
+	pthread_cond_t m_cond;
+
+	Condition(const Condition&);
+	Condition& operator=(const Condition&);
+
+public:
+	Condition()
+	{
+		pthread_cond_init(&m_cond, NULL);
+	}
+	~Condition()
+	{
+		pthread_cond_destroy(&m_cond);
+	}
+	//! mutex must be locked by the caller
+	void Wait(Mutex &mutex)
+	{
+		pthread_cond_wait(&m_cond, &mutex.m_mutex);
+	}
+	void Signal()
+	{
+		pthread_cond_signal(&m_cond);
+	}
+	void Broadcast()
+	{
+		pthread_cond_broadcast(&m_cond);
+	}
+};
+
+/** base class for a thread of execution.
+ * Derived classes implement Run(), which is called on the new thread by Start()
+ */
+class Thread
+{
+protected:
+	pthread_t m_thread;
+	bool m_running;
+
+	static void *RunThread(void *thread);
+
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+
+public:
+	Thread()
+	:m_running(false)
+	{}
+	virtual ~Thread();
+
+	//! create the thread. Returns false if the system wouldn't give us one
+	bool Start();
+	//! wait for Run() to return
+	void Join();
+	bool IsRunning() const
+	{
+		return m_running;
+	}
+
+	virtual void Run() = 0;
+};
+
+/** FIFO queue of fixed capacity shared between threads.
+ * Push() blocks while the queue is full and Pop() while it is empty,
+ * so a fast producer cannot run arbitrarily far ahead of the consumer
+ */
+template<typename T>
+class BoundedQueue
+{
+protected:
+	std::deque<T> m_queue;
+	size_t m_capacity;
+	Mutex m_mutex;
+	Condition m_notEmpty, m_notFull;
+
+public:
+	explicit BoundedQueue(size_t capacity)
+	:m_capacity(capacity)
+	{}
+
+	void Push(const T &item)
+	{
+		ScopedLock lock(m_mutex);
+		while (m_queue.size() >= m_capacity)
+			m_notFull.Wait(m_mutex);
+		m_queue.push_back(item);
+		m_notEmpty.Signal();
+	}
+	T Pop()
+	{
+		ScopedLock lock(m_mutex);
+		while (m_queue.empty())
+			m_notEmpty.Wait(m_mutex);
+		T item = m_queue.front();
+		m_queue.pop_front();
+		m_notFull.Signal();
+		return item;
+	}
+};
+
+/** fixed set of threads which run batches of tasks.
+ * The threads are started once and wait for work between batches, so that
+ * a batch can be small, eg. the work of a single sentence
+ */
+class ThreadPool
+{
+public:
+	//! unit of work of a batch
+	class Task
+	{
+	public:
+		virtual ~Task() {}
+		virtual void Run() = 0;
+	};
+
+protected:
+	class Worker : public Thread
+	{
+	protected:
+		ThreadPool &m_pool;
+	public:
+		explicit Worker(ThreadPool &pool)
+		:m_pool(pool)
+		{}
+		~Worker()
+		{
+			Join();
+		}
+		void Run()
+		{
+			m_pool.Work();
+		}
+	};
+
+	std::vector<Worker*> m_workers;
+	std::vector<Task*> *m_tasks; //! current batch, NULL between batches
+	size_t m_next, m_numDone; //! of the tasks in the current batch
+	bool m_stop;
+	Mutex m_mutex;
+	Condition m_changed, m_done;
+
+	//! run next task of the current batch. false if all have been handed out
+	bool RunNext();
+	void Work();
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+public:
+	//! numThreads includes the thread calling Run(), which works on the tasks too
+	explicit ThreadPool(size_t numThreads);
+	~ThreadPool();
+
+	//! number of threads working on a batch, including the caller of Run()
+	size_t GetNumThreads() const
+	{
+		return m_workers.size() + 1;
+	}
+	/** run all tasks, in any order and on any thread, and return when they are done.
+	 * Only one batch at a time, Run() mustn't be called from several threads
+	 */
+	void Run(std::vector<Task*> &tasks);
+};
+
+#endif
+
+/** full memory barrier. Call before publishing a pointer to a newly
+ * constructed object to readers that do not take a lock
+ */
+inline void MemoryFence()
+{
+#if defined(WITH_THREADS) && defined(__GNUC__)
+	__sync_synchronize();
+#endif
+}
+
+/** increment a counter which is shared between threads without taking a lock,
+ * eg. statistics kept by lookups
+ */
+inline void AtomicIncrement(volatile size_t &counter)
+{
+#if defined(WITH_THREADS) && defined(__GNUC__)
+	__sync_fetch_and_add(&counter, 1);
+#else
+	++counter;
+#endif
+}
+
+}
@@ -108,6 +108,8 @@ TranslationOption::TranslationOption(const TranslationOption &copy, const WordsR
 void TranslationOption::MergeNewFeatures(const Phrase& phrase, const ScoreComponentCollection& score, const std::vector<FactorType>& featuresToAdd)
 {
 	assert(phrase.GetSize() == m_targetPhrase.GetSize());
+	// words, or the LM scores in the score breakdown, change
+	m_targetPhrase.InvalidateLMScores();
 	if (featuresToAdd.size() == 1) {
 		m_targetPhrase.MergeFactors(phrase, featuresToAdd[0]);
 	} else if (featuresToAdd.empty()) {
@@ -144,7 +146,23 @@ void TranslationOption::CalcScore()
 
 	const LMList &allLM = StaticData::Instance().GetAllLM();
 
-	allLM.CalcScore(GetTargetPhrase(), retFullScore, ngramScore, &m_scoreBreakdown);
+	const TargetPhrase &targetPhrase = GetTargetPhrase();
+	if (targetPhrase.HasLMScores())
+	{ // computed when the target phrase was scored. Only copy them
+		retFullScore = targetPhrase.GetLMScore();
+		ngramScore = targetPhrase.GetNGramScore();
+		LMList::const_iterator lmIter;
+		for (lmIter = allLM.begin(); lmIter != allLM.end(); ++lmIter)
+		{
+			const LanguageModel *lm = *lmIter;
+			if (lm->Useable(targetPhrase))
+				m_scoreBreakdown.Assign(lm, targetPhrase.GetScoreBreakdown().GetScoreForProducer(lm));
+		}
+	}
+	else
+	{
+		allLM.CalcScore(targetPhrase, retFullScore, ngramScore, &m_scoreBreakdown);
+	}
 
 	size_t phraseSize = GetTargetPhrase().GetSize();
 	// future score
@@ -32,11 +32,46 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "DecodeStepTranslation.h"
 #include "DecodeGraph.h"
+#include "Thread.h"
 
 using namespace std;
 
 namespace Moses
 {
+#ifdef WITH_THREADS
+namespace
+{
+/** creates the translation options of all spans starting at 1 position, with each decoding graph in turn.
+ * Each task only adds to the lists of its start position, so the options in each list
+ * are in the same order as when they're created on 1 thread
+ */
+class CreateOptionsTask : public ThreadPool::Task
+{
+protected:
+	TranslationOptionCollection &m_toc;
+	const vector <DecodeGraph*> &m_decodeStepVL;
+	size_t m_startPos, m_maxSize;
+public:
+	CreateOptionsTask(TranslationOptionCollection &toc, const vector <DecodeGraph*> &decodeStepVL
+									, size_t startPos, size_t maxSize)
+	:m_toc(toc)
+	,m_decodeStepVL(decodeStepVL)
+	,m_startPos(startPos)
+	,m_maxSize(maxSize)
+	{}
+	void Run()
+	{
+		for (size_t startVL = 0 ; startVL < m_decodeStepVL.size() ; startVL++)
+		{
+			PhraseDictionaryCursor cursor;
+			for (size_t endPos = m_startPos ; endPos < m_startPos + m_maxSize ; endPos++)
+				m_toc.CreateTranslationOptionsForRange(*m_decodeStepVL[startVL], m_startPos, endPos, true, &cursor);
+		}
+	}
+};
+}
+#endif
+
 /** helper for pruning */
 bool CompareTranslationOption(const TranslationOption *a, const TranslationOption *b)
 {
@@ -382,6 +417,21 @@ void TranslationOptionCollection::CreateTranslationOptions(const vector <DecodeG
 	// for all phrases
 
 	size_t size = m_source.GetSize();
+#ifdef WITH_THREADS
+	ThreadPool *threadPool = StaticData::Instance().GetOptionThreadPool();
+	if (threadPool != NULL && size > 1)
+	{
+		vector<ThreadPool::Task*> tasks;
+		for (size_t startPos = 0 ; startPos < size; startPos++)
+		{
+			size_t maxSize = std::min(size - startPos, StaticData::Instance().GetMaxPhraseLength());
+			tasks.push_back(new CreateOptionsTask(*this, decodeStepVL, startPos, maxSize));
+		}
+		threadPool->Run(tasks);
+		RemoveAllInColl(tasks);
+	}
+	else
+#endif
 	for (size_t startVL = 0 ; startVL < decodeStepVL.size() ; startVL++)
 	{
 	  const DecodeGraph &decodeStepList = *decodeStepVL[startVL];
@@ -391,9 +441,11 @@ void TranslationOptionCollection::CreateTranslationOptions(const vector <DecodeG
       size_t maxSizePhrase = StaticData::Instance().GetMaxPhraseLength();
       maxSize = std::min(maxSize, maxSizePhrase);
 
+			// each span is looked up by extending the lookup of the span 1 word shorter
+			PhraseDictionaryCursor cursor;
 			for (size_t endPos = startPos ; endPos < startPos + maxSize ; endPos++)
 			{
-				CreateTranslationOptionsForRange( decodeStepList, startPos, endPos, true);
+				CreateTranslationOptionsForRange( decodeStepList, startPos, endPos, true, &cursor);
  			}
 		}
 	}
@@ -412,6 +464,10 @@ void TranslationOptionCollection::CreateTranslationOptions(const vector <DecodeG
 
 	// Cached lex reodering costs
 	CacheLexReordering();
+
+	// not while the options are created, lists found in the cache are still being copied
+	if (StaticData::Instance().GetUseTransOptCache())
+		StaticData::Instance().ReduceTransOptCache();
 }
 
 void TranslationOptionCollection::Sort()
@@ -439,12 +495,14 @@ void TranslationOptionCollection::Sort()
  * \param startPos first position in input sentence
  * \param lastPos last position in input sentence
  * \param adhereTableLimit whether phrase & generation table limits are adhered to
+ * \param cursor lookup of the shorter spans from startPos in the phrase table of the first decoding step, or NULL
  */
 void TranslationOptionCollection::CreateTranslationOptionsForRange(
 																													 const DecodeGraph &decodeGraph
 																													 , size_t startPos
 																													 , size_t endPos
-																													 , bool adhereTableLimit)
+																													 , bool adhereTableLimit
+																													 , PhraseDictionaryCursor *cursor)
 {
 	if ((StaticData::Instance().GetXmlInputType() != XmlExclusive) || !HasXmlOptionsOverlappingRange(startPos,endPos))
 	{
@@ -483,7 +541,7 @@ void TranslationOptionCollection::CreateTranslationOptionsForRange(
 
 			static_cast<const DecodeStepTranslation&>(decodeStep).ProcessInitialTranslation
 																(m_source, *oldPtoc
-																, startPos, endPos, adhereTableLimit );
+																, startPos, endPos, adhereTableLimit, cursor );
 
 			// do rest of decode steps
 			int indexStep = 0;
@@ -618,9 +676,30 @@ void TranslationOptionCollection::CacheLexReordering()
 	std::vector<LexicalReordering*>::const_iterator iterLexreordering;
 
 	size_t size = m_source.GetSize();
+	if (lexReorderingModels.empty())
+		return;
+
+	// source phrases of all options, so that the tables can read ahead what they will be asked for
+	std::vector<const Phrase*> sourcePhrases;
+	for (size_t startPos = 0 ; startPos < size ; startPos++)
+	{
+		size_t maxSize = std::min(size - startPos, StaticData::Instance().GetMaxPhraseLength());
+		for (size_t endPos = startPos ; endPos < startPos + maxSize; endPos++)
+		{
+			const TranslationOptionList &transOptList = GetTranslationOptionList(startPos, endPos);
+			TranslationOptionList::const_iterator iterTransOpt;
+			for (iterTransOpt = transOptList.begin() ; iterTransOpt != transOptList.end() ; ++iterTransOpt)
+			{
+				if ((*iterTransOpt)->GetSourcePhrase())
+					sourcePhrases.push_back((*iterTransOpt)->GetSourcePhrase());
+			}
+		}
+	}
+
 	for (iterLexreordering = lexReorderingModels.begin() ; iterLexreordering != lexReorderingModels.end() ; ++iterLexreordering)
 	{
 		LexicalReordering &lexreordering = **iterLexreordering;
+		lexreordering.Prefetch(sourcePhrases);
 
 		for (size_t startPos = 0 ; startPos < size ; startPos++)
 		{
@@ -637,7 +716,13 @@ void TranslationOptionCollection::CacheLexReordering()
 					TranslationOption &transOpt = **iterTransOpt;
 					//Phrase sourcePhrase =  m_source.GetSubString(WordsRange(startPos,endPos));
 					const Phrase *sourcePhrase = transOpt.GetSourcePhrase();
-					if (sourcePhrase)
+					if (lexreordering.IsMergedIntoPhraseTable())
+					{
+						const Score &score = transOpt.GetTargetPhrase().GetReorderingScores();
+						if (!score.empty())
+							transOpt.CacheReorderingProb(lexreordering, score);
+					}
+					else if (sourcePhrase)
 					{
 						Score score = lexreordering.GetProb(*sourcePhrase
 															, transOpt.GetTargetPhrase());
@@ -36,6 +36,7 @@ class LanguageModel;
 class FactorCollection;
 class PhraseDictionaryMemory;
 class GenerationDictionary;
+struct PhraseDictionaryCursor;
 class InputType;
 class LMList;
 class FactorMask;
@@ -119,11 +120,14 @@ public:
 
 	//! Create all possible translations from the phrase tables
 	virtual void CreateTranslationOptions(const std::vector <DecodeGraph*> &decodeStepVL);
-	//! Create translation options that exactly cover a specific input span. 
+	/** Create translation options that exactly cover a specific input span. 
+	 * \param cursor lookup of the shorter spans with the same start in the phrase table of the first decoding step, or NULL
+	 */
 	virtual void CreateTranslationOptionsForRange(const DecodeGraph &decodeStepList
 																			, size_t startPosition
 																			, size_t endPosition
-																			, bool adhereTableLimit);
+																			, bool adhereTableLimit
+																			, PhraseDictionaryCursor *cursor = NULL);
 																			
 	//!Check if this range has XML options
 	virtual bool HasXmlOptionsOverlappingRange(size_t startPosition, size_t endPosition) const;
@@ -48,6 +48,10 @@ const size_t DEFAULT_CUBE_PRUNING_POP_LIMIT = 1000;
 const size_t DEFAULT_CUBE_PRUNING_DIVERSITY = 0;
 const size_t DEFAULT_MAX_HYPOSTACK_SIZE = 200;
 const size_t DEFAULT_MAX_TRANS_OPT_CACHE_SIZE = 10000;
+const size_t DEFAULT_LM_CACHE_SIZE = 65536;
+const size_t DEFAULT_LOAD_THREADS = 1;
+const size_t DEFAULT_OPTION_THREADS = 1;
+const size_t DEFAULT_BLOOM_FILTER_BITS = 0;
 const size_t DEFAULT_MAX_TRANS_OPT_SIZE	= 50;
 const size_t DEFAULT_MAX_PART_TRANS_OPT_SIZE = 10000;
 const size_t DEFAULT_MAX_PHRASE_LENGTH = 20;
@@ -56,6 +60,7 @@ const float LOWEST_SCORE							= -100.0f;
 const float DEFAULT_BEAM_WIDTH				= 0.00001f;
 const float DEFAULT_EARLY_DISCARDING_THRESHOLD		= 0.0f;
 const float DEFAULT_TRANSLATION_OPTION_THRESHOLD	= 0.0f;
+const float DEFAULT_CONFUSION_NET_PATH_THRESHOLD	= 0.0f;
 const size_t DEFAULT_VERBOSE_LEVEL = 1;
 
 /////////////////////////////////////////////////
@@ -180,7 +185,10 @@ typedef size_t FactorType;
 #include <BaseTsd.h>
 #else
 #include <stdint.h>
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
 typedef uint32_t UINT32;
+typedef uint64_t UINT64;
 #endif
 
 typedef std::vector<float> Scores;
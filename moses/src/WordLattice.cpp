@@ -2,7 +2,6 @@
 #include "WordLattice.h"
 #include "PCNTools.h"
 #include "Util.h"
-#include "FloydWarshall.h"
 
 namespace Moses
 {
@@ -86,15 +85,18 @@ int WordLattice::Read(std::istream& in,const std::vector<FactorType>& factorOrde
 		}
 	}
 	if (!cn.empty()) {
-		std::vector<std::vector<bool> > edges(0);
-		this->GetAsEdgeMatrix(edges);
-		floyd_warshall(edges,distances);
+		distances.Init(data.size()+1);
+		for (size_t i=0;i<data.size();++i) {
+			for (size_t j=0;j<data[i].size(); ++j) {
+				distances.AddEdge(i, i+next_nodes[i][j]);
+			}
+		}
 
 		IFVERBOSE(2) {
 			TRACE_ERR("Shortest paths:\n");
-			for (size_t i=0; i<edges.size(); ++i) {
-				for (size_t j=0; j<edges.size(); ++j) {
-					int d = distances[i][j];
+			for (size_t i=0; i<distances.GetNumNodes(); ++i) {
+				for (size_t j=0; j<distances.GetNumNodes(); ++j) {
+					int d = distances.GetDistance(i,j);
 					if (d > 99999) { d=-1; }
 					TRACE_ERR("\t" << d);
 				}
@@ -121,15 +123,15 @@ int WordLattice::ComputeDistortionDistance(const WordsRange& prev, const WordsRa
 #if 1
 	int result;
 	if (prev.GetStartPos() == NOT_FOUND) {
-		//TRACE_ERR("returning initial distance from 0 to " << (current.GetStartPos()+1) << " which is " << (distances[0][current.GetStartPos()+1] - 1) <<"\n");
-		result = distances[0][current.GetStartPos()+1] - 1;
+		//TRACE_ERR("returning initial distance from 0 to " << (current.GetStartPos()+1) << " which is " << (distances.GetDistance(0, current.GetStartPos()+1) - 1) <<"\n");
+		result = distances.GetDistance(0, current.GetStartPos()+1) - 1;
 		if (result < 0 || result > 99999) {
 			TRACE_ERR("prev: " << prev << "\n current: " << current << "\n");
 			TRACE_ERR("A: got a weird distance from 0 to " << (current.GetStartPos()+1) << " of " << result << "\n");
 		}
 	} else if (prev.GetEndPos() > current.GetStartPos()) {
-		//TRACE_ERR("returning forward distance from "<< current.GetStartPos() << " to " << (prev.GetEndPos()+1) << " which is " << distances[current.GetStartPos()][prev.GetEndPos()+1] <<"\n");
-		result = distances[current.GetStartPos()][prev.GetEndPos()+1];
+		//TRACE_ERR("returning forward distance from "<< current.GetStartPos() << " to " << (prev.GetEndPos()+1) << " which is " << distances.GetDistance(current.GetStartPos(), prev.GetEndPos()+1) <<"\n");
+		result = distances.GetDistance(current.GetStartPos(), prev.GetEndPos()+1);
 		if (result < 0 || result > 99999) {
 			TRACE_ERR("prev: " << prev << "\n current: " << current << "\n");
 
@@ -138,8 +140,8 @@ int WordLattice::ComputeDistortionDistance(const WordsRange& prev, const WordsRa
 	} else if (prev.GetEndPos()+1 == current.GetStartPos()) {
 		return 0;
 	} else {
-		//TRACE_ERR("returning reverse distance from "<< (prev.GetEndPos()+1) << " to " << (current.GetStartPos()+1) << " which is " << (distances[prev.GetEndPos()+1][current.GetStartPos()+1] - 1) <<"\n");
-		result = distances[prev.GetEndPos() + 1][current.GetStartPos()] - 1;
+		//TRACE_ERR("returning reverse distance from "<< (prev.GetEndPos()+1) << " to " << (current.GetStartPos()+1) << " which is " << (distances.GetDistance(prev.GetEndPos()+1, current.GetStartPos()+1) - 1) <<"\n");
+		result = distances.GetDistance(prev.GetEndPos() + 1, current.GetStartPos()) - 1;
 		if (result < 0 || result > 99999) {
 			TRACE_ERR("prev: " << prev << "\n current: " << current << "\n");
 
@@ -160,8 +162,8 @@ int WordLattice::ComputeDistortionDistance(const WordsRange& prev, const WordsRa
 
 bool WordLattice::CanIGetFromAToB(size_t start, size_t end) const
 {
-	//  std::cerr << "CanIgetFromAToB(" << start << "," << end << ")=" << distances[start][end] << std::endl;
-	return distances[start][end] < 100000;
+	//  std::cerr << "CanIgetFromAToB(" << start << "," << end << ")=" << distances.GetDistance(start, end) << std::endl;
+	return distances.GetDistance(start, end) < 100000;
 }
 
 
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "ConfusionNet.h"
+#include "LatticeDistances.h"
 
 namespace Moses
 {
@@ -11,7 +12,7 @@ namespace Moses
 class WordLattice: public ConfusionNet {
 private:
 	std::vector<std::vector<size_t> > next_nodes;
-	std::vector<std::vector<int> > distances;
+	LatticeDistances distances; //! computed when the search asks for them
 		 
 public:
 	WordLattice();
@@ -130,6 +130,34 @@ inline vector<string> TokenizeXml(const string& str)
 	return tokens;
 }
 
+/**
+ * Remove the xml markup from a sentence, leaving the words as ProcessAndStripXMLTags() does.
+ * Doesn't create translation options, so it can be used before the models are loaded
+ *
+ * \param line in: sentence, out: sentence without the xml
+ */
+void StripXMLTags(string &line)
+{
+	if (line.find_first_of('<') == string::npos) { return; }
+
+	vector<string> xmlTokens = TokenizeXml(line);
+	string cleanLine;
+	for (size_t xmlTokenPos = 0 ; xmlTokenPos < xmlTokens.size() ; xmlTokenPos++)
+	{
+		if (isXmlTag(xmlTokens[xmlTokenPos]))
+			continue;
+		// add a space at boundary, if necessary
+		if (cleanLine.size()>0 &&
+				cleanLine[cleanLine.size() - 1] != ' ' &&
+				xmlTokens[xmlTokenPos][0] != ' ')
+		{
+			cleanLine += " ";
+		}
+		cleanLine += xmlTokens[xmlTokenPos];
+	}
+	line = cleanLine;
+}
+
 /**
  * Process a sentence with xml annotation
  * Xml tags may specifiy additional/replacing translation options
@@ -24,6 +24,8 @@ struct XmlOption {
 };
 
 bool ProcessAndStripXMLTags(std::string &line,std::vector<std::vector<XmlOption*> > &res, ReorderingConstraint &reorderingConstraint, std::vector< size_t > &walls );
+//! only remove the markup from line, eg. to read the words of the input before the models are loaded
+void StripXMLTags(std::string &line);
 
 }
 
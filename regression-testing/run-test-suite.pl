@@ -10,6 +10,7 @@ use Getopt::Long;
 my @tests = qw (
   basic-surface-only
   ptable-filtering
+  xml-markup-filter-input
   multi-factor
   multi-factor-drop
   confusionNet-surface-only